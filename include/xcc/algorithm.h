@@ -58,6 +58,18 @@ typedef xcc_link (*xcc_choose_i)(xcc_algorithm* a, xcc_problem* p);
 
 typedef void (*xcc_userdata_free)(xcc_algorithm* a, xcc_problem* p);
 
+// Heuristics that the search kernels of X, C and M can inline. Every other
+// choose_i is CUSTOM and called through the function pointer.
+typedef enum xcc_heuristic {
+  XCC_HEURISTIC_CUSTOM,
+  XCC_HEURISTIC_NAIVE,
+  XCC_HEURISTIC_MRV,
+  XCC_HEURISTIC_MRV_SLACKER
+} xcc_heuristic;
+
+xcc_heuristic
+xcc_heuristic_of(xcc_choose_i choose_i);
+
 xcc_link
 xcc_choose_i_naively(xcc_algorithm* a, xcc_problem* p);
 
@@ -67,6 +79,36 @@ xcc_choose_i_mrv(xcc_algorithm* a, xcc_problem* p);
 xcc_link
 xcc_choose_i_mrv_slacker(xcc_algorithm* a, xcc_problem* p);
 
+// MRV weighted by conflicts, in the style of dom/wdeg: Items with at most one
+// option left come first, the others are ranked by their number of options
+// (or branches in M) divided by their weight. Whenever an item without any
+// option is found, its weight is bumped.
+xcc_link
+xcc_choose_i_weighted(xcc_algorithm* a, xcc_problem* p);
+
+// Factor by which the weights of xcc_choose_i_weighted decay per bump.
+#ifndef XCC_WEIGHT_DECAY
+#define XCC_WEIGHT_DECAY 0.95
+#endif
+
+// While at least this many primary items are active, the MRV kernels of X
+// and C keep them in buckets by LEN instead of scanning all of them at every
+// node. Below half of it, scanning is cheaper than updating the buckets.
+#ifndef XCC_MRV_BUCKET_ITEMS
+#define XCC_MRV_BUCKET_ITEMS 512
+#endif
+
+// Allocates the MRV buckets. Must be called at the root of the search, where
+// every item has its largest LEN.
+void
+xcc_mrv_buckets_allocate(xcc_problem* p);
+
+// Puts the active primary items into the allocated buckets and sets
+// p->buckets. From then on, cover, hide and their inverses given true keep
+// the buckets up to date.
+void
+xcc_mrv_buckets_init(xcc_problem* p);
+
 typedef struct xcc_algorithm {
   xcc_define_primary_item define_primary_item;
   xcc_define_primary_item_with_range define_primary_item_with_range;
@@ -95,10 +137,24 @@ xcc_default_init_problem(xcc_algorithm* a, xcc_problem* p);
 bool
 xcc_algorithm_from_select(int algorithm_select, xcc_algorithm* algorithm);
 
+// Problems with few items are solved faster with bitsets than with dancing
+// links. If algorithm_select is X or C with MRV and without
+// XCC_ALGORITHM_NO_BITSET, this switches algorithm to the bitset engine when p
+// is small and dense enough, and otherwise lets X and C finish deep subtrees
+// with bitsets. Call it after parsing and before searching, and only for plain
+// searches: the bitset engine knows nothing of the other fields of p, like
+// lds, nogoods, costs or the order of the options.
+void
+xcc_algorithm_use_bitsets(int algorithm_select,
+                          xcc_algorithm* algorithm,
+                          xcc_problem* p);
+
 xcc_algorithm* xcc_algorithm_allocate();
 xcc_algorithm* xcc_algorithm_x_allocate();
 xcc_algorithm* xcc_algorithm_c_allocate();
 xcc_algorithm* xcc_algorithm_m_allocate();
+xcc_algorithm* xcc_algorithm_dc_allocate();
+xcc_algorithm* xcc_algorithm_bitset_allocate();
 
 #ifdef __cplusplus
 }
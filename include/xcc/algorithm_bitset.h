@@ -0,0 +1,82 @@
+/*
+    XCCSolve - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef XCC_ALGORITHM_BITSET_H
+#define XCC_ALGORITHM_BITSET_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "xcc.h"
+
+typedef struct xcc_algorithm xcc_algorithm;
+
+// Maximum number of items (primary and secondary) the bitset engine accepts.
+#define XCC_BITSET_MAX_ITEMS 256
+
+// Algorithms X and C switch to bitsets once at most this many primary items are
+// left.
+#ifndef XCC_BITSET_TAIL_ITEMS
+#define XCC_BITSET_TAIL_ITEMS 128
+#endif
+
+// Bitsets are only used if the columns of the primary items contain at least
+// this many nodes per word of an option bitmap on average.
+#ifndef XCC_BITSET_MIN_DENSITY
+#define XCC_BITSET_MIN_DENSITY 2
+#endif
+
+typedef enum xcc_bitset_result {
+  XCC_BITSET_SOLUTION,
+  XCC_BITSET_INTERRUPTED,
+  XCC_BITSET_DONE
+} xcc_bitset_result;
+
+// Solves XCC problems with bitsets over options instead of dancing links. The
+// items are read from the parsed xcc_problem, so all the other functions stay
+// the standard ones. Always uses MRV.
+void
+xcc_algorithm_bitset_set(xcc_algorithm* a);
+
+// Whether the bitset engine can solve p, and is expected to be faster than
+// dancing links. If with_colors is false, the problem must also not contain any
+// colors, which the bitset engine would respect but Algorithm X would not.
+bool
+xcc_algorithm_bitset_supports(xcc_problem* p, bool with_colors);
+
+// Builds a bitset problem from the active items and the live options of the
+// DLX matrix, to finish the search below the current level p->l. Returns false
+// if the remaining problem is too sparse for bitsets. Uses
+// p->algorithm_userdata, which must be freed with xcc_bitset_free_userdata.
+bool
+xcc_bitset_tail_start(xcc_problem* p, bool with_colors);
+
+// Continues the search started by xcc_bitset_tail_start. Solutions are
+// written to p->x after the levels before the start, including p->l. Once
+// done, p->l is the level of the start again.
+xcc_bitset_result
+xcc_bitset_tail_next(xcc_problem* p);
+
+void
+xcc_bitset_free_userdata(xcc_algorithm* a, xcc_problem* p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
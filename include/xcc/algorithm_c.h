@@ -27,6 +27,11 @@ typedef struct xcc_algorithm xcc_algorithm;
 void
 xcc_algorithm_c_set(xcc_algorithm* a);
 
+// Replace the generic search kernel by the one compiled for a->choose_i, if
+// there is one.
+void
+xcc_algorithm_c_specialize(xcc_algorithm* a);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,78 @@
+/*
+    XCCSolve - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef XCC_ASSUME_H
+#define XCC_ASSUME_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "xcc.h"
+
+struct xcc_algorithm;
+
+// Options that every solution has to contain (forced) or must not contain
+// (excluded), given by their index as in xcc_extract_solution_option_indices,
+// and items that no option of a solution may contain. Excluding an item
+// excludes all of its options.
+typedef struct xcc_assumptions {
+  const xcc_link* forced;
+  size_t forced_count;
+  const xcc_link* excluded;
+  size_t excluded_count;
+  const xcc_link* excluded_items;
+  size_t excluded_item_count;
+} xcc_assumptions;
+
+// Called for every solution found under assumptions. The options chosen by
+// the search are in p->x up to p->l like for compute_next_result, the forced
+// options complete them. Returning false stops the search.
+typedef bool (*xcc_solution_visitor)(xcc_problem* p, void* userdata);
+
+// Searches p with Algorithm X, C or M (algorithm is XCC_ALGORITHM_X, C or M
+// and a must be set up for it, without bitsets) for solutions under the given
+// assumptions, stopping after max_solutions of them unless it is 0, e.g.
+// after 2 to check that a solution is unique. The number of solutions found
+// is stored in solutions, and visit (if not NULL) is called for each.
+//
+// The assumptions are applied at the root of the search like selecting and
+// excluding options during the search, with cover, hide and purify, and
+// undone afterwards, so p can be asked the next question right away without
+// parsing it again. p must be at the root of the search and must not use
+// lds, restarts, a node limit, nogoods or costs. Contradicting assumptions,
+// like forcing two options with the same primary item, have no solutions.
+// Forcing an option more than once is the same as forcing it once.
+// Returns an error for option or item indices out of range.
+const char*
+xcc_solve_with_assumptions(struct xcc_algorithm* a,
+                           xcc_problem* p,
+                           int algorithm,
+                           const xcc_assumptions* as,
+                           size_t max_solutions,
+                           xcc_solution_visitor visit,
+                           void* userdata,
+                           size_t* solutions);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,67 @@
+/*
+    XCCSolve - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef XCC_BACKBONE_H
+#define XCC_BACKBONE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "xcc.h"
+
+struct xcc_algorithm;
+
+typedef enum xcc_backbone_class {
+  XCC_BACKBONE_NONE,
+  XCC_BACKBONE_SOME,
+  XCC_BACKBONE_ALL
+} xcc_backbone_class;
+
+typedef struct xcc_backbone_stats {
+  // Searches under assumptions, and options that were decided by the
+  // solutions they found before it was their turn.
+  size_t queries;
+  size_t reused;
+} xcc_backbone_stats;
+
+// Classifies every option of p by whether it is in every solution, in some
+// or in none, and stores that in classes (indexed by option index, with
+// p->option_count + 1 entries). The first solution marks its options as
+// candidates for being in every solution, and every solution found later
+// marks its options as seen and takes the candidacy of all others. Only the
+// options that are still open when it is their turn are searched with
+// xcc_solve_with_assumptions: unseen ones forced, candidates excluded, each
+// until the first solution. With threads > 1, the options are split among
+// that many threads, each with its own copy of p. See
+// xcc_solve_with_assumptions for the requirements on a, p and algorithm.
+const char*
+xcc_backbone(struct xcc_algorithm* a,
+             xcc_problem* p,
+             int algorithm,
+             int threads,
+             uint8_t* classes,
+             xcc_backbone_stats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
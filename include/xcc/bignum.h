@@ -0,0 +1,79 @@
+/*
+    XCCSolve - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef XCC_BIGNUM_H
+#define XCC_BIGNUM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Unsigned arbitrary-precision integer, used for solution counts. Limbs are
+// stored least significant first, without leading zero limbs, so zero has no
+// limbs at all.
+typedef struct xcc_bignum {
+  uint32_t* limbs;
+  size_t size;
+  size_t capacity;
+} xcc_bignum;
+
+void
+xcc_bignum_init(xcc_bignum* n);
+
+void
+xcc_bignum_free(xcc_bignum* n);
+
+void
+xcc_bignum_set_u64(xcc_bignum* n, uint64_t v);
+
+void
+xcc_bignum_set(xcc_bignum* n, const xcc_bignum* v);
+
+static inline bool
+xcc_bignum_is_zero(const xcc_bignum* n) {
+  return n->size == 0;
+}
+
+// n += v
+void
+xcc_bignum_add(xcc_bignum* n, const xcc_bignum* v);
+
+// n -= v, requires n >= v.
+void
+xcc_bignum_sub(xcc_bignum* n, const xcc_bignum* v);
+
+// r = a * b. r must not be a or b.
+void
+xcc_bignum_mul(xcc_bignum* r, const xcc_bignum* a, const xcc_bignum* b);
+
+// Returns -1, 0 or 1.
+int
+xcc_bignum_cmp(const xcc_bignum* a, const xcc_bignum* b);
+
+// Returns the decimal representation, which has to be freed by the caller.
+char*
+xcc_bignum_to_string(const xcc_bignum* n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
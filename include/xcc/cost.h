@@ -0,0 +1,123 @@
+/*
+    XCCSolve - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef XCC_COST_H
+#define XCC_COST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "xcc.h"
+
+// One of the cheapest solutions, as the nodes in x that select its options.
+typedef struct xcc_cost_solution {
+  int64_t cost;
+  xcc_link* x;
+  xcc_link l;
+  // Number of the solution in the order it was found, breaks ties in cost.
+  size_t found;
+} xcc_cost_solution;
+
+// The state of a search for the k cheapest solutions with Algorithms X and C,
+// where every option has a non-negative cost (given with $ in the input).
+// The kernels add the cost of every option they select to sum and skip an
+// option once sum, its cost and a lower bound for covering the remaining
+// items reach bound. The lower bound gives every option an even share of its
+// cost per primary item, rounded down, charges every primary item the
+// smallest share of all of its options, and sums that over the active primary
+// items. Options are tried in the order of increasing cost, so once the cost
+// of an option alone reaches the bound, all remaining options of the item do
+// too, like in Knuth's Algorithm X$.
+typedef struct xcc_costs {
+  // Cost of the option of every node and the summed charges of the primary
+  // items of that option, indexed by node.
+  int64_t* option;
+  int64_t* share;
+
+  // Cost of the selected options, the summed charges of the active primary
+  // items and the cost that a solution has to stay below.
+  int64_t sum;
+  int64_t rest;
+  int64_t bound;
+  size_t pruned;
+
+  // The cheapest solutions found so far, a max-heap by cost while the search
+  // runs and sorted by cost afterwards.
+  xcc_cost_solution* best;
+  size_t best_count;
+  size_t k;
+  size_t found;
+} xcc_costs;
+
+// Prepares the search for the k cheapest solutions of p, which must be at the
+// root of the search. Sorts the options of every item by cost, see
+// xcc_order_options. Does not work together with the nogood cache, which
+// would keep sub-problems that were only cut off by the bound.
+xcc_costs*
+xcc_costs_create(xcc_problem* p, size_t k);
+
+void
+xcc_costs_free(xcc_costs* c);
+
+// Searches p (with p->costs set) for its k cheapest solutions with Algorithm
+// X or C without the bitset tail. Returns true if there is a solution. The
+// solutions are then in p->costs->best, cheapest first, and
+// xcc_costs_restore puts one of them into x.
+bool
+xcc_search_cheapest(xcc_algorithm* a, xcc_problem* p);
+
+// Makes the n-th cheapest solution the current solution of p, so that it can
+// be printed or extracted like any other. Ends the search.
+void
+xcc_costs_restore(xcc_problem* p, size_t n);
+
+// Whether selecting the option of node x cannot lead to a solution below the
+// bound.
+static inline bool
+xcc_costs_exceed(const xcc_costs* c, xcc_link x) {
+  return c->sum + c->option[x] + c->rest - c->share[x] >= c->bound;
+}
+
+// Whether no option of the item of node x from x on can lead to a solution
+// below the bound, as they cost at least as much as x.
+static inline bool
+xcc_costs_exhausted(const xcc_costs* c, xcc_link x) {
+  return c->sum + c->option[x] >= c->bound;
+}
+
+// The option of node x was selected, or deselected if undo is set.
+static inline void
+xcc_costs_select(xcc_costs* c, xcc_link x, bool undo) {
+  if(undo) {
+    c->sum -= c->option[x];
+    c->rest += c->share[x];
+  } else {
+    c->sum += c->option[x];
+    c->rest -= c->share[x];
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
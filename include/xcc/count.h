@@ -0,0 +1,76 @@
+/*
+    XCCSolve - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef XCC_COUNT_H
+#define XCC_COUNT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+#include "bignum.h"
+
+struct xcc_problem;
+
+// Default memory budget of the sub-problem cache in megabytes.
+#ifndef XCC_COUNT_DEFAULT_CACHE_MB
+#define XCC_COUNT_DEFAULT_CACHE_MB 256
+#endif
+
+// Number of cache entries a sub-problem may be stored in.
+#ifndef XCC_COUNT_WAYS
+#define XCC_COUNT_WAYS 4
+#endif
+
+typedef struct xcc_count_stats {
+  size_t hits;
+  size_t stores;
+  size_t evictions;
+  size_t entries;
+  // Sub-problems that fell apart, and the components they had in total.
+  size_t splits;
+  size_t components;
+} xcc_count_stats;
+
+// Counts all solutions of p without enumerating them. The search uses the
+// dancing links of Algorithm X with MRV and caches the count of every
+// sub-problem under its set of active items, so a cache hit skips the whole
+// subtree. The cache stays within about cache_bytes: it is set-associative and
+// replaces the entry that took the fewest search nodes to compute.
+//
+// In the first component_depth levels of the search, the sub-problem is split
+// into the components of the graph of its active items and options, which
+// are counted separately and multiplied. Components are cached by their own
+// items. Finding them costs a pass over the active options, so deep levels,
+// where sub-problems rarely fall apart, are left out. 0 never splits.
+//
+// Like xcc_zdd_build, only exact cover without colors and multiplicities is
+// supported. Search nodes are counted in p->nodes, stats may be NULL.
+const char*
+xcc_count_solutions_memoized(struct xcc_problem* p,
+                             size_t cache_bytes,
+                             size_t component_depth,
+                             xcc_bignum* count,
+                             xcc_count_stats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
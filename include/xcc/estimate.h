@@ -0,0 +1,71 @@
+/*
+    XCCSolve - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef XCC_ESTIMATE_H
+#define XCC_ESTIMATE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "xcc.h"
+
+struct xcc_algorithm;
+
+// The mean of the estimates of all probes and half the width of its 95%
+// confidence interval, from the normal approximation.
+typedef struct xcc_estimate_value {
+  double mean;
+  double error;
+} xcc_estimate_value;
+
+// Estimates of the size of a complete search for all solutions, counted like
+// the kernels do: nodes are the branches, without forced moves, and mems are
+// the memory accesses of covering, hiding and tweaking and of their undoing
+// (see ops.h), not those of choosing items.
+typedef struct xcc_estimate {
+  size_t probes;
+  xcc_estimate_value nodes;
+  xcc_estimate_value mems;
+  xcc_estimate_value solutions;
+} xcc_estimate;
+
+// Estimates the search tree of Algorithm X, C or M (given by algorithm, one
+// of XCC_ALGORITHM_X, XCC_ALGORITHM_C and XCC_ALGORITHM_M) like Knuth's
+// Monte Carlo estimates of backtrack programs: every probe walks from the
+// root to a leaf, choosing items with a->choose_i and taking one of the d
+// branches of every node uniformly at random. Weighting each node with the
+// product of the d above it gives unbiased estimates of the whole tree. p
+// must be at the root of the search and is restored afterwards. The random
+// numbers are seeded by seed. Does not use the bitset tail, MRV buckets or
+// any of the search controls of xcc_problem.
+void
+xcc_estimate_search(struct xcc_algorithm* a,
+                    xcc_problem* p,
+                    int algorithm,
+                    size_t probes,
+                    uint64_t seed,
+                    xcc_estimate* e);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,136 @@
+/*
+    XCCSolve - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef XCC_NOGOOD_H
+#define XCC_NOGOOD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "signature.h"
+#include "xcc.h"
+
+// Number of cache entries a failed sub-problem may be stored in.
+#ifndef XCC_NOGOOD_WAYS
+#define XCC_NOGOOD_WAYS 4
+#endif
+
+typedef struct xcc_nogood_stats {
+  size_t lookups;
+  size_t hits;
+  size_t stores;
+  size_t evictions;
+  size_t entries;
+} xcc_nogood_stats;
+
+typedef struct xcc_nogood_entry {
+  uint64_t hash;
+  // Search nodes it took to exhaust the sub-problem, 0 for empty entries.
+  size_t work;
+} xcc_nogood_entry;
+
+// A cache of the sub-problems that Algorithms X and C searched completely
+// without finding a solution. A sub-problem is keyed by its set of active
+// items and, for problems with colors, by the colors its secondary items were
+// purified with. The kernels keep the key up to date while they cover and
+// commit, look the sub-problem up before they choose an item, and store it
+// when they backtrack from its level without a solution below it. The cache
+// is set-associative like the one of xcc_count_solutions_memoized and
+// replaces the entry that took the fewest search nodes.
+typedef struct xcc_nogoods {
+  xcc_signature sig;
+  // Colors of the secondary items N_1 + 1 to N, 0 while not purified, and the
+  // number of key words they take after the active items. NULL without colors.
+  xcc_color* color;
+  size_t color_words;
+  size_t key_words;
+
+  xcc_nogood_entry* entries;
+  uint64_t* keys;
+  size_t buckets;
+  size_t max_buckets;
+
+  // Solutions found so far, and the solutions and nodes when every level of
+  // the search was entered.
+  size_t solutions;
+  size_t* level_solutions;
+  size_t* level_nodes;
+
+  xcc_link N_1;
+  xcc_nogood_stats stats;
+} xcc_nogoods;
+
+// Creates the cache for the current sub-problem of p, which must be at the
+// root of the search. It stays within about cache_bytes.
+xcc_nogoods*
+xcc_nogoods_create(const xcc_problem* p, size_t cache_bytes);
+
+void
+xcc_nogoods_free(xcc_nogoods* g);
+
+// Whether the current sub-problem is known to have no solution.
+bool
+xcc_nogoods_lookup(xcc_nogoods* g);
+
+// Stores the current sub-problem of level l, which the search just left, if
+// no solution was found since it was entered.
+void
+xcc_nogoods_leave(xcc_nogoods* g, int l, size_t nodes);
+
+static inline void
+xcc_nogoods_enter(xcc_nogoods* g, int l, size_t nodes) {
+  g->level_solutions[l] = g->solutions;
+  g->level_nodes[l] = nodes;
+}
+
+static inline uint64_t
+xcc_nogoods_color_hash(const xcc_nogoods* g, xcc_link i, xcc_color c) {
+  // splitmix64 of the item and its color
+  uint64_t z = g->sig.zobrist[i] + (uint64_t)c * 0x9e3779b97f4a7c15ull;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+// Item i was covered or uncovered.
+static inline void
+xcc_nogoods_toggle(xcc_nogoods* g, xcc_link i) {
+  xcc_signature_toggle(&g->sig, i);
+}
+
+// Item j of the node with color c was committed (see xcc_commit), or
+// uncommitted if undo is set.
+static inline void
+xcc_nogoods_commit(xcc_nogoods* g, xcc_link j, xcc_color c, bool undo) {
+  if(c == 0) {
+    xcc_signature_toggle(&g->sig, j);
+  } else if(c > 0) {
+    g->sig.hash ^= xcc_nogoods_color_hash(g, j, c);
+    g->color[j - g->N_1 - 1] = undo ? 0 : c;
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -25,46 +25,63 @@ extern "C" {
 #define NAME(n) p->name[n]
 #define LLINK(n) p->llink[n]
 #define RLINK(n) p->rlink[n]
-#define ULINK(n) p->ulink[n]
-#define DLINK(n) p->dlink[n]
-#define COLOR(n) p->color[n]
-#define LEN(n) p->len[n]
-#define TOP(n) p->top[n]
+#define ULINK(n) p->node[n].ulink
+#define DLINK(n) p->node[n].dlink
+#define COLOR(n) p->node[n].color
+#define LEN(n) p->node[n].len
+#define TOP(n) p->node[n].top
 #define FT(l) p->ft[l]
 #define SLACK(l) p->slack[l]
 #define BOUND(l) p->bound[l]
 
+#include "algorithm.h"
 #include "xcc.h"
 
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
 
-inline static void
-xcc_cover(xcc_problem*, xcc_link);
-inline static void
-xcc_uncover(xcc_problem*, xcc_link);
-inline static void
-xcc_hide(xcc_problem*, xcc_link);
-inline static void
-xcc_unhide(xcc_problem*, xcc_link);
+#define XCC_ALWAYS_INLINE inline __attribute__((always_inline))
+#define XCC_NOINLINE __attribute__((noinline))
+
+// Counts memory accesses ("mems") of the operations below in p->mems, one per
+// node that is visited and one per link or length that is written. Only code
+// that defines XCC_COUNT_MEMS before including this header counts them (see
+// estimate.c), the kernels are not slowed down.
+#ifdef XCC_COUNT_MEMS
+#define MEMS(N) (p->mems += (N))
+#else
+#define MEMS(N) ((void)0)
+#endif
 
-inline static void
-xcc_cover_prime(xcc_problem*, xcc_link);
-inline static void
-xcc_uncover_prime(xcc_problem*, xcc_link);
-inline static void
-xcc_hide_prime(xcc_problem*, xcc_link);
-inline static void
-xcc_unhide_prime(xcc_problem*, xcc_link);
-inline static void
-xcc_commit(xcc_problem* p, xcc_link p_, xcc_link j_);
-inline static void
-xcc_uncommit(xcc_problem* p, xcc_link p_, xcc_link j_);
-inline static void
-xcc_purify(xcc_problem* p, xcc_link p_);
-inline static void
-xcc_unpurify(xcc_problem* p, xcc_link p_);
+// The cover and hide operations take a constant that says whether the MRV
+// buckets are in use (see xcc_problem). Being inlined, the other case costs
+// nothing.
+static XCC_ALWAYS_INLINE void
+xcc_cover(xcc_problem*, xcc_link, bool);
+static XCC_ALWAYS_INLINE void
+xcc_uncover(xcc_problem*, xcc_link, bool);
+static XCC_ALWAYS_INLINE void
+xcc_hide(xcc_problem*, xcc_link, bool);
+static XCC_ALWAYS_INLINE void
+xcc_unhide(xcc_problem*, xcc_link, bool);
+
+static XCC_ALWAYS_INLINE void
+xcc_cover_prime(xcc_problem*, xcc_link, bool);
+static XCC_ALWAYS_INLINE void
+xcc_uncover_prime(xcc_problem*, xcc_link, bool);
+static XCC_ALWAYS_INLINE void
+xcc_hide_prime(xcc_problem*, xcc_link, bool);
+static XCC_ALWAYS_INLINE void
+xcc_unhide_prime(xcc_problem*, xcc_link, bool);
+static XCC_ALWAYS_INLINE void
+xcc_commit(xcc_problem* p, xcc_link p_, xcc_link j_, bool);
+static XCC_ALWAYS_INLINE void
+xcc_uncommit(xcc_problem* p, xcc_link p_, xcc_link j_, bool);
+static XCC_ALWAYS_INLINE void
+xcc_purify(xcc_problem* p, xcc_link p_, bool);
+static XCC_ALWAYS_INLINE void
+xcc_unpurify(xcc_problem* p, xcc_link p_, bool);
 
 inline static void
 xcc_tweak(xcc_problem* p, xcc_link x_, xcc_link p_);
@@ -75,20 +92,34 @@ xcc_tweak_prime(xcc_problem* p, xcc_link x_, xcc_link p_);
 inline static void
 xcc_untweak_prime(xcc_problem* p, xcc_link l);
 
-#define COVER(I) xcc_cover(p, I)
-#define UNCOVER(I) xcc_uncover(p, I)
-#define HIDE(P) xcc_hide(p, P)
-#define UNHIDE(P) xcc_unhide(p, P)
-
-#define COVER_PRIME(I) xcc_cover_prime(p, I)
-#define UNCOVER_PRIME(I) xcc_uncover_prime(p, I)
-#define HIDE_PRIME(P) xcc_hide_prime(p, P)
-#define UNHIDE_PRIME(P) xcc_unhide_prime(p, P)
-
-#define COMMIT(P, J) xcc_commit(p, P, J)
-#define UNCOMMIT(P, J) xcc_uncommit(p, P, J)
-#define PURIFY(P) xcc_purify(p, P)
-#define UNPURIFY(P) xcc_unpurify(p, P)
+#define COVER(I) xcc_cover(p, I, false)
+#define UNCOVER(I) xcc_uncover(p, I, false)
+#define HIDE(P) xcc_hide(p, P, false)
+#define UNHIDE(P) xcc_unhide(p, P, false)
+
+#define COVER_PRIME(I) xcc_cover_prime(p, I, false)
+#define UNCOVER_PRIME(I) xcc_uncover_prime(p, I, false)
+#define HIDE_PRIME(P) xcc_hide_prime(p, P, false)
+#define UNHIDE_PRIME(P) xcc_unhide_prime(p, P, false)
+
+#define COMMIT(P, J) xcc_commit(p, P, J, false)
+#define UNCOMMIT(P, J) xcc_uncommit(p, P, J, false)
+#define PURIFY(P) xcc_purify(p, P, false)
+#define UNPURIFY(P) xcc_unpurify(p, P, false)
+
+// Variants for the kernels of X and C, which keep the MRV buckets up to date
+// if B is set.
+#define COVER_B(I, B) ((B) ? xcc_cover(p, I, true) : xcc_cover(p, I, false))
+#define UNCOVER_B(I, B) \
+  ((B) ? xcc_uncover(p, I, true) : xcc_uncover(p, I, false))
+#define COVER_PRIME_B(I, B) \
+  ((B) ? xcc_cover_prime(p, I, true) : xcc_cover_prime(p, I, false))
+#define UNCOVER_PRIME_B(I, B) \
+  ((B) ? xcc_uncover_prime(p, I, true) : xcc_uncover_prime(p, I, false))
+#define COMMIT_B(P, J, B) \
+  ((B) ? xcc_commit(p, P, J, true) : xcc_commit(p, P, J, false))
+#define UNCOMMIT_B(P, J, B) \
+  ((B) ? xcc_uncommit(p, P, J, true) : xcc_uncommit(p, P, J, false))
 
 #define TWEAK(X, P) xcc_tweak(p, X, P)
 #define UNTWEAK(L) xcc_untweak(p, L)
@@ -107,187 +138,263 @@ xcc_untweak_prime(xcc_problem* p, xcc_link l);
 #define MONUS(X, Y) MAX(X - Y, 0)
 #define THETA(P) MONUS(LEN(P) + 1, MONUS(BOUND(P), SLACK(P)))
 
+#define BUCKET_HEAD(LEN) (p->N_1 + 1 + (LEN))
+
+inline static void
+xcc_bucket_insert(xcc_problem* p, xcc_link i) {
+  xcc_link h = BUCKET_HEAD(LEN(i)), n = p->bucket[h].next;
+  p->bucket[i].next = n;
+  p->bucket[i].prev = h;
+  p->bucket[n].prev = i;
+  p->bucket[h].next = i;
+  if(LEN(i) < p->bucket_min)
+    p->bucket_min = LEN(i);
+}
+
 inline static void
-xcc_cover(xcc_problem* p, xcc_link i) {
+xcc_bucket_remove(xcc_problem* p, xcc_link i) {
+  xcc_link n = p->bucket[i].next, b = p->bucket[i].prev;
+  p->bucket[b].next = n;
+  p->bucket[n].prev = b;
+  p->bucket[i].next = 0;
+}
+
+// Moves item x to the bucket of its new LEN. Covered items keep no bucket.
+inline static void
+xcc_bucket_update(xcc_problem* p, xcc_link x) {
+  if(x <= p->N_1 && p->bucket[x].next) {
+    xcc_bucket_remove(p, x);
+    xcc_bucket_insert(p, x);
+  }
+}
+
+static XCC_ALWAYS_INLINE void
+xcc_cover(xcc_problem* p, xcc_link i, bool buckets) {
   xcc_link p_ = DLINK(i);
   while(p_ != i) {
-    HIDE(p_);
+    MEMS(1);
+    xcc_hide(p, p_, buckets);
     p_ = DLINK(p_);
   }
+  MEMS(3);
   xcc_link l = LLINK(i), r = RLINK(i);
   RLINK(l) = r;
   LLINK(r) = l;
+  if(buckets && i <= p->N_1)
+    xcc_bucket_remove(p, i);
 }
 
-inline static void
-xcc_cover_prime(xcc_problem* p, xcc_link i) {
+static XCC_ALWAYS_INLINE void
+xcc_cover_prime(xcc_problem* p, xcc_link i, bool buckets) {
   xcc_link p_ = DLINK(i);
   while(p_ != i) {
-    HIDE_PRIME(p_);
+    MEMS(1);
+    xcc_hide_prime(p, p_, buckets);
     p_ = DLINK(p_);
   }
+  MEMS(3);
   xcc_link l = LLINK(i), r = RLINK(i);
   RLINK(l) = r;
   LLINK(r) = l;
+  if(buckets && i <= p->N_1)
+    xcc_bucket_remove(p, i);
 }
 
-inline static void
-xcc_uncover(xcc_problem* p, xcc_link i) {
+static XCC_ALWAYS_INLINE void
+xcc_uncover(xcc_problem* p, xcc_link i, bool buckets) {
+  MEMS(3);
   xcc_link l = LLINK(i);
   xcc_link r = RLINK(i);
   RLINK(l) = i;
   LLINK(r) = i;
+  if(buckets && i <= p->N_1)
+    xcc_bucket_insert(p, i);
   xcc_link p_ = ULINK(i);
   while(p_ != i) {
-    UNHIDE(p_);
+    MEMS(1);
+    xcc_unhide(p, p_, buckets);
     p_ = ULINK(p_);
   }
 }
 
-inline static void
-xcc_uncover_prime(xcc_problem* p, xcc_link i) {
+static XCC_ALWAYS_INLINE void
+xcc_uncover_prime(xcc_problem* p, xcc_link i, bool buckets) {
+  MEMS(3);
   xcc_link l = LLINK(i);
   xcc_link r = RLINK(i);
   RLINK(l) = i;
   LLINK(r) = i;
+  if(buckets && i <= p->N_1)
+    xcc_bucket_insert(p, i);
   xcc_link p_ = ULINK(i);
   while(p_ != i) {
-    UNHIDE_PRIME(p_);
+    MEMS(1);
+    xcc_unhide_prime(p, p_, buckets);
     p_ = ULINK(p_);
   }
 }
 
-inline static void
-xcc_hide(xcc_problem* p, xcc_link p_) {
+static XCC_ALWAYS_INLINE void
+xcc_hide(xcc_problem* p, xcc_link p_, bool buckets) {
   xcc_link q = p_ + 1;
   while(q != p_) {
     assert(q >= 0);
-    assert(q < p->top_size);
+    assert(q < p->node_size);
     xcc_link x = TOP(q);
     xcc_link u = ULINK(q);
     xcc_link d = DLINK(q);
+    MEMS(1);
 
     assert(x != 0);
 
     if(x <= 0) {
       q = u; /* q was a spacer */
     } else {
+      MEMS(3);
       DLINK(u) = d;
       ULINK(d) = u;
       LEN(x) = LEN(x) - 1;
+      if(buckets)
+        xcc_bucket_update(p, x);
       q = q + 1;
     }
   }
 }
 
-inline static void
-xcc_unhide(xcc_problem* p, xcc_link p_) {
+static XCC_ALWAYS_INLINE void
+xcc_unhide(xcc_problem* p, xcc_link p_, bool buckets) {
   xcc_link q = p_ - 1;
   while(q != p_) {
     xcc_link x = TOP(q);
     xcc_link u = ULINK(q);
     xcc_link d = DLINK(q);
+    MEMS(1);
     if(x <= 0) {
       q = d; /* q was a spacer */
     } else {
+      MEMS(3);
       DLINK(u) = q;
       ULINK(d) = q;
       LEN(x) = LEN(x) + 1;
+      if(buckets)
+        xcc_bucket_update(p, x);
       q = q - 1;
     }
   }
 }
 
-inline static void
-xcc_hide_prime(xcc_problem* p, xcc_link p_) {
+static XCC_ALWAYS_INLINE void
+xcc_hide_prime(xcc_problem* p, xcc_link p_, bool buckets) {
   xcc_link q = p_ + 1;
   while(q != p_) {
     xcc_link x = TOP(q);
     xcc_link u = ULINK(q);
     xcc_link d = DLINK(q);
+    MEMS(1);
 
     if(x <= 0) {
       q = u; /* q was a spacer */
     } else if(COLOR(q) < 0) {
       q = q + 1;
     } else {
+      MEMS(3);
       DLINK(u) = d;
       ULINK(d) = u;
       LEN(x) = LEN(x) - 1;
+      if(buckets)
+        xcc_bucket_update(p, x);
       q = q + 1;
     }
   }
 }
 
-inline static void
-xcc_unhide_prime(xcc_problem* p, xcc_link p_) {
+static XCC_ALWAYS_INLINE void
+xcc_unhide_prime(xcc_problem* p, xcc_link p_, bool buckets) {
   xcc_link q = p_ - 1;
   while(q != p_) {
     xcc_link x = TOP(q);
     xcc_link u = ULINK(q);
     xcc_link d = DLINK(q);
+    MEMS(1);
     if(x <= 0) {
       q = d; /* q was a spacer */
     } else if(COLOR(q) < 0) {
       q = q - 1;
     } else {
+      MEMS(3);
       DLINK(u) = q;
       ULINK(d) = q;
       LEN(x) = LEN(x) + 1;
+      if(buckets)
+        xcc_bucket_update(p, x);
       q = q - 1;
     }
   }
 }
 
-inline static void
-xcc_commit(xcc_problem* p, xcc_link p_, xcc_link j_) {
+static XCC_ALWAYS_INLINE void
+xcc_commit(xcc_problem* p, xcc_link p_, xcc_link j_, bool buckets) {
   if(COLOR(p_) == 0)
-    COVER_PRIME(j_);
+    xcc_cover_prime(p, j_, buckets);
   else if(COLOR(p_) > 0)
-    PURIFY(p_);
+    xcc_purify(p, p_, buckets);
 }
 
-inline static void
-xcc_uncommit(xcc_problem* p, xcc_link p_, xcc_link j_) {
+static XCC_ALWAYS_INLINE void
+xcc_uncommit(xcc_problem* p, xcc_link p_, xcc_link j_, bool buckets) {
   if(COLOR(p_) == 0)
-    UNCOVER_PRIME(j_);
+    xcc_uncover_prime(p, j_, buckets);
   else if(COLOR(p_) > 0)
-    UNPURIFY(p_);
+    xcc_unpurify(p, p_, buckets);
 }
 
-inline static void
-xcc_purify(xcc_problem* p, xcc_link p_) {
+static XCC_ALWAYS_INLINE void
+xcc_purify(xcc_problem* p, xcc_link p_, bool buckets) {
   xcc_link c = COLOR(p_);
   xcc_link i = TOP(p_);
   // Inserted according to err4f5 (Errata)
   COLOR(i) = c;
   xcc_link q = DLINK(i);
   while(q != i) {
+    MEMS(1);
     if(COLOR(q) == c)
       COLOR(q) = -1;
     else
-      HIDE_PRIME(q);
+      xcc_hide_prime(p, q, buckets);
     q = DLINK(q);
   }
 }
 
-inline static void
-xcc_unpurify(xcc_problem* p, xcc_link p_) {
+static XCC_ALWAYS_INLINE void
+xcc_unpurify(xcc_problem* p, xcc_link p_, bool buckets) {
   xcc_link c = COLOR(p_), i = TOP(p_), q = ULINK(i);
   while(q != i) {
+    MEMS(1);
     if(COLOR(q) < 0)
       COLOR(q) = c;
     else
-      UNHIDE_PRIME(q);
+      xcc_unhide_prime(p, q, buckets);
     q = ULINK(q);
   }
 }
 
+// Sets the colors of the secondary items of the option of node x like PURIFY
+// does, for engines without PURIFY. Printed solutions show these colors.
+inline static void
+xcc_set_item_colors(xcc_problem* p, xcc_link x) {
+  while(TOP(x - 1) > 0)
+    --x;
+  for(; TOP(x) > 0; ++x)
+    if(TOP(x) > p->N_1 && COLOR(x) > 0)
+      COLOR(TOP(x)) = COLOR(x);
+}
+
 inline static void
 xcc_tweak(xcc_problem* p, xcc_link x, xcc_link p_) {
   assert(x == DLINK(p_));
   assert(p_ == ULINK(x));
   HIDE_PRIME(x);
+  MEMS(3);
   xcc_link d = DLINK(x);
   DLINK(p_) = d;
   ULINK(d) = p_;
@@ -303,12 +410,14 @@ xcc_untweak(xcc_problem* p, xcc_link l) {
   DLINK(p_) = x;
   xcc_link k = 0;
   while(x != z) {
+    MEMS(2);
     ULINK(x) = y;
     k = k + 1;
     UNHIDE_PRIME(x);
     y = x;
     x = DLINK(x);
   }
+  MEMS(3);
   ULINK(z) = y;
   LEN(p_) = LEN(p_) + k;
 }
@@ -317,6 +426,7 @@ inline static void
 xcc_tweak_prime(xcc_problem* p, xcc_link x, xcc_link p_) {
   assert(x == DLINK(p_));
   assert(p_ == ULINK(x));
+  MEMS(3);
   xcc_link d = DLINK(x);
   DLINK(p_) = d;
   ULINK(d) = p_;
@@ -332,16 +442,103 @@ xcc_untweak_prime(xcc_problem* p, xcc_link l) {
   DLINK(p_) = x;
   xcc_link k = 0;
   while(x != z) {
+    MEMS(2);
     ULINK(x) = y;
     k = k + 1;
     y = x;
     x = DLINK(x);
   }
+  MEMS(3);
   ULINK(z) = y;
   LEN(p_) = LEN(p_) + k;
   UNCOVER_PRIME(p_);
 }
 
+// Replays the search prefix of p (see xcc_problem). Returns true if the node
+// x[l] must be skipped instead of being tried as the next branch.
+inline static bool
+xcc_skip_for_prefix(xcc_problem* p, int l) {
+  if(l >= p->prefix_size)
+    return false;
+  if(p->x[l] != p->prefix[l])
+    return true;
+  if(l == p->prefix_size - 1) {
+    p->prefix_size = 0;
+    return true;
+  }
+  return false;
+}
+
+inline static xcc_link
+xcc_choose_mrv(xcc_problem* p) {
+  if(p->buckets) {
+    xcc_link h = BUCKET_HEAD(p->bucket_min);
+    while(p->bucket[h].next == h)
+      ++h;
+    p->bucket_min = h - BUCKET_HEAD(0);
+    return p->bucket[h].next;
+  }
+
+  xcc_link i = RLINK(0);
+  xcc_link p_ = RLINK(0), theta = XCC_LINK_MAX;
+  while(p_ != 0) {
+    xcc_link lambda = LEN(p_);
+    if(lambda < theta) {
+      theta = lambda;
+      i = p_;
+    }
+    if(lambda == 0) {
+      return i;
+    }
+    p_ = RLINK(p_);
+  }
+  return i;
+}
+
+inline static xcc_link
+xcc_choose_mrv_slacker(xcc_problem* p) {
+  xcc_link theta = XCC_LINK_MAX;
+  xcc_link i = RLINK(0);
+  xcc_link p_ = RLINK(0);
+  while(p_ != 0) {
+    xcc_link lambda = THETA(p_);
+    if(lambda < theta || (lambda == theta && SLACK(p_) == SLACK(i)) ||
+       (lambda == theta && SLACK(p_) == SLACK(i) && LEN(p_) > LEN(i))) {
+      theta = lambda;
+      i = p_;
+      assert(i <= p->primary_item_count);
+    }
+    p_ = RLINK(p_);
+  }
+  assert(i <= p->primary_item_count);
+  return i;
+}
+
+// Drops the MRV buckets once few items are left and rebuilds them when the
+// search is back at many items, see XCC_MRV_BUCKET_ITEMS.
+inline static void
+xcc_mrv_buckets_adapt(xcc_problem* p, int primaries_left) {
+  if(primaries_left < XCC_MRV_BUCKET_ITEMS / 2)
+    p->buckets = false;
+  else if(primaries_left >= XCC_MRV_BUCKET_ITEMS && !p->buckets)
+    xcc_mrv_buckets_init(p);
+}
+
+// In the kernels, h is a constant, so the chosen heuristic is inlined.
+static XCC_ALWAYS_INLINE xcc_link
+xcc_choose(xcc_heuristic h, xcc_algorithm* a, xcc_problem* p) {
+  switch(h) {
+    case XCC_HEURISTIC_NAIVE:
+      return RLINK(0);
+    case XCC_HEURISTIC_MRV:
+      return xcc_choose_mrv(p);
+    case XCC_HEURISTIC_MRV_SLACKER:
+      return xcc_choose_mrv_slacker(p);
+    default:
+      return a->choose_i(a, p);
+  }
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,62 @@
+/*
+    XCCSolve - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef XCC_ORDER_H
+#define XCC_ORDER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <xcc/xcc.h>
+
+// The order in which the options of the chosen item are tried.
+typedef enum xcc_option_order {
+  // The order of the input.
+  XCC_ORDER_INPUT,
+  // Options that conflict with the fewest other options first.
+  XCC_ORDER_LEAST_CONSTRAINING,
+  // Options that conflict with the most other options first.
+  XCC_ORDER_MOST_CONSTRAINING,
+  // Options with a higher priority (given with = in the input) first.
+  XCC_ORDER_PRIORITY,
+  // Options with a lower cost (given with $ in the input) first.
+  XCC_ORDER_COST
+} xcc_option_order;
+
+// Relinks the list of item j to the n nodes in the given order, which must be
+// a permutation of its current nodes.
+void
+xcc_relink_column(xcc_problem* p,
+                  xcc_link j,
+                  const xcc_link* nodes,
+                  xcc_link n);
+
+// Sorts the options in the list of every item. Options are tried in the order
+// of their item's list, so this costs nothing during the search. The
+// conflicts of an option are the number of options in the lists of its items
+// that cannot be selected together with it, summed over its items. Ties keep
+// their current order. Must be called at the root of the search, before the
+// algorithm builds any other structures from the matrix.
+void
+xcc_order_options(xcc_problem* p, xcc_option_order order);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,75 @@
+/*
+    XCCSolve - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef XCC_PARALLEL_H
+#define XCC_PARALLEL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct xcc_algorithm;
+struct xcc_problem;
+struct xcc_config;
+
+// Number of search nodes a worker explores before it checks whether other
+// workers are idle and waiting for work.
+#ifndef XCC_PARALLEL_YIELD_NODES
+#define XCC_PARALLEL_YIELD_NODES 1024
+#endif
+
+// Solve the given problem using cfg->threads workers, each working on its own
+// copy of the problem. The search tree is split lazily: whenever a worker is
+// idle, a busy worker donates the unexplored branches of its shallowest open
+// level. Solutions are printed like in xcc_solve_problem_and_print_solutions.
+//
+// Works with every algorithm that respects the search control fields of
+// xcc_problem (X, C and M).
+int
+xcc_solve_problem_parallel_and_print_solutions(struct xcc_algorithm* a,
+                                               struct xcc_problem* p,
+                                               struct xcc_config* cfg);
+
+// Count all solutions of the given problem using the given number of threads.
+// The problem itself is not modified.
+size_t
+xcc_count_solutions_parallel(struct xcc_algorithm* a,
+                             struct xcc_problem* p,
+                             int threads);
+
+// Like xcc_count_solutions_parallel, but calls visit for every solution, which
+// is in the problem of the worker that found it. Calls are serialized, and
+// returning false stops the search. Workers check for idle ones every
+// yield_nodes search nodes (XCC_PARALLEL_YIELD_NODES if 0), so small values
+// split the search tree often.
+size_t
+xcc_visit_solutions_parallel(struct xcc_algorithm* a,
+                             struct xcc_problem* p,
+                             int threads,
+                             size_t yield_nodes,
+                             bool (*visit)(struct xcc_problem* p,
+                                           void* userdata),
+                             void* userdata);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
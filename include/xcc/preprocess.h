@@ -0,0 +1,90 @@
+/*
+    XCCSolve - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef XCC_PREPROCESS_H
+#define XCC_PREPROCESS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct xcc_algorithm;
+struct xcc_problem;
+
+typedef struct xcc_preprocess_stats {
+  // Options that conflict with every option of some primary item.
+  size_t blocked_options;
+  // Options with an item j but without the primary item i, although every
+  // option of i contains j.
+  size_t dominated_options;
+  // Options without any primary item, which are never selected.
+  size_t secondary_options;
+  // Items whose options all contain some other primary item, or secondary
+  // items without options.
+  size_t removed_items;
+  size_t rounds;
+  // Options that were selected tentatively, and whether the time ran out.
+  size_t probes;
+  bool timed_out;
+  // Some primary item has not enough options left, so there is no solution.
+  bool unsatisfiable;
+} xcc_preprocess_stats;
+
+// Reduces p before the search, like Knuth's DLX-PRE does for XCC problems.
+// Options are removed if they contain no primary item, if they conflict with
+// all options of some primary item, or if they contain an item j but not the
+// primary item i while every option of i contains j. Item j is then implied by
+// i and is removed too, which also merges items with identical options. This
+// is repeated until nothing changes.
+//
+// The reduced problem replaces p and is constructed with the functions of a,
+// so it must be called after parsing and before the first compute_next_result.
+// Options keep their original indices in solutions. Multiplicities are not
+// supported, so an error is returned if algorithm has the XCC_ALGORITHM_M bit
+// or some primary item has a range. stats may be NULL.
+const char*
+xcc_preprocess(struct xcc_algorithm* a,
+               struct xcc_problem* p,
+               int algorithm,
+               xcc_preprocess_stats* stats);
+
+// Only the blocked options rule of xcc_preprocess, for X, C and M: every
+// option is selected tentatively at the root with COMMIT, and removed if some
+// primary item is left with fewer options than its lower bound. Items with an
+// upper bound above 1 stay active. If algorithm has the XCC_ALGORITHM_M bit,
+// plain primary items may be covered any number of times, like Algorithm M
+// does, so they stay active and need no options. This is repeated until
+// nothing changes, or until seconds of processor time are used up if seconds
+// is positive. Removed options are counted as blocked_options.
+//
+// Like xcc_preprocess, the reduced problem replaces p and solutions keep the
+// original option indices. stats may be NULL.
+const char*
+xcc_probe(struct xcc_algorithm* a,
+          struct xcc_problem* p,
+          int algorithm,
+          double seconds,
+          xcc_preprocess_stats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,64 @@
+/*
+    XCCSolve - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef XCC_RESTART_H
+#define XCC_RESTART_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct xcc_algorithm;
+struct xcc_problem;
+
+// The Luby sequence 1, 1, 2, 1, 1, 2, 4, 1, 1, 2, 1, 1, 2, 4, 8, ... (k >= 1).
+size_t
+xcc_luby(size_t k);
+
+// Shuffles the list of active primary items and the options in the list of
+// every item. MRV breaks ties by the order of the items and options are tried
+// in the order of their item's list, so this randomizes both without slowing
+// down the search. Must be called at the root of the search. state is the
+// state of a xorshift64 generator and must not be 0.
+void
+xcc_shuffle(struct xcc_problem* p, uint64_t* state);
+
+// Searches for the first solution with Algorithm X, C or M, restarting after
+// unit * xcc_luby(k) branches in run k, or, if growth > 1, after unit *
+// growth^(k - 1) branches. Every run but the first searches the problem
+// shuffled from seed. The budgets grow without limit, so a run eventually
+// finishes its search tree and the search is complete. The bitset tail is not
+// used. Returns true if a solution was found. It is then in p, and
+// compute_next_result continues with the other solutions of the last run,
+// which are all other solutions of the problem.
+bool
+xcc_search_with_restarts(struct xcc_algorithm* a,
+                         struct xcc_problem* p,
+                         size_t unit,
+                         double growth,
+                         uint64_t seed,
+                         size_t* restarts);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
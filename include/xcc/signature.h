@@ -0,0 +1,107 @@
+/*
+    XCCSolve - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef XCC_SIGNATURE_H
+#define XCC_SIGNATURE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "xcc.h"
+
+// The set of active items of a problem, used as the key of a sub-problem in
+// exact cover without colors. Searches toggle items when they cover or uncover
+// them, which also keeps a Zobrist hash of the set up to date.
+typedef struct xcc_signature {
+  size_t words;
+  uint64_t* active;
+  uint64_t* zobrist;
+  uint64_t hash;
+} xcc_signature;
+
+static inline uint64_t
+xcc_xorshift64(uint64_t* state) {
+  uint64_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  return *state = x;
+}
+
+static inline void
+xcc_signature_toggle(xcc_signature* s, xcc_link i) {
+  s->active[i / 64] ^= 1ull << (i % 64);
+  s->hash ^= s->zobrist[i];
+}
+
+// Starts with all items 1 to N active.
+static inline void
+xcc_signature_init(xcc_signature* s, xcc_link N) {
+  s->words = (N + 1 + 63) / 64;
+  s->active = (uint64_t*)calloc(s->words, sizeof(uint64_t));
+  s->zobrist = (uint64_t*)malloc((N + 1) * sizeof(uint64_t));
+  s->hash = 0;
+
+  uint64_t state = 0x2545F4914F6CDD1Dull;
+  for(xcc_link i = 0; i <= N; ++i)
+    s->zobrist[i] = xcc_xorshift64(&state);
+  for(xcc_link i = 1; i <= N; ++i)
+    xcc_signature_toggle(s, i);
+}
+
+static inline void
+xcc_signature_free(xcc_signature* s) {
+  free(s->active);
+  free(s->zobrist);
+  s->active = NULL;
+  s->zobrist = NULL;
+}
+
+// Sub-problems are determined by their active items only if there are neither
+// colors nor multiplicities.
+static inline const char*
+xcc_signature_check(const xcc_problem* p) {
+  for(xcc_link i = 1; i <= p->N_1; ++i) {
+    if(p->bound[i] != 0)
+      return "Memoization does not support multiplicities!";
+  }
+  // The first color name is the reserved NULL of uncolored nodes.
+  if(p->color_name_size > 1)
+    return "Memoization does not support colors!";
+  for(xcc_link i = p->rlink[0]; i != 0; i = p->rlink[i]) {
+    if(p->node[i].len == 0)
+      return "Some item never occurs in the options!";
+  }
+  return NULL;
+}
+
+static inline bool
+xcc_signature_equals(const xcc_signature* s, const uint64_t* key) {
+  return memcmp(s->active, key, s->words * sizeof(uint64_t)) == 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
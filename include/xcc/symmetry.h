@@ -0,0 +1,96 @@
+/*
+    XCCSolve - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef XCC_SYMMETRY_H
+#define XCC_SYMMETRY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "xcc.h"
+
+// Groups with more elements are not enumerated, as every solution is compared
+// with all of its images.
+#ifndef XCC_SYMMETRY_MAX_ORDER
+#define XCC_SYMMETRY_MAX_ORDER 1024
+#endif
+
+// Search nodes after which the detection gives up.
+#ifndef XCC_SYMMETRY_MAX_NODES
+#define XCC_SYMMETRY_MAX_NODES 100000
+#endif
+
+typedef struct xcc_symmetry {
+  // The automorphism group, order rows of M + 1 option images each, indexed
+  // like solutions. Row 0 is the identity.
+  size_t order;
+  xcc_link M;
+  xcc_link* image;
+  xcc_link N;
+  xcc_link* item_image;
+
+  // Set if the detection gave up, the group is then trivial.
+  bool gave_up;
+  size_t nodes;
+
+  // Primary item whose options were restricted to one per orbit by
+  // xcc_symmetry_break, or 0. covers marks its remaining options.
+  xcc_link item;
+  bool* covers;
+  size_t removed_options;
+
+  xcc_link* sorted;
+  xcc_link* mapped;
+} xcc_symmetry;
+
+// Computes the automorphisms of the items and live options of p, i.e. the
+// permutations that keep primary items, multiplicities, colors and the
+// incidence of items and options. The search refines a coloring of the
+// bipartite graph of items and options and individualizes vertices until the
+// coloring is discrete, like nauty does. Equal options are one vertex of the
+// graph and their images keep their order, so swapping them is no symmetry.
+const char*
+xcc_symmetry_detect(xcc_problem* p, xcc_symmetry* s);
+
+// Removes all options of an item that every automorphism fixes, except for the
+// first one of each orbit. The item is primary without multiplicity or
+// secondary without colors, so every orbit of solutions that uses it keeps a
+// solution with one of these options. Must be called at the root of the
+// search. The options are only unlinked from their items.
+void
+xcc_symmetry_break(xcc_problem* p, xcc_symmetry* s);
+
+// Returns the number of solutions in the orbit of the given solution if it is
+// the lexicographically smallest one of its orbit that the search finds, and 0
+// otherwise. Reporting only these finds every orbit exactly once.
+size_t
+xcc_symmetry_orbit_size(xcc_symmetry* s,
+                        const xcc_link* solution,
+                        xcc_link size);
+
+void
+xcc_symmetry_free(xcc_symmetry* s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -40,6 +40,11 @@ struct xcc_algorithm;
 struct xcc_problem;
 struct xcc_config;
 
+// Prints the solution currently stored in p in the format selected by cfg.
+// Returns true if the printed solution counts towards the number of solutions.
+bool
+xcc_print_solution(struct xcc_problem* p, struct xcc_config* cfg);
+
 // Utility function to solve the given problem and print solutions. Both used in
 // the web version and the CLI version of xccsolve.
 int
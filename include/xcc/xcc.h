@@ -22,17 +22,40 @@
 extern "C" {
 #endif
 
+#include <inttypes.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
+// Width of the links in the dancing links matrix, chosen at build time. Small
+// problems need less memory bandwidth with 16 bit links, problems with more
+// than 2^31 nodes need 64 bit links. The parser reports problems that do not
+// fit. Code using the headers must be compiled with the same setting as the
+// library.
+#ifndef XCC_LINK_BITS
+#define XCC_LINK_BITS 32
+#endif
+
+#if XCC_LINK_BITS == 16
+typedef int16_t xcc_link;
+#define XCC_LINK_MAX INT16_MAX
+#define XCC_PRI_LINK PRId16
+#elif XCC_LINK_BITS == 32
 typedef int32_t xcc_link;
+#define XCC_LINK_MAX INT32_MAX
+#define XCC_PRI_LINK PRId32
+#elif XCC_LINK_BITS == 64
+typedef int64_t xcc_link;
+#define XCC_LINK_MAX INT64_MAX
+#define XCC_PRI_LINK PRId64
+#else
+#error "XCC_LINK_BITS must be 16, 32 or 64"
+#endif
+
 typedef xcc_link xcc_color;
 typedef char* xcc_name;
 typedef struct xcc_algorithm xcc_algorithm;
 
-#define XCC_LINK_MAX INT32_MAX
-
 #define ARR(TYPE, NAME) \
   TYPE* NAME;           \
   size_t NAME##_size;   \
@@ -62,6 +85,26 @@ typedef struct xcc_config {
   int enumerate;
   int transform_to_libexact;
   int algorithm_select;
+  int threads;
+  const char* zdd_file;
+  int count;
+  size_t cache_mb;
+  size_t component_depth;
+  int preprocess;
+  int probe;
+  double probe_seconds;
+  int symmetry;
+  int orbits;
+  int lds;
+  size_t restart_unit;
+  double restart_growth;
+  unsigned long long seed;
+  int option_order;
+  int nogoods;
+  size_t cheapest;
+  size_t samples;
+  size_t estimate;
+  int backbone;
   char* const* input_files;
   size_t input_files_count;
   size_t current_input_file;
@@ -74,29 +117,57 @@ typedef enum xcc_algorithm_id {
   XCC_ALGORITHM_X = 1 << 4,
   XCC_ALGORITHM_C = 1 << 5,
   XCC_ALGORITHM_M = 1 << 6,
-  XCC_ALGORITHM_KNUTH_CNF = 1 << 7
+  XCC_ALGORITHM_KNUTH_CNF = 1 << 7,
+  XCC_ALGORITHM_DC = 1 << 8,
+  XCC_ALGORITHM_BITSET = 1 << 9,
+  XCC_ALGORITHM_NO_BITSET = 1 << 10,
+  XCC_ALGORITHM_WEIGHTED = 1 << 11
 } xcc_algorithm_id;
 
 #define XCC_LONG_OPTIONS (1 << 20)
 #define XCC_OPTION_PRINT_X (XCC_LONG_OPTIONS + 1)
+#define XCC_OPTION_CACHE_SIZE (XCC_LONG_OPTIONS + 2)
+#define XCC_OPTION_COMPONENTS (XCC_LONG_OPTIONS + 3)
+#define XCC_OPTION_PROBE_TIME (XCC_LONG_OPTIONS + 4)
+#define XCC_OPTION_RESTARTS (XCC_LONG_OPTIONS + 5)
+#define XCC_OPTION_RESTART_GROWTH (XCC_LONG_OPTIONS + 6)
+#define XCC_OPTION_SEED (XCC_LONG_OPTIONS + 7)
+#define XCC_OPTION_ORDER (XCC_LONG_OPTIONS + 8)
+#define XCC_OPTION_MIN_COST (XCC_LONG_OPTIONS + 9)
+#define XCC_OPTION_TOP (XCC_LONG_OPTIONS + 10)
+#define XCC_OPTION_SAMPLE (XCC_LONG_OPTIONS + 11)
+#define XCC_OPTION_ESTIMATE (XCC_LONG_OPTIONS + 12)
+
+// A node of the dancing links matrix. Hiding an option reads TOP, ULINK and
+// DLINK of each of its nodes and C and M also check the COLOR, so all of them
+// are packed into one record of 16 bytes. Item headers use TOP as LEN. All
+// engines share this record, as they work on the same parsed problem, which
+// the parser, preprocessing, printing, copying and the bitset tail access
+// through it. Leaving out COLOR for X would save no cache lines, as records
+// of three links do not divide a cache line and some would straddle two.
+typedef struct xcc_node {
+  union {
+    xcc_link top;
+    xcc_link len;
+  };
+  xcc_link ulink;
+  xcc_link dlink;
+  xcc_color color;
+} xcc_node;
+
+// Links of an item or bucket head in the MRV buckets, see xcc_problem.
+typedef struct xcc_bucket {
+  xcc_link next;
+  xcc_link prev;
+} xcc_bucket;
 
 typedef struct xcc_problem {
   ARR(xcc_link, llink)
   ARR(xcc_link, rlink)
-  ARR(xcc_link, ulink)
-  ARR(xcc_link, dlink)
-  union {
-    struct {
-      ARR(xcc_link, top)
-    };
-    struct {
-      ARR(xcc_link, len)
-    };
-  };
+  ARR(xcc_node, node)
 
   ARR(xcc_name, name)
   ARR(xcc_name, color_name)
-  ARR(xcc_color, color)
   ARR(xcc_link, ft)
   ARR(xcc_link, slack)
   ARR(xcc_link, bound)
@@ -104,13 +175,92 @@ typedef struct xcc_problem {
   // Solution
   ARR(xcc_link, x)
 
-  int N, N_1, M, i, j, l, p, q, Z;
+  int N, N_1, M, i, j, l;
+  xcc_link p, q, Z;
   int primary_item_count;
   int secondary_item_count;
   int option_count;
   int state;
   int longest_option;
 
+  // Search control. Levels below prefix_size replay the given nodes in x
+  // before the search continues normally. The node at level prefix_size - 1
+  // itself is skipped, so the search resumes with the branches after it.
+  // Levels below fixed are never advanced to their next branch.
+  // If node_limit is reached, compute_next_result returns false and sets
+  // interrupted. Calling it again resumes the search. With restart, X, C and
+  // M first backtrack to the root, so setting state and fixed to 0 starts
+  // the search again.
+  // If tail_items is set, Algorithms X and C finish the search with bitsets
+  // once at most tail_items primary items are left (which requires MRV and
+  // tail_items <= XCC_BITSET_MAX_ITEMS). They count them in primaries_left.
+  // Algorithms X, C and M select the only option of an item right away and
+  // count it in forced instead of nodes, so nodes counts the branches.
+  // mems is only counted by the operations of estimate.c, see ops.h.
+  xcc_link* prefix;
+  int prefix_size;
+  int fixed;
+  size_t nodes;
+  size_t forced;
+  size_t mems;
+  size_t node_limit;
+  bool interrupted;
+  bool restart;
+
+  // With lds, X, C and M search by limited discrepancy. A discrepancy is a
+  // level that takes another branch than the first one of its item. The
+  // search is repeated with discrepancy_limit = 0, 1, 2, ... and every
+  // iteration only follows paths with at most that many discrepancies and
+  // reports the solutions with exactly that many. discrepancies counts them
+  // on the current path. Once an iteration did not have to cut off a branch
+  // (discrepancy_cut), every solution was reported.
+  bool lds;
+  int discrepancy_limit;
+  int discrepancies;
+  bool discrepancy_cut;
+  int tail_items;
+  int primaries_left;
+
+  // Active primary items bucketed by LEN, so that MRV finds the minimum
+  // without scanning all items (see xcc_mrv_buckets_init). Items 1..N_1 and
+  // the bucket_count heads N_1 + 1 + LEN form circular lists through bucket.
+  // The next link of an item not in any bucket is 0 and bucket_min is a lower
+  // bound for the LEN of the first non-empty bucket. The buckets are only
+  // maintained (and used by MRV) while buckets is set.
+  bool buckets;
+  xcc_bucket* bucket;
+  xcc_link bucket_count;
+  xcc_link bucket_min;
+
+  // Conflict weights of the primary items for xcc_choose_i_weighted, which
+  // allocates them on first use. Bumping an item adds weight_bump, which then
+  // grows by 1 / XCC_WEIGHT_DECAY, so older bumps decay relative to new ones.
+  double* weight;
+  double weight_bump;
+
+  // Priorities of the options given with = in the input, indexed by option
+  // index. Options at or beyond priority_size have priority 0. NULL if the
+  // input gives none.
+  int* priority;
+  size_t priority_size;
+
+  // Costs of the options given with $ in the input, indexed like priority.
+  // Options at or beyond cost_size cost 0. NULL if the input gives none.
+  int64_t* cost;
+  size_t cost_size;
+
+  // First node of every option by option index (0 for removed options), built
+  // by xcc_solve_with_assumptions on first use. NULL until then.
+  xcc_link* option_node;
+
+  // Sub-problems without solutions that X and C prune, see xcc_nogoods_create.
+  // NULL if not used.
+  struct xcc_nogoods* nogoods;
+
+  // Search for the cheapest solutions of X and C, see xcc_costs_create. NULL
+  // if not used.
+  struct xcc_costs* costs;
+
   void* algorithm_userdata;
   xcc_config* cfg;
 } xcc_problem;
@@ -134,9 +284,26 @@ xcc_problem_free_inner(xcc_problem* p, xcc_algorithm* a);
 void
 xcc_problem_free(xcc_problem* p, xcc_algorithm* a);
 
+// Deep copy of a fully constructed problem, including its current search
+// state. Algorithm userdata and MRV buckets are not copied.
+xcc_problem*
+xcc_problem_copy(const xcc_problem* p);
+
 xcc_link
 xcc_item_from_ident(xcc_problem* p, const char* ident);
 
+void
+xcc_set_option_priority(xcc_problem* p, xcc_link option, int priority);
+
+int
+xcc_option_priority(const xcc_problem* p, xcc_link option);
+
+void
+xcc_set_option_cost(xcc_problem* p, xcc_link option, int64_t cost);
+
+int64_t
+xcc_option_cost(const xcc_problem* p, xcc_link option);
+
 xcc_link
 xcc_insert_ident_as_name(xcc_problem* p, const char* ident);
 
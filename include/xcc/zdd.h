@@ -0,0 +1,102 @@
+/*
+    XCCSolve - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef XCC_ZDD_H
+#define XCC_ZDD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "bignum.h"
+
+struct xcc_problem;
+
+#define XCC_ZDD_BOTTOM 0
+#define XCC_ZDD_TOP 1
+
+// A node stands for the family lo + {option} x hi. Options are numbered like
+// in xcc_extract_solution_option_indices (starting at 1), the terminals have
+// option 0. Children always have smaller ids than their parents.
+typedef struct xcc_zdd_node {
+  uint32_t option;
+  uint32_t lo;
+  uint32_t hi;
+} xcc_zdd_node;
+
+// Decision diagram of all exact covers of a problem, built like Algorithm Z
+// (TAOCP 7.2.2.1). Every path from the root to XCC_ZDD_TOP is one solution.
+// Options along a path follow the branching order of the search, not a global
+// variable order, which is enough for counting and sampling.
+typedef struct xcc_zdd {
+  xcc_zdd_node* nodes;
+  size_t size;
+  size_t capacity;
+  uint32_t root;
+  uint32_t option_count;
+
+  // Number of solutions below every node, computed on demand.
+  xcc_bignum* counts;
+  // Node reached by a long jump down the lo links of every node, computed on
+  // demand for xcc_zdd_random_solution.
+  uint32_t* jump;
+} xcc_zdd;
+
+// Builds the ZDD of all solutions of p. Sub-problems are memoized by their set
+// of active items, so equal sub-problems are only solved once. Only exact
+// cover problems with optional secondary items are supported (no colors and
+// no multiplicities). The DLX structure of p is restored afterwards.
+const char*
+xcc_zdd_build(struct xcc_problem* p, xcc_zdd** out);
+
+void
+xcc_zdd_free(xcc_zdd* z);
+
+// Number of solutions. Owned by the ZDD.
+const xcc_bignum*
+xcc_zdd_count(xcc_zdd* z);
+
+// Number of solutions containing the given option.
+void
+xcc_zdd_count_containing(xcc_zdd* z, uint32_t option, xcc_bignum* out);
+
+// Writes a uniformly random solution to options, which needs room for
+// option_count entries, and returns the number of options written. Returns 0
+// if there is no solution. state is the state of a xorshift64 generator and
+// must not be 0. After the first call, a draw takes time in the length of the
+// solution (and the logarithm of the number of branches along it), not in
+// the size of the ZDD.
+size_t
+xcc_zdd_random_solution(xcc_zdd* z, uint64_t* state, uint32_t* options);
+
+// Binary format: the magic "XCCZDD01", then option count, node count
+// (including the two terminals) and root, then option, lo and hi of every
+// non-terminal node. All numbers are little-endian 32 bit integers.
+const char*
+xcc_zdd_write(const xcc_zdd* z, const char* path);
+
+const char*
+xcc_zdd_read(const char* path, xcc_zdd** out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -17,12 +17,17 @@
 */
 #include "xcc/xcc.h"
 #include <xcc/algorithm.h>
+#include <xcc/algorithm_bitset.h>
 #include <xcc/algorithm_c.h>
+#include <xcc/algorithm_dc.h>
 #include <xcc/algorithm_knuth_cnf.h>
 #include <xcc/algorithm_m.h>
 #include <xcc/algorithm_x.h>
 #include <xcc/ops.h>
 
+#include <math.h>
+#include <string.h>
+
 static inline const char*
 define_item(xcc_algorithm* a, xcc_problem* p, xcc_link l) {
   assert(a);
@@ -31,6 +36,9 @@ define_item(xcc_algorithm* a, xcc_problem* p, xcc_link l) {
   assert(p->llink);
   assert(p->rlink);
 
+  if(p->i + 2 >= XCC_LINK_MAX)
+    return "Too many items for the link width, see XCC_LINK_BITS!";
+
   XCC_ARR_PLUS1(llink)
   XCC_ARR_PLUS1(rlink)
 
@@ -117,22 +125,23 @@ prepare_options(xcc_algorithm* a, xcc_problem* p) {
   RLINK(p->N_1) = 0;
 
   // Step N3
-  XCC_ARR_PLUSN(len, p->N + 2);
-  XCC_ARR_PLUSN(ulink, p->N + 2);
-  XCC_ARR_PLUSN(dlink, p->N + 2);
+  XCC_ARR_PLUSN(node, p->N + 2);
 
   // Normalize the don't cares
   ULINK(p->N + 1) = 0;
   DLINK(p->N + 1) = 0;
+  COLOR(p->N + 1) = 0;
 
   LEN(0) = 0;
   ULINK(0) = 0;
   DLINK(0) = 0;
+  COLOR(0) = 0;
 
   for(int i = 1; i <= p->N; ++i) {
     LEN(i) = 0;
     ULINK(i) = i;
     DLINK(i) = i;
+    COLOR(i) = 0;
   }
 
   p->M = 0;
@@ -150,11 +159,10 @@ add_item_with_color(xcc_algorithm* a,
                     xcc_color c) {
   if(ij < 1)
     return "Invalid ij given for add_item!";
+  if(p->p + p->j + 2 >= XCC_LINK_MAX)
+    return "Too many nodes for the link width, see XCC_LINK_BITS!";
 
-  XCC_ARR_PLUS1(len)
-  XCC_ARR_PLUS1(dlink)
-  XCC_ARR_PLUS1(ulink)
-  XCC_ARR_PLUS1(color)
+  XCC_ARR_PLUS1(node)
 
   ++p->j;
 
@@ -177,9 +185,7 @@ add_item(xcc_algorithm* a, xcc_problem* p, xcc_link ij) {
 
 static const char*
 end_option(xcc_algorithm* a, xcc_problem* p) {
-  XCC_ARR_PLUS1(len)
-  XCC_ARR_PLUS1(dlink)
-  XCC_ARR_PLUS1(ulink)
+  XCC_ARR_PLUS1(node)
 
   p->M = p->M + 1;
   DLINK(p->p) = p->p + p->j;
@@ -198,7 +204,7 @@ end_option(xcc_algorithm* a, xcc_problem* p) {
 
 static const char*
 end_options(xcc_algorithm* a, xcc_problem* p) {
-  DLINK(p->dlink_size - 1) = 0;
+  DLINK(p->node_size - 1) = 0;
   return NULL;
 }
 
@@ -213,11 +219,8 @@ xcc_default_init_problem(xcc_algorithm* a, xcc_problem* p) {
   XCC_ARR_ALLOC(xcc_link, rlink)
   XCC_ARR_ALLOC(xcc_name, name)
   XCC_ARR_ALLOC(xcc_name, color_name)
-  XCC_ARR_ALLOC(xcc_name, len)
-  XCC_ARR_ALLOC(xcc_name, ulink)
-  XCC_ARR_ALLOC(xcc_name, dlink)
+  XCC_ARR_ALLOC(xcc_node, node)
   XCC_ARR_ALLOC(xcc_name, x)
-  XCC_ARR_ALLOC(xcc_color, color)
   XCC_ARR_ALLOC(xcc_link, ft)
   XCC_ARR_ALLOC(xcc_link, slack)
   XCC_ARR_ALLOC(xcc_link, bound)
@@ -250,41 +253,88 @@ xcc_choose_i_naively(xcc_algorithm* a, xcc_problem* p) {
 
 xcc_link
 xcc_choose_i_mrv(xcc_algorithm* a, xcc_problem* p) {
-  xcc_link i = RLINK(0);
-  xcc_link p_ = RLINK(0), theta = XCC_LINK_MAX;
-  while(p_ != 0) {
-    xcc_link lambda = LEN(p_);
-    if(lambda < theta) {
-      theta = lambda;
-      i = p_;
-    }
-    if(lambda == 0) {
-      return i;
-    }
-    p_ = RLINK(p_);
-  }
-  return i;
+  return xcc_choose_mrv(p);
 }
 
 xcc_link
 xcc_choose_i_mrv_slacker(xcc_algorithm* a, xcc_problem* p) {
-  xcc_link theta = XCC_LINK_MAX;
+  return xcc_choose_mrv_slacker(p);
+}
+
+static void
+bump_weight(xcc_problem* p, xcc_link i) {
+  p->weight[i] += p->weight_bump;
+  p->weight_bump /= XCC_WEIGHT_DECAY;
+  if(p->weight_bump > 1e100) {
+    // Rescale before the weights overflow, which keeps their ratios.
+    for(xcc_link j = 1; j <= p->N_1; ++j)
+      p->weight[j] *= 1e-100;
+    p->weight_bump *= 1e-100;
+  }
+}
+
+xcc_link
+xcc_choose_i_weighted(xcc_algorithm* a, xcc_problem* p) {
+  if(!p->weight) {
+    p->weight = malloc((p->N_1 + 1) * sizeof(double));
+    for(xcc_link j = 0; j <= p->N_1; ++j)
+      p->weight[j] = 1;
+    p->weight_bump = 1;
+  }
+
   xcc_link i = RLINK(0);
-  xcc_link p_ = RLINK(0);
-  while(p_ != 0) {
-    xcc_link lambda = THETA(p_);
-    if(lambda < theta || (lambda == theta && SLACK(p_) == SLACK(i)) ||
-       (lambda == theta && SLACK(p_) == SLACK(i) && LEN(p_) > LEN(i))) {
-      theta = lambda;
+  double best = HUGE_VAL;
+  for(xcc_link p_ = RLINK(0); p_ != 0; p_ = RLINK(p_)) {
+    // Only active items of M have a bound, X and C count options.
+    xcc_link lambda = BOUND(p_) == 0 ? LEN(p_) : THETA(p_);
+    if(lambda == 0) {
+      bump_weight(p, p_);
+      return p_;
+    }
+    double score = lambda == 1 ? 0 : lambda / p->weight[p_];
+    if(score < best) {
+      best = score;
       i = p_;
-      assert(i <= p->primary_item_count);
     }
-    p_ = RLINK(p_);
   }
-  assert(i <= p->primary_item_count);
   return i;
 }
 
+void
+xcc_mrv_buckets_allocate(xcc_problem* p) {
+  xcc_link buckets = 0;
+  for(xcc_link i = RLINK(0); i != 0; i = RLINK(i))
+    buckets = MAX(buckets, LEN(i) + 1);
+
+  p->bucket_count = buckets;
+  p->bucket = realloc(p->bucket, (p->N_1 + 1 + buckets) * sizeof(xcc_bucket));
+  p->buckets = false;
+}
+
+void
+xcc_mrv_buckets_init(xcc_problem* p) {
+  memset(p->bucket, 0, (p->N_1 + 1) * sizeof(xcc_bucket));
+  for(xcc_link h = BUCKET_HEAD(0); h < BUCKET_HEAD(p->bucket_count); ++h)
+    p->bucket[h].next = p->bucket[h].prev = h;
+  p->bucket_min = p->bucket_count;
+  p->buckets = true;
+
+  // Insertion is at the front, so this keeps ties in item order at first.
+  for(xcc_link i = LLINK(0); i != 0; i = LLINK(i))
+    xcc_bucket_insert(p, i);
+}
+
+xcc_heuristic
+xcc_heuristic_of(xcc_choose_i choose_i) {
+  if(choose_i == &xcc_choose_i_naively)
+    return XCC_HEURISTIC_NAIVE;
+  if(choose_i == &xcc_choose_i_mrv)
+    return XCC_HEURISTIC_MRV;
+  if(choose_i == &xcc_choose_i_mrv_slacker)
+    return XCC_HEURISTIC_MRV_SLACKER;
+  return XCC_HEURISTIC_CUSTOM;
+}
+
 void
 xcc_algorithm_standard_functions(xcc_algorithm* a) {
   a->add_item = &add_item;
@@ -313,6 +363,12 @@ xcc_algorithm_from_select(int algorithm_select, xcc_algorithm* algorithm) {
   } else if(algorithm_select & XCC_ALGORITHM_C) {
     xcc_algorithm_c_set(algorithm);
     success = true;
+  } else if(algorithm_select & XCC_ALGORITHM_DC) {
+    xcc_algorithm_dc_set(algorithm);
+    success = true;
+  } else if(algorithm_select & XCC_ALGORITHM_BITSET) {
+    xcc_algorithm_bitset_set(algorithm);
+    success = true;
   } else if(algorithm_select & XCC_ALGORITHM_M) {
     xcc_algorithm_m_set(algorithm);
     // Set default for Algorithm M. May be overriden, as it is later the first
@@ -335,10 +391,44 @@ xcc_algorithm_from_select(int algorithm_select, xcc_algorithm* algorithm) {
   if(algorithm_select & XCC_ALGORITHM_MRV) {
     algorithm->choose_i = &xcc_choose_i_mrv;
   }
+  if(algorithm_select & XCC_ALGORITHM_WEIGHTED) {
+    algorithm->choose_i = &xcc_choose_i_weighted;
+  }
+
+  // Now that the heuristic is known, switch to the kernel compiled for it.
+  if(algorithm_select & XCC_ALGORITHM_X)
+    xcc_algorithm_x_specialize(algorithm);
+  else if(algorithm_select & XCC_ALGORITHM_C)
+    xcc_algorithm_c_specialize(algorithm);
+  else if(algorithm_select & XCC_ALGORITHM_M &&
+          !(algorithm_select & (XCC_ALGORITHM_DC | XCC_ALGORITHM_BITSET)))
+    xcc_algorithm_m_specialize(algorithm);
 
   return success;
 }
 
+void
+xcc_algorithm_use_bitsets(int algorithm_select,
+                          xcc_algorithm* algorithm,
+                          xcc_problem* p) {
+  // The bitset engine always uses MRV, so only X and C with MRV may switch.
+  if(algorithm_select & (XCC_ALGORITHM_NO_BITSET | XCC_ALGORITHM_NAIVE |
+                         XCC_ALGORITHM_MRV_SLACKER | XCC_ALGORITHM_WEIGHTED))
+    return;
+  bool with_colors;
+  if(algorithm_select & XCC_ALGORITHM_X)
+    with_colors = false;
+  else if(algorithm_select & XCC_ALGORITHM_C)
+    with_colors = true;
+  else
+    return;
+
+  if(xcc_algorithm_bitset_supports(p, with_colors))
+    xcc_algorithm_bitset_set(algorithm);
+  else
+    p->tail_items = XCC_BITSET_TAIL_ITEMS;
+}
+
 struct xcc_algorithm*
 xcc_algorithm_allocate() {
   return calloc(1, sizeof(xcc_algorithm));
@@ -358,6 +448,20 @@ xcc_algorithm_c_allocate() {
   return a;
 }
 
+xcc_algorithm*
+xcc_algorithm_dc_allocate() {
+  xcc_algorithm* a = xcc_algorithm_allocate();
+  xcc_algorithm_dc_set(a);
+  return a;
+}
+
+xcc_algorithm*
+xcc_algorithm_bitset_allocate() {
+  xcc_algorithm* a = xcc_algorithm_allocate();
+  xcc_algorithm_bitset_set(a);
+  return a;
+}
+
 xcc_algorithm*
 xcc_algorithm_m_allocate() {
   xcc_algorithm* a = xcc_algorithm_allocate();
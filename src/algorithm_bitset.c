@@ -0,0 +1,540 @@
+/*
+    XCCSolve - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <xcc/algorithm.h>
+#include <xcc/algorithm_bitset.h>
+#include <xcc/ops.h>
+
+// XCC solving with bitsets, for problems with few items.
+//
+// Every item has a bitmap of the options it occurs in. Every node of an option
+// has a conflict mask: the options that must be removed if the option is
+// selected. For primary and uncolored secondary items, that is the bitmap of
+// the item, for colored secondary items only the options with another color.
+// The search keeps the live options and the uncovered primary items of every
+// level, so selecting an option is just an ANDNOT per node and backtracking
+// is free. Like Algorithms X and C with MRV, items are chosen by the smallest
+// number of live options (ties to the first item) and options are tried in
+// input order, so solutions are found in the same order.
+//
+// The bitset problem is either built from the whole xcc_problem, or from the
+// items and options that are still active in the DLX matrix, which finishes
+// the subtree of Algorithm X or C at the current level.
+
+typedef uint64_t bs_word;
+
+#define BS_BITS 64
+#define BS_ITEM_WORDS (XCC_BITSET_MAX_ITEMS / BS_BITS)
+
+typedef enum bs_state { B1, B2, B3, B4 } bs_state;
+
+typedef struct bs {
+  xcc_link items;
+  xcc_link primaries;
+  xcc_link options;
+  xcc_link words;
+  bool with_colors;
+
+  // Options are ranges of nodes. Every node stores its node in the DLX matrix
+  // and the index of its conflict mask. The first masks are the bitmaps of the
+  // items (primary ones first), after them come the masks of colored items.
+  xcc_link* option_begin;
+  xcc_link* node_x;
+  xcc_link* node_mask;
+  bs_word* masks;
+
+  // Search state. Levels are counted from level base of the xcc_problem.
+  int state;
+  xcc_link base;
+  xcc_link l;
+  bs_word* live;
+  bs_word* uncovered;
+  xcc_link* branch_item;
+  xcc_link* branch_option;
+
+  // Input of build(): the index of every item of the DLX matrix (or -1 if it
+  // is inactive) and the first node of every option.
+  xcc_link* item_map;
+  xcc_link* item_dlx;
+  xcc_link* option_first;
+  size_t* option_stamp;
+  size_t stamp;
+  xcc_link rejected_level;
+
+  // Colored items get masks per distinct pair of item and color.
+  xcc_link* pair_head;
+  xcc_link* pair_next;
+  xcc_link* pair_item;
+  xcc_color* pair_color;
+
+  size_t option_capacity;
+  size_t node_capacity;
+  size_t mask_capacity;
+  size_t live_capacity;
+  size_t level_capacity;
+} bs;
+
+#define BS_MASK(I) (b->masks + (size_t)(I)*b->words)
+#define BS_LIVE(L) (b->live + (size_t)(L)*b->words)
+#define BS_UNCOVERED(L) (b->uncovered + (size_t)(L)*BS_ITEM_WORDS)
+
+// Bitsets only pay off if the columns of the primary items are long compared
+// to the bitmaps of the options, otherwise dancing links touch less memory.
+static inline bool
+dense_enough(size_t column_nodes, size_t primaries, size_t options) {
+  size_t words = (options + BS_BITS - 1) / BS_BITS;
+  return column_nodes >= XCC_BITSET_MIN_DENSITY * words * primaries;
+}
+
+bool
+xcc_algorithm_bitset_supports(xcc_problem* p, bool with_colors) {
+  if(p->N > XCC_BITSET_MAX_ITEMS || p->M == 0)
+    return false;
+  size_t column_nodes = 0;
+  for(xcc_link i = 1; i <= p->N_1; ++i)
+    column_nodes += LEN(i);
+  if(!dense_enough(column_nodes, p->N_1, p->M))
+    return false;
+  if(!with_colors) {
+    for(xcc_link x = p->N + 2; x < p->Z; ++x)
+      if(TOP(x) > 0 && COLOR(x) != 0)
+        return false;
+  }
+  return true;
+}
+
+static bs*
+create_bs(xcc_problem* p, bool with_colors) {
+  bs* b = calloc(1, sizeof(bs));
+  b->with_colors = with_colors;
+  b->item_map = calloc(p->N + 1, sizeof(xcc_link));
+  b->item_dlx = calloc(p->N + 1, sizeof(xcc_link));
+  b->pair_head = calloc(p->N + 1, sizeof(xcc_link));
+  b->option_first = calloc(p->M + 1, sizeof(xcc_link));
+  b->option_stamp = calloc(p->M + 1, sizeof(size_t));
+  for(xcc_link j = 0; j <= p->N; ++j)
+    b->item_map[j] = -1;
+  return b;
+}
+
+void
+xcc_bitset_free_userdata(xcc_algorithm* a, xcc_problem* p) {
+  bs* b = p->algorithm_userdata;
+  if(!b)
+    return;
+  free(b->option_begin);
+  free(b->node_x);
+  free(b->node_mask);
+  free(b->masks);
+  free(b->live);
+  free(b->uncovered);
+  free(b->branch_item);
+  free(b->branch_option);
+  free(b->item_map);
+  free(b->item_dlx);
+  free(b->option_first);
+  free(b->option_stamp);
+  free(b->pair_head);
+  free(b->pair_next);
+  free(b->pair_item);
+  free(b->pair_color);
+  free(b);
+  p->algorithm_userdata = NULL;
+}
+
+static xcc_link
+find_pair(bs* b, xcc_link j, xcc_color c, xcc_link* pairs) {
+  xcc_link k = b->pair_head[j];
+  while(k >= 0 && b->pair_color[k] != c)
+    k = b->pair_next[k];
+  if(k < 0) {
+    k = (*pairs)++;
+    b->pair_item[k] = j;
+    b->pair_color[k] = c;
+    b->pair_next[k] = b->pair_head[j];
+    b->pair_head[j] = k;
+  }
+  return k;
+}
+
+// Builds the bitset problem from the options in option_first, restricted to
+// the items with an index in item_map, and prepares the search.
+static void
+build(xcc_problem* p, bs* b) {
+  size_t nodes = 0;
+  for(xcc_link o = 0; o < b->options; ++o)
+    for(xcc_link x = b->option_first[o]; TOP(x) > 0; ++x)
+      if(b->item_map[TOP(x)] >= 0)
+        ++nodes;
+
+  // The arrays are kept between builds and only grow.
+  if((size_t)b->options + 1 > b->option_capacity) {
+    b->option_capacity = b->options + 1;
+    b->option_begin =
+      realloc(b->option_begin, b->option_capacity * sizeof(xcc_link));
+  }
+  if(nodes > b->node_capacity) {
+    b->node_capacity = nodes;
+    b->node_x = realloc(b->node_x, nodes * sizeof(xcc_link));
+    b->node_mask = realloc(b->node_mask, nodes * sizeof(xcc_link));
+    b->pair_next = realloc(b->pair_next, nodes * sizeof(xcc_link));
+    b->pair_item = realloc(b->pair_item, nodes * sizeof(xcc_link));
+    b->pair_color = realloc(b->pair_color, nodes * sizeof(xcc_color));
+  }
+
+  for(xcc_link k = 0; k < b->items; ++k)
+    b->pair_head[k] = -1;
+
+  xcc_link n = 0, pairs = 0;
+  for(xcc_link o = 0; o < b->options; ++o) {
+    b->option_begin[o] = n;
+    for(xcc_link x = b->option_first[o]; TOP(x) > 0; ++x) {
+      xcc_link k = b->item_map[TOP(x)];
+      if(k < 0)
+        continue;
+      b->node_x[n] = x;
+      if(k < b->primaries || !b->with_colors || COLOR(x) == 0)
+        b->node_mask[n] = k;
+      else
+        b->node_mask[n] = b->items + find_pair(b, k, COLOR(x), &pairs);
+      ++n;
+    }
+  }
+  b->option_begin[b->options] = n;
+
+  b->words = (b->options + BS_BITS - 1) / BS_BITS;
+  size_t masks = (size_t)(b->items + pairs) * b->words;
+  if(masks > b->mask_capacity) {
+    b->mask_capacity = masks;
+    b->masks = realloc(b->masks, masks * sizeof(bs_word));
+  }
+  memset(b->masks, 0, masks * sizeof(bs_word));
+
+  for(xcc_link o = 0; o < b->options; ++o) {
+    bs_word bit = (bs_word)1 << (o % BS_BITS);
+    for(xcc_link n = b->option_begin[o]; n < b->option_begin[o + 1]; ++n) {
+      xcc_link m = b->node_mask[n];
+      if(m >= b->items) {
+        BS_MASK(b->pair_item[m - b->items])[o / BS_BITS] |= bit;
+        BS_MASK(m)[o / BS_BITS] |= bit;
+      } else {
+        BS_MASK(m)[o / BS_BITS] |= bit;
+      }
+    }
+  }
+  for(xcc_link k = 0; k < pairs; ++k) {
+    // Up to now, the mask contains the options with the same color.
+    bs_word* m = BS_MASK(b->items + k);
+    const bs_word* all = BS_MASK(b->pair_item[k]);
+    for(xcc_link w = 0; w < b->words; ++w)
+      m[w] = all[w] & ~m[w];
+  }
+
+  size_t levels = b->primaries + 1;
+  if(levels * b->words > b->live_capacity) {
+    b->live_capacity = levels * b->words;
+    b->live = realloc(b->live, b->live_capacity * sizeof(bs_word));
+  }
+  if(levels > b->level_capacity) {
+    b->level_capacity = levels;
+    b->uncovered =
+      realloc(b->uncovered, levels * BS_ITEM_WORDS * sizeof(bs_word));
+    b->branch_item = realloc(b->branch_item, levels * sizeof(xcc_link));
+    b->branch_option = realloc(b->branch_option, levels * sizeof(xcc_link));
+  }
+
+  bs_word* live = BS_LIVE(0);
+  memset(live, 0, b->words * sizeof(bs_word));
+  for(xcc_link o = 0; o < b->options; ++o)
+    live[o / BS_BITS] |= (bs_word)1 << (o % BS_BITS);
+  bs_word* uncovered = BS_UNCOVERED(0);
+  memset(uncovered, 0, BS_ITEM_WORDS * sizeof(bs_word));
+  for(xcc_link k = 0; k < b->primaries; ++k)
+    uncovered[k / BS_BITS] |= (bs_word)1 << (k % BS_BITS);
+
+  b->base = p->l;
+  b->l = 0;
+  b->state = B2;
+}
+
+static inline bool
+all_covered(const bs_word* uncovered) {
+  bs_word any = 0;
+  for(xcc_link w = 0; w < BS_ITEM_WORDS; ++w)
+    any |= uncovered[w];
+  return any == 0;
+}
+
+static xcc_link
+choose_i(bs* b, xcc_link l) {
+  const bs_word* live = BS_LIVE(l);
+  const bs_word* uncovered = BS_UNCOVERED(l);
+  xcc_link i = 0;
+  xcc_link theta = XCC_LINK_MAX;
+  for(xcc_link w = 0; w < BS_ITEM_WORDS; ++w) {
+    for(bs_word bits = uncovered[w]; bits; bits &= bits - 1) {
+      xcc_link k = w * BS_BITS + __builtin_ctzll(bits);
+      const bs_word* m = BS_MASK(k);
+      xcc_link lambda = 0;
+      for(xcc_link v = 0; v < b->words && lambda < theta; ++v)
+        lambda += __builtin_popcountll(m[v] & live[v]);
+      if(lambda < theta) {
+        theta = lambda;
+        i = k;
+        if(lambda == 0)
+          return i;
+      }
+    }
+  }
+  return i;
+}
+
+// Returns the first live option of item i at or after option o, or -1.
+static inline xcc_link
+next_option(bs* b, xcc_link l, xcc_link i, xcc_link o) {
+  const bs_word* m = BS_MASK(i);
+  const bs_word* live = BS_LIVE(l);
+  xcc_link w = o / BS_BITS;
+  if(w >= b->words)
+    return -1;
+  bs_word bits = m[w] & live[w] & (~(bs_word)0 << (o % BS_BITS));
+  while(!bits) {
+    if(++w >= b->words)
+      return -1;
+    bits = m[w] & live[w];
+  }
+  return w * BS_BITS + __builtin_ctzll(bits);
+}
+
+// Select option o on level l, which computes the state of level l + 1.
+static inline void
+select_option(bs* b, xcc_link l, xcc_link o) {
+  const bs_word* live = BS_LIVE(l);
+  bs_word* next = BS_LIVE(l + 1);
+  memcpy(next, live, b->words * sizeof(bs_word));
+  memcpy(BS_UNCOVERED(l + 1), BS_UNCOVERED(l), BS_ITEM_WORDS * sizeof(bs_word));
+  bs_word* uncovered = BS_UNCOVERED(l + 1);
+
+  for(xcc_link n = b->option_begin[o]; n < b->option_begin[o + 1]; ++n) {
+    xcc_link k = b->node_mask[n];
+    const bs_word* m = BS_MASK(k);
+    for(xcc_link w = 0; w < b->words; ++w)
+      next[w] &= ~m[w];
+    if(k < b->primaries)
+      uncovered[k / BS_BITS] &= ~((bs_word)1 << (k % BS_BITS));
+  }
+}
+
+// Writes the nodes of the current solution to x, after the levels of the
+// problem before the bitset search started.
+static void
+write_solution(xcc_problem* p, bs* b) {
+  for(xcc_link l = 0; l < b->l; ++l) {
+    xcc_link o = b->branch_option[l];
+    xcc_link n = b->option_begin[o];
+    while(b->node_mask[n] != b->branch_item[l])
+      ++n;
+    p->x[b->base + l] = b->node_x[n];
+    if(b->with_colors)
+      xcc_set_item_colors(p, b->node_x[n]);
+  }
+  p->l = b->base + b->l;
+  p->x_size = p->l;
+}
+
+static xcc_bitset_result
+search(xcc_problem* p, bs* b) {
+  p->l = b->base;
+
+  while(true) {
+    switch(b->state) {
+      case B2:
+        // Enter level l
+        if(p->node_limit && p->nodes >= p->node_limit)
+          return XCC_BITSET_INTERRUPTED;
+        if(all_covered(BS_UNCOVERED(b->l))) {
+          write_solution(p, b);
+          b->state = B4;
+          return XCC_BITSET_SOLUTION;
+        }
+        ++p->nodes;
+        b->branch_item[b->l] = choose_i(b, b->l);
+        b->branch_option[b->l] = -1;
+        b->state = B3;
+        break;
+      case B3: {
+        // Try the next option of the chosen item
+        xcc_link o =
+          next_option(b, b->l, b->branch_item[b->l], b->branch_option[b->l] + 1);
+        if(o < 0) {
+          b->state = B4;
+          break;
+        }
+        b->branch_option[b->l] = o;
+        select_option(b, b->l, o);
+        ++b->l;
+        b->state = B2;
+        break;
+      }
+      case B4:
+        // Backtrack
+        if(b->l == 0)
+          return XCC_BITSET_DONE;
+        --b->l;
+        b->state = B3;
+        break;
+    }
+  }
+}
+
+static int
+compare_links(const void* a, const void* b) {
+  xcc_link l = *(const xcc_link*)a, r = *(const xcc_link*)b;
+  return (l > r) - (l < r);
+}
+
+bool
+xcc_bitset_tail_start(xcc_problem* p, bool with_colors) {
+  bs* b = p->algorithm_userdata;
+  if(!b) {
+    p->algorithm_userdata = b = create_bs(p, with_colors);
+    b->rejected_level = XCC_LINK_MAX;
+  }
+
+  // Below a level where bitsets were rejected, the columns only get shorter.
+  if(p->l > b->rejected_level)
+    return false;
+
+  for(xcc_link k = 0; k < b->items; ++k)
+    b->item_map[b->item_dlx[k]] = -1;
+
+  xcc_link k = 0;
+  size_t column_nodes = 0;
+  for(xcc_link i = RLINK(0); i != 0; i = RLINK(i)) {
+    b->item_map[i] = k;
+    b->item_dlx[k++] = i;
+    column_nodes += LEN(i);
+  }
+  b->primaries = k;
+  for(xcc_link i = RLINK(p->N + 1); i != p->N + 1; i = RLINK(i)) {
+    b->item_map[i] = k;
+    b->item_dlx[k++] = i;
+  }
+  b->items = k;
+
+  // Every live option is in the list of one of its primary items. The
+  // options are sorted by their position, as Algorithms X and C try them.
+  ++b->stamp;
+  b->options = 0;
+  for(xcc_link i = RLINK(0); i != 0; i = RLINK(i)) {
+    for(xcc_link x = DLINK(i); x != i; x = DLINK(x)) {
+      xcc_link first = x;
+      while(TOP(first - 1) > 0)
+        --first;
+      xcc_link o = -TOP(first - 1);
+      if(b->option_stamp[o] != b->stamp) {
+        b->option_stamp[o] = b->stamp;
+        b->option_first[b->options++] = first;
+      }
+    }
+  }
+
+  if(!dense_enough(column_nodes, b->primaries, b->options)) {
+    b->rejected_level = p->l;
+    return false;
+  }
+  b->rejected_level = XCC_LINK_MAX;
+
+  qsort(b->option_first, b->options, sizeof(xcc_link), &compare_links);
+
+  build(p, b);
+  return true;
+}
+
+xcc_bitset_result
+xcc_bitset_tail_next(xcc_problem* p) {
+  return search(p, p->algorithm_userdata);
+}
+
+static bool
+compute_next_result(xcc_algorithm* a, xcc_problem* p) {
+  if(p->x_capacity < p->option_count) {
+    p->x = realloc(p->x, sizeof(xcc_link) * p->option_count);
+    p->x_capacity = p->option_count;
+    p->x_size = 0;
+  }
+
+  p->interrupted = false;
+
+  bs* b = p->algorithm_userdata;
+
+  if(p->state == B1) {
+    xcc_link i = 0;
+    do {
+      i = RLINK(i);
+      if(DLINK(i) == 0 && ULINK(i) == 0) {
+        fprintf(stderr, "Some item never occurs in the options!\n");
+        return false;
+      }
+    } while(RLINK(i) != 0);
+
+    if(!b) {
+      p->algorithm_userdata = b = create_bs(p, true);
+      for(xcc_link j = 1; j <= p->N; ++j) {
+        b->item_map[j] = j - 1;
+        b->item_dlx[j - 1] = j;
+      }
+      b->items = p->N;
+      b->primaries = p->N_1;
+      // Options removed at the root, e.g. by symmetry breaking, are only
+      // unlinked from their items and have no row.
+      b->options = 0;
+      for(xcc_link x = p->N + 1; x < p->Z; ++x)
+        if(TOP(x) <= 0 && DLINK(ULINK(x + 1)) == x + 1)
+          b->option_first[b->options++] = x + 1;
+    }
+
+    p->l = 0;
+    build(p, b);
+    p->state = B2;
+  }
+
+  switch(search(p, b)) {
+    case XCC_BITSET_SOLUTION:
+      return true;
+    case XCC_BITSET_INTERRUPTED:
+      p->interrupted = true;
+      return false;
+    case XCC_BITSET_DONE:
+      return false;
+  }
+  return false;
+}
+
+void
+xcc_algorithm_bitset_set(xcc_algorithm* a) {
+  xcc_algorithm_standard_functions(a);
+
+  a->compute_next_result = &compute_next_result;
+  a->free_userdata = &xcc_bitset_free_userdata;
+}
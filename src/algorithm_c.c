@@ -21,111 +21,384 @@
 #include <string.h>
 
 #include <xcc/algorithm.h>
+#include <xcc/algorithm_bitset.h>
 #include <xcc/algorithm_c.h>
+#include <xcc/cost.h>
+#include <xcc/nogood.h>
 #include <xcc/ops.h>
 
-typedef enum c_state { C1, C2, C3, C4, C5, C6, C7, C8 } c_state;
+typedef enum c_state { C1, C2, C3, C4, C5, C6, C7, C8, C9 } c_state;
 
-static bool
-compute_next_result(xcc_algorithm* a, xcc_problem* p) {
+// The search kernel, instantiated like the one of Algorithm X.
+static XCC_ALWAYS_INLINE bool
+compute(xcc_algorithm* a,
+        xcc_problem* p,
+        xcc_heuristic h,
+        bool buckets,
+        bool extended) {
   if(p->x_capacity < p->option_count) {
     p->x = realloc(p->x, sizeof(xcc_link) * p->option_count);
     p->x_capacity = p->option_count;
     p->x_size = 0;
   }
 
-  assert(a->choose_i);
+  assert(h != XCC_HEURISTIC_CUSTOM || a->choose_i);
+
+  p->interrupted = false;
+
+  xcc_link* x = p->x;
+  c_state state = p->state;
+  xcc_link i = p->i;
+  int l = p->l;
+  int primaries_left = p->primaries_left;
+  size_t nodes = p->nodes;
+  size_t forced = p->forced;
+
+#define SAVE()                           \
+  do {                                   \
+    p->state = state;                    \
+    p->i = i;                            \
+    p->l = l;                            \
+    p->primaries_left = primaries_left;  \
+    p->nodes = nodes;                    \
+    p->forced = forced;                  \
+  } while(0)
+// Whether covering has to keep the MRV buckets up to date.
+#define BUCKETS (buckets && p->buckets)
+// Whether covering and committing have to keep the key of the nogood cache up
+// to date.
+#define NOGOODS (extended && p->nogoods)
+// Whether selecting options has to keep the cost of the search up to date.
+#define COSTS (extended && p->costs)
+#define COVER_N(I)                       \
+  do {                                   \
+    COVER_PRIME_B(I, BUCKETS);           \
+    if(NOGOODS)                          \
+      xcc_nogoods_toggle(p->nogoods, I); \
+  } while(0)
+#define UNCOVER_N(I)                     \
+  do {                                   \
+    UNCOVER_PRIME_B(I, BUCKETS);         \
+    if(NOGOODS)                          \
+      xcc_nogoods_toggle(p->nogoods, I); \
+  } while(0)
+#define COMMIT_N(Q, J)                                    \
+  do {                                                    \
+    COMMIT_B(Q, J, BUCKETS);                              \
+    if(NOGOODS)                                           \
+      xcc_nogoods_commit(p->nogoods, J, COLOR(Q), false); \
+  } while(0)
+#define UNCOMMIT_N(Q, J)                                 \
+  do {                                                   \
+    UNCOMMIT_B(Q, J, BUCKETS);                           \
+    if(NOGOODS)                                          \
+      xcc_nogoods_commit(p->nogoods, J, COLOR(Q), true); \
+  } while(0)
+#define LOAD()        \
+  do {                \
+    l = p->l;         \
+    nodes = p->nodes; \
+  } while(0)
 
   while(true) {
-    // State print:
-    // printf("State: %d i:%d l:%d x[0]:%d\n", p->state, p->i, p->l, p->x[0]);
-    switch(p->state) {
+    switch(state) {
       case C1: {
-        xcc_link i = 0;
+        xcc_link j = 0;
         do {
-          i = RLINK(i);
-          if(DLINK(i) == 0 && ULINK(i) == 0) {
+          j = RLINK(j);
+          if(DLINK(j) == 0 && ULINK(j) == 0) {
             fprintf(stderr, "Some item never occurs in the options!\n");
             return false;
           }
-        } while(RLINK(i) != 0);
+        } while(RLINK(j) != 0);
+
+        p->buckets = false;
+        if(buckets)
+          xcc_mrv_buckets_allocate(p);
 
-        p->l = 0;
-        p->state = C2;
-        p->i = 0;
+        l = 0;
+        primaries_left = p->N_1;
+        state = C2;
+        i = 0;
         break;
       }
       case C2:
+        if(p->node_limit && nodes >= p->node_limit) {
+          p->interrupted = true;
+          if(p->restart) {
+            p->fixed = l;// Backtrack to the root, trying no other branch
+            state = C8;
+            break;
+          }
+          SAVE();
+          return false;
+        }
         if(RLINK(0) == 0) {
-          p->state = C8;
-          p->x_size = p->l;
+          state = C8;
+          if(p->lds && p->discrepancies < p->discrepancy_limit)
+            break;// Reported by an earlier iteration
+          if(NOGOODS)
+            ++p->nogoods->solutions;
+          p->x_size = l;
+          SAVE();
           return true;
         }
-        p->state = C3;
+        if(primaries_left <= p->tail_items && l >= p->prefix_size) {
+          SAVE();
+          if(xcc_bitset_tail_start(p, true)) {
+            state = C9;
+            break;
+          }
+        }
+        state = C3;
         break;
       case C3:
-        p->i = a->choose_i(a, p);
-        p->state = C4;
+        if(l < p->prefix_size) {
+          xcc_link n = p->prefix[l];
+          i = n <= p->N ? n : TOP(n);
+        } else {
+          if(NOGOODS) {
+            if(xcc_nogoods_lookup(p->nogoods)) {
+              state = C8;
+              break;
+            }
+            xcc_nogoods_enter(p->nogoods, l, nodes);
+          }
+          if(h == XCC_HEURISTIC_CUSTOM)
+            SAVE();
+          if(buckets)
+            xcc_mrv_buckets_adapt(p, primaries_left);
+          i = xcc_choose(h, a, p);
+          if(LEN(i) == 1) {
+            if(COSTS && xcc_costs_exceed(p->costs, DLINK(i))) {
+              ++p->costs->pruned;
+              state = C8;
+              break;
+            }
+            // Forced, applied without a node of its own like in Algorithm X.
+            ++forced;
+            COVER_N(i);
+            --primaries_left;
+            x[l] = DLINK(i);
+            if(COSTS)
+              xcc_costs_select(p->costs, x[l], false);
+            for(xcc_link q = x[l] + 1; q != x[l];) {
+              xcc_link j = TOP(q);
+              if(j <= 0) {
+                q = ULINK(q);
+              } else {
+                COMMIT_N(q, j);
+                if(j <= p->N_1)
+                  --primaries_left;
+                q = q + 1;
+              }
+            }
+            l = l + 1;
+            if(RLINK(0) == 0 || primaries_left <= p->tail_items)
+              state = C2;
+            break;
+          }
+        }
+        ++nodes;
+        state = C4;
         break;
       case C4:
-        COVER_PRIME(p->i);
-        p->x[p->l] = DLINK(p->i);
-        p->state = C5;
+        COVER_N(i);
+        --primaries_left;
+        x[l] = DLINK(i);
+        state = C5;
         break;
       case C5:
-        if(p->x[p->l] == p->i) {
-          p->state = C7;
+        if(x[l] == i) {
+          state = C7;
+          break;
+        }
+        if(xcc_skip_for_prefix(p, l)) {
+          x[l] = DLINK(x[l]);
           break;
         }
-        p->p = p->x[p->l] + 1;
-        while(p->p != p->x[p->l]) {
-          xcc_link j = TOP(p->p);
+        if(COSTS) {
+          if(xcc_costs_exceed(p->costs, x[l])) {
+            ++p->costs->pruned;
+            // The options of i are sorted by cost.
+            if(xcc_costs_exhausted(p->costs, x[l])) {
+              state = C7;
+              break;
+            }
+            x[l] = DLINK(x[l]);
+            break;
+          }
+          xcc_costs_select(p->costs, x[l], false);
+        }
+        for(xcc_link q = x[l] + 1; q != x[l];) {
+          xcc_link j = TOP(q);
           if(j <= 0) {
-            p->p = ULINK(p->p);
+            q = ULINK(q);
           } else {
-            COMMIT(p->p, j);
-            p->p = p->p + 1;
+            COMMIT_N(q, j);
+            if(j <= p->N_1)
+              --primaries_left;
+            q = q + 1;
           }
         }
-        p->l = p->l + 1;
-        p->state = C2;
+        l = l + 1;
+        state = C2;
         break;
       case C6:
-        p->p = p->x[p->l] - 1;
-        while(p->p != p->x[p->l]) {
-          xcc_link j = TOP(p->p);
+        for(xcc_link q = x[l] - 1; q != x[l];) {
+          xcc_link j = TOP(q);
           if(j <= 0) {
-            p->p = DLINK(p->p);
+            q = DLINK(q);
           } else {
-            UNCOMMIT(p->p, j);
-            p->p = p->p - 1;
+            UNCOMMIT_N(q, j);
+            if(j <= p->N_1)
+              ++primaries_left;
+            q = q - 1;
+          }
+        }
+        if(COSTS)
+          xcc_costs_select(p->costs, x[l], true);
+        i = TOP(x[l]);
+        if(l < p->fixed || DLINK(x[l]) == i) {
+          state = C7;
+          break;
+        }
+        if(p->lds && ULINK(x[l]) == i) {
+          // Leaving the first option is a discrepancy, see Algorithm X.
+          if(p->discrepancies == p->discrepancy_limit) {
+            p->discrepancy_cut = true;
+            state = C7;
+            break;
           }
+          ++p->discrepancies;
         }
-        p->i = TOP(p->x[p->l]);
-        p->x[p->l] = DLINK(p->x[p->l]);
-        p->state = C5;
+        x[l] = DLINK(x[l]);
+        state = C5;
         break;
       case C7:
-        UNCOVER_PRIME(p->i);
-        p->state = C8;
+        if(p->lds && x[l] != i && ULINK(x[l]) != i)
+          --p->discrepancies;
+        UNCOVER_N(i);
+        ++primaries_left;
+        // The sub-problem of level l is exhausted, see Algorithm X.
+        if(NOGOODS && !COSTS && l >= p->fixed && !p->interrupted &&
+           DLINK(i) != i)
+          xcc_nogoods_leave(p->nogoods, l, nodes);
+        state = C8;
         break;
       case C8:
-        if(p->l == 0) {
+        if(l == 0) {
+          if(p->lds && p->discrepancy_cut) {
+            // Search again, allowing one more discrepancy.
+            ++p->discrepancy_limit;
+            p->discrepancy_cut = false;
+            state = C1;
+            break;
+          }
+          SAVE();
           return false;
         }
-        p->l = p->l - 1;
-        p->state = C6;
+        l = l - 1;
+        state = C6;
+        break;
+      case C9:
+        // Finish the subtree of level l with bitsets
+        SAVE();
+        switch(xcc_bitset_tail_next(p)) {
+          case XCC_BITSET_SOLUTION:
+            if(NOGOODS)
+              ++p->nogoods->solutions;
+            return true;
+          case XCC_BITSET_INTERRUPTED:
+            p->interrupted = true;
+            return false;
+          case XCC_BITSET_DONE:
+            LOAD();
+            state = C8;
+            break;
+        }
         break;
     }
   }
 
+#undef SAVE
+#undef LOAD
+#undef BUCKETS
+#undef NOGOODS
+#undef COSTS
+#undef COVER_N
+#undef UNCOVER_N
+#undef COMMIT_N
+#undef UNCOMMIT_N
+
   return false;
 }
 
+static bool
+compute_next_result(xcc_algorithm* a, xcc_problem* p) {
+  return compute(a, p, XCC_HEURISTIC_CUSTOM, false, true);
+}
+
+static bool
+compute_next_result_naive(xcc_algorithm* a, xcc_problem* p) {
+  return compute(a, p, XCC_HEURISTIC_NAIVE, false, true);
+}
+
+static XCC_NOINLINE bool
+compute_next_result_mrv_scan(xcc_algorithm* a, xcc_problem* p) {
+  return compute(a, p, XCC_HEURISTIC_MRV, false, false);
+}
+
+static XCC_NOINLINE bool
+compute_next_result_mrv_buckets(xcc_algorithm* a, xcc_problem* p) {
+  return compute(a, p, XCC_HEURISTIC_MRV, true, false);
+}
+
+static XCC_NOINLINE bool
+compute_next_result_mrv_extended(xcc_algorithm* a, xcc_problem* p) {
+  return compute(
+    a, p, XCC_HEURISTIC_MRV, p->N_1 >= XCC_MRV_BUCKET_ITEMS, true);
+}
+
+static bool
+compute_next_result_mrv(xcc_algorithm* a, xcc_problem* p) {
+  // Only large problems use buckets, smaller ones are spared their checks.
+  // The nogood cache and costs have a kernel of their own.
+  if(p->nogoods || p->costs)
+    return compute_next_result_mrv_extended(a, p);
+  if(p->N_1 >= XCC_MRV_BUCKET_ITEMS)
+    return compute_next_result_mrv_buckets(a, p);
+  return compute_next_result_mrv_scan(a, p);
+}
+
+static bool
+compute_next_result_mrv_slacker(xcc_algorithm* a, xcc_problem* p) {
+  return compute(a, p, XCC_HEURISTIC_MRV_SLACKER, false, true);
+}
+
+void
+xcc_algorithm_c_specialize(xcc_algorithm* a) {
+  switch(xcc_heuristic_of(a->choose_i)) {
+    case XCC_HEURISTIC_NAIVE:
+      a->compute_next_result = &compute_next_result_naive;
+      break;
+    case XCC_HEURISTIC_MRV:
+      a->compute_next_result = &compute_next_result_mrv;
+      break;
+    case XCC_HEURISTIC_MRV_SLACKER:
+      a->compute_next_result = &compute_next_result_mrv_slacker;
+      break;
+    default:
+      a->compute_next_result = &compute_next_result;
+      break;
+  }
+}
+
 void
 xcc_algorithm_c_set(xcc_algorithm* a) {
   xcc_algorithm_standard_functions(a);
 
   a->compute_next_result = &compute_next_result;
   a->choose_i = &xcc_choose_i_mrv;
+  a->free_userdata = &xcc_bitset_free_userdata;
 }
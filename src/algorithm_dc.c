@@ -0,0 +1,351 @@
+/*
+    XCCSolve - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <xcc/algorithm.h>
+#include <xcc/algorithm_dc.h>
+#include <xcc/ops.h>
+
+// XCC solving with dancing cells (TAOCP 7.2.2.3, in the style of SSXCC).
+//
+// Instead of doubly linked lists, every item owns a sparse set of the nodes
+// that are still active in its column. Removing an option swaps its nodes to
+// the end of the active region of each item and decrements the size of the
+// item. The removed item is pushed to a trail, so undoing just increments the
+// sizes again. Active items are kept in sparse sets too. Nodes are numbered
+// like in the DLX matrix of xcc_problem, so solutions are written to p->x.
+
+typedef enum dc_state { D1, D2, D3, D4, D5 } dc_state;
+
+typedef struct dc_level {
+  xcc_link i;
+  xcc_link k;
+  size_t trail;
+  xcc_link active_primary;
+  xcc_link active_secondary;
+} dc_level;
+
+typedef struct dc {
+  // Per node
+  xcc_link* itm;
+  xcc_color* col;
+  xcc_link* beg;
+  xcc_link* loc;
+
+  // Per item
+  xcc_link* set;
+  xcc_link* start;
+  xcc_link* size;
+
+  // Active items, primary and secondary ones in separate sparse sets.
+  xcc_link* active;
+  xcc_link* pos;
+  xcc_link active_primary;
+  xcc_link active_secondary;
+
+  xcc_link* trail;
+  size_t trail_size;
+  size_t trail_capacity;
+
+  dc_level* levels;
+} dc;
+
+#define DC_SET(J) (d->set + d->start[J])
+
+static inline bool
+is_active(xcc_problem* p, dc* d, xcc_link j) {
+  if(j <= p->N_1)
+    return d->pos[j] < d->active_primary;
+  return d->pos[j] < p->N_1 + d->active_secondary;
+}
+
+static inline void
+deactivate(xcc_problem* p, dc* d, xcc_link j) {
+  xcc_link last;
+  if(j <= p->N_1)
+    last = --d->active_primary;
+  else
+    last = p->N_1 + --d->active_secondary;
+  xcc_link other = d->active[last];
+  xcc_link at = d->pos[j];
+  d->active[at] = other;
+  d->pos[other] = at;
+  d->active[last] = j;
+  d->pos[j] = last;
+}
+
+static inline void
+trail_push(dc* d, xcc_link j) {
+  if(d->trail_size == d->trail_capacity) {
+    d->trail_capacity *= 2;
+    d->trail = realloc(d->trail, d->trail_capacity * sizeof(xcc_link));
+  }
+  d->trail[d->trail_size++] = j;
+}
+
+// Remove the option of node y from the sets of all its items except j. A live
+// option is contained in the sets of all its items, so no checks are needed.
+// Sets of inactive items may be changed too, they are restored before the item
+// becomes active again.
+static inline void
+remove_option(dc* d, xcc_link y, xcc_link j) {
+  for(xcc_link r = d->beg[y]; d->itm[r] > 0; ++r) {
+    xcc_link k = d->itm[r];
+    if(k == j)
+      continue;
+    xcc_link* s = DC_SET(k);
+    xcc_link at = d->loc[r];
+    xcc_link last = --d->size[k];
+    xcc_link other = s[last];
+    s[at] = other;
+    d->loc[other] = at;
+    s[last] = r;
+    d->loc[r] = last;
+    trail_push(d, k);
+  }
+}
+
+// Remove the options conflicting with the item of node q from the problem.
+static inline void
+hide_conflicts(xcc_problem* p, dc* d, xcc_link q) {
+  xcc_link j = d->itm[q];
+  xcc_link b = d->beg[q];
+  xcc_color c = j <= p->N_1 ? 0 : d->col[q];
+  deactivate(p, d, j);
+  xcc_link* s = DC_SET(j);
+  for(xcc_link k = 0; k < d->size[j]; ++k) {
+    xcc_link y = s[k];
+    if(d->beg[y] == b)
+      continue;
+    if(c == 0 || d->col[y] != c)
+      remove_option(d, y, j);
+  }
+}
+
+// Select the option of node x, which is in the set of the chosen item. That
+// item is processed first, so that its set is never modified while the search
+// iterates over it.
+static void
+apply(xcc_problem* p, dc* d, xcc_link x) {
+  hide_conflicts(p, d, x);
+  for(xcc_link q = d->beg[x]; d->itm[q] > 0; ++q) {
+    if(q == x || !is_active(p, d, d->itm[q]))
+      continue;// Skip the chosen and already purified secondary items.
+    hide_conflicts(p, d, q);
+  }
+}
+
+static void
+undo(dc* d, dc_level* lv) {
+  while(d->trail_size > lv->trail) {
+    ++d->size[d->trail[--d->trail_size]];
+  }
+  d->active_primary = lv->active_primary;
+  d->active_secondary = lv->active_secondary;
+}
+
+static xcc_link
+choose_i(xcc_problem* p, dc* d) {
+  xcc_link i = 0, theta = XCC_LINK_MAX;
+  for(xcc_link k = 0; k < d->active_primary; ++k) {
+    xcc_link j = d->active[k];
+    xcc_link s = d->size[j];
+    if(s < theta || (s == theta && j < i)) {
+      theta = s;
+      i = j;
+      if(s == 0)
+        break;
+    }
+  }
+  return i;
+}
+
+static dc*
+create_dc(xcc_problem* p) {
+  dc* d = calloc(1, sizeof(dc));
+  size_t nodes = p->Z + 1;
+  d->itm = calloc(nodes + 1, sizeof(xcc_link));
+  d->col = calloc(nodes + 1, sizeof(xcc_color));
+  d->beg = calloc(nodes + 1, sizeof(xcc_link));
+  d->loc = calloc(nodes + 1, sizeof(xcc_link));
+  d->set = calloc(nodes + 1, sizeof(xcc_link));
+  d->start = calloc(p->N + 1, sizeof(xcc_link));
+  d->size = calloc(p->N + 1, sizeof(xcc_link));
+  d->active = calloc(p->N + 1, sizeof(xcc_link));
+  d->pos = calloc(p->N + 1, sizeof(xcc_link));
+  d->levels = calloc(p->N_1 + 1, sizeof(dc_level));
+  d->trail_capacity = 1024;
+  d->trail = malloc(d->trail_capacity * sizeof(xcc_link));
+
+  xcc_link b = p->N + 2;
+  for(xcc_link x = p->N + 2; x < p->Z; ++x) {
+    if(TOP(x) <= 0) {
+      b = x + 1;
+      continue;
+    }
+    d->itm[x] = TOP(x);
+    d->col[x] = COLOR(x);
+    d->beg[x] = b;
+    ++d->size[TOP(x)];
+  }
+
+  xcc_link offset = 0;
+  for(xcc_link j = 1; j <= p->N; ++j) {
+    d->start[j] = offset;
+    offset += d->size[j];
+    d->size[j] = 0;
+  }
+
+  // Fill the sets in the vertical order of the DLX matrix.
+  for(xcc_link j = 1; j <= p->N; ++j) {
+    for(xcc_link x = DLINK(j); x != j; x = DLINK(x)) {
+      d->loc[x] = d->size[j];
+      DC_SET(j)[d->size[j]++] = x;
+    }
+  }
+
+  for(xcc_link j = 1; j <= p->N; ++j) {
+    d->active[j - 1] = j;
+    d->pos[j] = j - 1;
+  }
+  d->active_primary = p->N_1;
+  d->active_secondary = p->N - p->N_1;
+
+  return d;
+}
+
+static void
+free_userdata(xcc_algorithm* a, xcc_problem* p) {
+  dc* d = p->algorithm_userdata;
+  if(!d)
+    return;
+  free(d->itm);
+  free(d->col);
+  free(d->beg);
+  free(d->loc);
+  free(d->set);
+  free(d->start);
+  free(d->size);
+  free(d->active);
+  free(d->pos);
+  free(d->levels);
+  free(d->trail);
+  free(d);
+  p->algorithm_userdata = NULL;
+}
+
+static bool
+compute_next_result(xcc_algorithm* a, xcc_problem* p) {
+  if(p->x_capacity < p->option_count) {
+    p->x = realloc(p->x, sizeof(xcc_link) * p->option_count);
+    p->x_capacity = p->option_count;
+    p->x_size = 0;
+  }
+
+  p->interrupted = false;
+
+  dc* d = p->algorithm_userdata;
+
+  while(true) {
+    switch(p->state) {
+      case D1: {
+        xcc_link i = 0;
+        do {
+          i = RLINK(i);
+          if(DLINK(i) == 0 && ULINK(i) == 0) {
+            fprintf(stderr, "Some item never occurs in the options!\n");
+            return false;
+          }
+        } while(RLINK(i) != 0);
+
+        if(!d)
+          p->algorithm_userdata = d = create_dc(p);
+
+        p->l = 0;
+        p->state = D2;
+        break;
+      }
+      case D2: {
+        // Enter level l
+        if(p->node_limit && p->nodes >= p->node_limit) {
+          p->interrupted = true;
+          return false;
+        }
+        if(d->active_primary == 0) {
+          for(xcc_link l = 0; l < p->l; ++l) {
+            dc_level* lv = &d->levels[l];
+            p->x[l] = DC_SET(lv->i)[lv->k];
+            xcc_set_item_colors(p, p->x[l]);
+          }
+          p->x_size = p->l;
+          p->state = D5;
+          return true;
+        }
+        ++p->nodes;
+        dc_level* lv = &d->levels[p->l];
+        lv->i = choose_i(p, d);
+        lv->k = 0;
+        lv->trail = d->trail_size;
+        lv->active_primary = d->active_primary;
+        lv->active_secondary = d->active_secondary;
+        p->state = D3;
+        break;
+      }
+      case D3: {
+        // Try option k of the chosen item
+        dc_level* lv = &d->levels[p->l];
+        if(lv->k >= d->size[lv->i]) {
+          p->state = D5;
+          break;
+        }
+        apply(p, d, DC_SET(lv->i)[lv->k]);
+        p->l = p->l + 1;
+        p->state = D2;
+        break;
+      }
+      case D4: {
+        // Undo option k and advance to the next one
+        dc_level* lv = &d->levels[p->l];
+        undo(d, lv);
+        ++lv->k;
+        p->state = D3;
+        break;
+      }
+      case D5:
+        // Backtrack
+        if(p->l == 0)
+          return false;
+        p->l = p->l - 1;
+        p->state = D4;
+        break;
+    }
+  }
+
+  return false;
+}
+
+void
+xcc_algorithm_dc_set(xcc_algorithm* a) {
+  xcc_algorithm_standard_functions(a);
+
+  a->compute_next_result = &compute_next_result;
+  a->free_userdata = &free_userdata;
+}
@@ -26,163 +26,311 @@
 
 typedef enum m_state { M1, M2, M3, M4, M5, M6, M7, M8, M9 } m_state;
 
-static bool
-compute_next_result(xcc_algorithm* a, xcc_problem* p) {
+// Whether level l, which chose item i, is at its first branch. Items that
+// are not covered exactly once are tweaked, so their options leave the list
+// of i and FT(l) remembers the first one.
+static inline bool
+is_first_branch(xcc_problem* p, int l, xcc_link i) {
+  xcc_link x = p->x[l];
+  if(BOUND(i) == 0 && SLACK(i) == 0)
+    return x == i || ULINK(x) == i;
+  return x == FT(l);
+}
+
+// The search kernel, instantiated once per heuristic below, see algorithm_x.c.
+static XCC_ALWAYS_INLINE bool
+compute(xcc_algorithm* a, xcc_problem* p, xcc_heuristic h) {
   if(p->x_capacity < p->option_count) {
     p->x = realloc(p->x, sizeof(xcc_link) * p->option_count);
     p->x_capacity = p->option_count;
     p->x_size = 0;
   }
 
-  assert(a->choose_i);
+  assert(h != XCC_HEURISTIC_CUSTOM || a->choose_i);
+
+  p->interrupted = false;
+
+  xcc_link* x = p->x;
+  m_state state = p->state;
+  xcc_link i = p->i;
+  int l = p->l;
+  size_t nodes = p->nodes;
+  size_t forced = p->forced;
+
+#define SAVE()           \
+  do {                   \
+    p->state = state;    \
+    p->i = i;            \
+    p->l = l;            \
+    p->nodes = nodes;    \
+    p->forced = forced;  \
+  } while(0)
 
   while(true) {
-    switch(p->state) {
+    switch(state) {
       case M1: {
-        xcc_link i = 0;
+        xcc_link j = 0;
         do {
-          i = RLINK(i);
-          if(DLINK(i) == 0 && ULINK(i) == 0) {
+          j = RLINK(j);
+          if(DLINK(j) == 0 && ULINK(j) == 0) {
             fprintf(stderr, "Some item never occurs in the options!\n");
             return false;
           }
-        } while(RLINK(i) != 0);
+        } while(RLINK(j) != 0);
 
-        p->l = 0;
-        p->state = M2;
-        p->i = 0;
+        l = 0;
+        state = M2;
+        i = 0;
         break;
       }
       case M2:
+        if(p->node_limit && nodes >= p->node_limit) {
+          p->interrupted = true;
+          if(p->restart) {
+            p->fixed = l;// Backtrack to the root, trying no other branch
+            state = M9;
+            break;
+          }
+          SAVE();
+          return false;
+        }
         if(RLINK(0) == 0) {
-          p->state = M9;
-          p->x_size = p->l;
+          state = M9;
+          if(p->lds && p->discrepancies < p->discrepancy_limit)
+            break;// Reported by an earlier iteration
+          p->x_size = l;
+          SAVE();
           return true;
         }
-        p->state = M3;
+        state = M3;
         break;
       case M3:
-        p->i = a->choose_i(a, p);
-        assert(p->i <= p->primary_item_count);
-        if(THETA(p->i) == 0) {
-          p->state = M9;
+        if(l < p->prefix_size) {
+          xcc_link n = p->prefix[l];
+          i = n <= p->N ? n : TOP(n);
         } else {
-          p->state = M4;
+          if(h == XCC_HEURISTIC_CUSTOM)
+            SAVE();
+          i = xcc_choose(h, a, p);
+          if(LEN(i) == 1 && BOUND(i) == 1 && SLACK(i) == 0) {
+            // The only option of an item that has to be covered exactly once
+            // is forced. It is applied like by M4 and M6, without a node of
+            // its own, and M7 recognizes the level on backtracking.
+            ++forced;
+            BOUND(i) = 0;
+            COVER_PRIME(i);
+            x[l] = DLINK(i);
+            for(xcc_link q = x[l] + 1; q != x[l];) {
+              xcc_link j = TOP(q);
+              if(j <= 0) {
+                q = ULINK(q);
+              } else if(j <= p->N_1) {
+                BOUND(j) = BOUND(j) - 1;
+                q = q + 1;
+                if(BOUND(j) == 0) {
+                  COVER_PRIME(j);
+                }
+              } else {
+                COMMIT(q, j);
+                q = q + 1;
+              }
+            }
+            l = l + 1;
+            if(RLINK(0) == 0)
+              state = M2;
+            break;
+          }
+        }
+        ++nodes;
+        assert(i <= p->primary_item_count);
+        if(THETA(i) == 0) {
+          state = M9;
+        } else {
+          state = M4;
         }
         break;
       case M4:
-        p->x[p->l] = DLINK(p->i);
-        BOUND(p->i) = BOUND(p->i) - 1;
-        if(BOUND(p->i) == 0)
-          COVER_PRIME(p->i);
-        if(BOUND(p->i) != 0 || SLACK(p->i) != 0)
-          FT(p->l) = p->x[p->l];
-        p->state = M5;
+        x[l] = DLINK(i);
+        BOUND(i) = BOUND(i) - 1;
+        if(BOUND(i) == 0)
+          COVER_PRIME(i);
+        if(BOUND(i) != 0 || SLACK(i) != 0)
+          FT(l) = x[l];
+        state = M5;
         break;
       case M5:
-        if(BOUND(p->i) == 0 && BOUND(p->i) == SLACK(p->i)) {
-          if(p->x[p->l] != p->i) {
-            p->state = M6;
+        if(BOUND(i) == 0 && BOUND(i) == SLACK(i)) {
+          if(x[l] != i) {
+            if(xcc_skip_for_prefix(p, l)) {
+              x[l] = DLINK(x[l]);
+              break;
+            }
+            state = M6;
           } else {
-            p->state = M8;
+            state = M8;
           }
           break;
         }
-        if(LEN(p->i) <= BOUND(p->i) - SLACK(p->i)) {
-          p->state = M8;// List i is too short
+        if(LEN(i) <= BOUND(i) - SLACK(i)) {
+          state = M8;// List i is too short
           break;
         }
-        if(p->x[p->l] != p->i) {
-          if(BOUND(p->i) == 0)
-            TWEAK_PRIME(p->x[p->l], p->i);
+        if(x[l] != i) {
+          if(BOUND(i) == 0)
+            TWEAK_PRIME(x[l], i);
           else
-            TWEAK(p->x[p->l], p->i);
-        } else if(BOUND(p->i) != 0) {
-          p->p = LLINK(p->i);
-          p->q = RLINK(p->i);
-          RLINK(p->p) = p->q;
-          LLINK(p->q) = p->p;
+            TWEAK(x[l], i);
+          if(xcc_skip_for_prefix(p, l)) {
+            x[l] = DLINK(x[l]);
+            break;
+          }
+        } else if(BOUND(i) != 0) {
+          xcc_link left = LLINK(i), right = RLINK(i);
+          RLINK(left) = right;
+          LLINK(right) = left;
         }
-        p->state = M6;
+        state = M6;
         break;
       case M6:
-        if(p->x[p->l] != p->i) {
-          p->p = p->x[p->l] + 1;
-          assert(p->p < p->top_size);
-          while(p->x[p->l] != p->p) {
-            xcc_link j = TOP(p->p);
+        if(x[l] != i) {
+          xcc_link q = x[l] + 1;
+          assert(q < p->node_size);
+          while(x[l] != q) {
+            xcc_link j = TOP(q);
             if(j <= 0) {
-              p->p = ULINK(p->p);
+              q = ULINK(q);
             } else if(j <= p->N_1) {
               BOUND(j) = BOUND(j) - 1;
-              p->p = p->p + 1;
+              q = q + 1;
               if(BOUND(j) == 0) {
                 COVER_PRIME(j);
               }
             } else {
-              COMMIT(p->p, j);
-              p->p = p->p + 1;
+              COMMIT(q, j);
+              q = q + 1;
             }
           }
         }
-        p->l = p->l + 1;
-        p->state = M2;
+        l = l + 1;
+        state = M2;
         break;
       case M7:
-        p->p = p->x[p->l] - 1;
-        while(p->x[p->l] != p->p) {
-          xcc_link j = TOP(p->p);
+        for(xcc_link q = x[l] - 1; x[l] != q;) {
+          xcc_link j = TOP(q);
           if(j <= 0) {
-            p->p = DLINK(p->p);
+            q = DLINK(q);
           } else if(j <= p->N_1) {
             BOUND(j) = BOUND(j) + 1;
-            p->p = p->p - 1;
+            q = q - 1;
             if(BOUND(j) == 1) {
               UNCOVER_PRIME(j);
             }
           } else {
-            UNCOMMIT(p->p, j);
-            p->p = p->p - 1;
+            UNCOMMIT(q, j);
+            q = q - 1;
+          }
+        }
+        if(l < p->fixed ||
+           (BOUND(i) == 0 && SLACK(i) == 0 && DLINK(x[l]) == i)) {
+          state = M8;// Nothing left to try, as for forced levels
+          break;
+        }
+        if(p->lds && is_first_branch(p, l, i)) {
+          // Leaving the first branch is a discrepancy, see Algorithm X.
+          if(p->discrepancies == p->discrepancy_limit) {
+            p->discrepancy_cut = true;
+            state = M8;
+            break;
           }
+          ++p->discrepancies;
         }
-        p->x[p->l] = DLINK(p->x[p->l]);
-        p->state = M5;
+        x[l] = DLINK(x[l]);
+        state = M5;
         break;
       case M8:
-        if(BOUND(p->i) == 0 && BOUND(p->i) == SLACK(p->i)) {
-          UNCOVER_PRIME(p->i);
-        } else if(BOUND(p->i) == 0) {
-          UNTWEAK_PRIME(p->l);
+        if(p->lds && !is_first_branch(p, l, i))
+          --p->discrepancies;
+        if(BOUND(i) == 0 && BOUND(i) == SLACK(i)) {
+          UNCOVER_PRIME(i);
+        } else if(BOUND(i) == 0) {
+          UNTWEAK_PRIME(l);
         } else {
-          UNTWEAK(p->l);
+          UNTWEAK(l);
         }
-        BOUND(p->i) = BOUND(p->i) + 1;
-        p->state = M9;
+        BOUND(i) = BOUND(i) + 1;
+        state = M9;
         break;
       case M9:
-        if(p->l == 0) {
+        if(l == 0) {
+          if(p->lds && p->discrepancy_cut) {
+            // Search again, allowing one more discrepancy.
+            ++p->discrepancy_limit;
+            p->discrepancy_cut = false;
+            state = M1;
+            break;
+          }
+          SAVE();
           return false;
         }
-        p->l = p->l - 1;
-        if(p->x[p->l] <= p->N) {
-          p->i = p->x[p->l];
-          p->p = LLINK(p->i);
-          p->q = RLINK(p->i);
-          RLINK(p->p) = p->i;
-          LLINK(p->q) = p->i;
-          p->state = M8;
+        l = l - 1;
+        if(x[l] <= p->N) {
+          i = x[l];
+          xcc_link left = LLINK(i), right = RLINK(i);
+          RLINK(left) = i;
+          LLINK(right) = i;
+          state = M8;
           break;
         } else {
-          p->i = TOP(p->x[p->l]);
-          p->state = M7;
+          i = TOP(x[l]);
+          state = M7;
           break;
         }
     }
   }
 
+#undef SAVE
+
   return false;
 }
 
+static bool
+compute_next_result(xcc_algorithm* a, xcc_problem* p) {
+  return compute(a, p, XCC_HEURISTIC_CUSTOM);
+}
+
+static bool
+compute_next_result_naive(xcc_algorithm* a, xcc_problem* p) {
+  return compute(a, p, XCC_HEURISTIC_NAIVE);
+}
+
+static bool
+compute_next_result_mrv(xcc_algorithm* a, xcc_problem* p) {
+  return compute(a, p, XCC_HEURISTIC_MRV);
+}
+
+static bool
+compute_next_result_mrv_slacker(xcc_algorithm* a, xcc_problem* p) {
+  return compute(a, p, XCC_HEURISTIC_MRV_SLACKER);
+}
+
+void
+xcc_algorithm_m_specialize(xcc_algorithm* a) {
+  switch(xcc_heuristic_of(a->choose_i)) {
+    case XCC_HEURISTIC_NAIVE:
+      a->compute_next_result = &compute_next_result_naive;
+      break;
+    case XCC_HEURISTIC_MRV:
+      a->compute_next_result = &compute_next_result_mrv;
+      break;
+    case XCC_HEURISTIC_MRV_SLACKER:
+      a->compute_next_result = &compute_next_result_mrv_slacker;
+      break;
+    default:
+      a->compute_next_result = &compute_next_result;
+      break;
+  }
+}
+
 void
 xcc_algorithm_m_set(xcc_algorithm* a) {
   xcc_algorithm_standard_functions(a);
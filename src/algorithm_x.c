@@ -21,110 +21,378 @@
 #include <string.h>
 
 #include <xcc/algorithm.h>
+#include <xcc/algorithm_bitset.h>
 #include <xcc/algorithm_x.h>
+#include <xcc/cost.h>
+#include <xcc/nogood.h>
 #include <xcc/ops.h>
 
-typedef enum x_state { X1, X2, X3, X4, X5, X6, X7, X8 } x_state;
+typedef enum x_state { X1, X2, X3, X4, X5, X6, X7, X8, X9 } x_state;
 
-static bool
-compute_next_result(xcc_algorithm* a, xcc_problem* p) {
+// The search kernel, instantiated once per heuristic below, and for MRV also
+// with buckets and with the extensions (the nogood cache and costs). The hot
+// search state is kept in locals, so that it can live in registers, and
+// written back to p before the kernel returns or calls code that reads it.
+static XCC_ALWAYS_INLINE bool
+compute(xcc_algorithm* a,
+        xcc_problem* p,
+        xcc_heuristic h,
+        bool buckets,
+        bool extended) {
   if(p->x_capacity < p->option_count) {
     p->x = realloc(p->x, sizeof(xcc_link) * p->option_count);
     p->x_capacity = p->option_count;
     p->x_size = 0;
   }
 
-  assert(a->choose_i);
+  assert(h != XCC_HEURISTIC_CUSTOM || a->choose_i);
+
+  p->interrupted = false;
+
+  xcc_link* x = p->x;
+  x_state state = p->state;
+  xcc_link i = p->i;
+  int l = p->l;
+  int primaries_left = p->primaries_left;
+  size_t nodes = p->nodes;
+  size_t forced = p->forced;
+
+#define SAVE()                           \
+  do {                                   \
+    p->state = state;                    \
+    p->i = i;                            \
+    p->l = l;                            \
+    p->primaries_left = primaries_left;  \
+    p->nodes = nodes;                    \
+    p->forced = forced;                  \
+  } while(0)
+// Whether covering has to keep the MRV buckets up to date.
+#define BUCKETS (buckets && p->buckets)
+// Whether covering has to keep the key of the nogood cache up to date.
+#define NOGOODS (extended && p->nogoods)
+// Whether selecting options has to keep the cost of the search up to date.
+#define COSTS (extended && p->costs)
+#define COVER_N(I)                       \
+  do {                                   \
+    COVER_B(I, BUCKETS);                 \
+    if(NOGOODS)                          \
+      xcc_nogoods_toggle(p->nogoods, I); \
+  } while(0)
+#define UNCOVER_N(I)                     \
+  do {                                   \
+    UNCOVER_B(I, BUCKETS);               \
+    if(NOGOODS)                          \
+      xcc_nogoods_toggle(p->nogoods, I); \
+  } while(0)
+#define LOAD()        \
+  do {                \
+    l = p->l;         \
+    nodes = p->nodes; \
+  } while(0)
 
   while(true) {
-    switch(p->state) {
+    switch(state) {
       case X1: {
-        xcc_link i = 0;
+        xcc_link j = 0;
         do {
-          i = RLINK(i);
-          if(DLINK(i) == 0 && ULINK(i) == 0) {
+          j = RLINK(j);
+          if(DLINK(j) == 0 && ULINK(j) == 0) {
             fprintf(stderr, "Some item never occurs in the options!\n");
             return false;
           }
-        } while(RLINK(i) != 0);
+        } while(RLINK(j) != 0);
+
+        p->buckets = false;
+        if(buckets)
+          xcc_mrv_buckets_allocate(p);
 
-        p->l = 0;
-        p->state = X2;
-        p->i = 0;
+        l = 0;
+        primaries_left = p->N_1;
+        state = X2;
+        i = 0;
         break;
       }
       case X2:
+        if(p->node_limit && nodes >= p->node_limit) {
+          p->interrupted = true;
+          if(p->restart) {
+            p->fixed = l;// Backtrack to the root, trying no other branch
+            state = X8;
+            break;
+          }
+          SAVE();
+          return false;
+        }
         if(RLINK(0) == 0) {
-          p->state = X8;
-          p->x_size = p->l;
+          state = X8;
+          if(p->lds && p->discrepancies < p->discrepancy_limit)
+            break;// Reported by an earlier iteration
+          if(NOGOODS)
+            ++p->nogoods->solutions;
+          p->x_size = l;
+          SAVE();
           return true;
         }
-        p->state = X3;
+        if(primaries_left <= p->tail_items && l >= p->prefix_size) {
+          SAVE();
+          if(xcc_bitset_tail_start(p, false)) {
+            state = X9;
+            break;
+          }
+        }
+        state = X3;
         break;
       case X3:
-        p->i = a->choose_i(a, p);
-        p->state = X4;
+        if(l < p->prefix_size) {
+          xcc_link n = p->prefix[l];
+          i = n <= p->N ? n : TOP(n);
+        } else {
+          if(NOGOODS) {
+            if(xcc_nogoods_lookup(p->nogoods)) {
+              state = X8;
+              break;
+            }
+            xcc_nogoods_enter(p->nogoods, l, nodes);
+          }
+          if(h == XCC_HEURISTIC_CUSTOM)
+            SAVE();
+          if(buckets)
+            xcc_mrv_buckets_adapt(p, primaries_left);
+          i = xcc_choose(h, a, p);
+          if(LEN(i) == 1) {
+            if(COSTS && xcc_costs_exceed(p->costs, DLINK(i))) {
+              ++p->costs->pruned;
+              state = X8;
+              break;
+            }
+            // The only option of i is forced. It is applied right away and
+            // X3 is entered again, so a chain of forced options does not go
+            // through X4, X5 and X2 and is no node of its own. Forced levels
+            // are still recorded in x, X6 recognizes them on backtracking.
+            ++forced;
+            COVER_N(i);
+            --primaries_left;
+            x[l] = DLINK(i);
+            if(COSTS)
+              xcc_costs_select(p->costs, x[l], false);
+            for(xcc_link q = x[l] + 1; q != x[l];) {
+              xcc_link j = TOP(q);
+              if(j <= 0) {
+                q = ULINK(q);
+              } else {
+                COVER_N(j);
+                if(j <= p->N_1)
+                  --primaries_left;
+                q = q + 1;
+              }
+            }
+            l = l + 1;
+            if(RLINK(0) == 0 || primaries_left <= p->tail_items)
+              state = X2;
+            break;
+          }
+        }
+        ++nodes;
+        state = X4;
         break;
       case X4:
-        COVER(p->i);
-        p->x[p->l] = DLINK(p->i);
-        p->state = X5;
+        COVER_N(i);
+        --primaries_left;
+        x[l] = DLINK(i);
+        state = X5;
         break;
       case X5:
-        if(p->x[p->l] == p->i) {
-          p->state = X7;
+        if(x[l] == i) {
+          state = X7;
           break;
-        } else {
-          p->p = p->x[p->l] + 1;
-          while(p->p != p->x[p->l]) {
-            xcc_link j = TOP(p->p);
-            if(j <= 0) {
-              p->p = ULINK(p->p);
-            } else {
-              COVER(j);
-              p->p = p->p + 1;
+        }
+        if(xcc_skip_for_prefix(p, l)) {
+          x[l] = DLINK(x[l]);
+          break;
+        }
+        if(COSTS) {
+          if(xcc_costs_exceed(p->costs, x[l])) {
+            ++p->costs->pruned;
+            // The options of i are sorted by cost.
+            if(xcc_costs_exhausted(p->costs, x[l])) {
+              state = X7;
+              break;
             }
+            x[l] = DLINK(x[l]);
+            break;
           }
+          xcc_costs_select(p->costs, x[l], false);
         }
-        p->l = p->l + 1;
-        p->state = X2;
+        for(xcc_link q = x[l] + 1; q != x[l];) {
+          xcc_link j = TOP(q);
+          if(j <= 0) {
+            q = ULINK(q);
+          } else {
+            COVER_N(j);
+            if(j <= p->N_1)
+              --primaries_left;
+            q = q + 1;
+          }
+        }
+        l = l + 1;
+        state = X2;
         break;
       case X6:
-        p->p = p->x[p->l] - 1;
-        while(p->p != p->x[p->l]) {
-          xcc_link j = TOP(p->p);
+        for(xcc_link q = x[l] - 1; q != x[l];) {
+          xcc_link j = TOP(q);
           if(j <= 0) {
-            p->p = DLINK(p->p);
+            q = DLINK(q);
           } else {
-            UNCOVER(j);
-            p->p = p->p - 1;
+            UNCOVER_N(j);
+            if(j <= p->N_1)
+              ++primaries_left;
+            q = q - 1;
+          }
+        }
+        if(COSTS)
+          xcc_costs_select(p->costs, x[l], true);
+        i = TOP(x[l]);
+        if(l < p->fixed || DLINK(x[l]) == i) {
+          // Fixed levels and the last option, which also is the only option
+          // of forced levels, have nothing left to try.
+          state = X7;
+          break;
+        }
+        if(p->lds && ULINK(x[l]) == i) {
+          // Leaving the first option is a discrepancy.
+          if(p->discrepancies == p->discrepancy_limit) {
+            p->discrepancy_cut = true;
+            state = X7;
+            break;
           }
+          ++p->discrepancies;
         }
-        p->i = TOP(p->x[p->l]);
-        p->x[p->l] = DLINK(p->x[p->l]);
-        p->state = X5;
+        x[l] = DLINK(x[l]);
+        state = X5;
         break;
       case X7:
-        UNCOVER(p->i);
-        p->state = X8;
+        if(p->lds && x[l] != i && ULINK(x[l]) != i)
+          --p->discrepancies;
+        UNCOVER_N(i);
+        ++primaries_left;
+        // The sub-problem of level l is exhausted, unless branches were left
+        // out. Items without options are as fast to find again.
+        if(NOGOODS && !COSTS && l >= p->fixed && !p->interrupted &&
+           DLINK(i) != i)
+          xcc_nogoods_leave(p->nogoods, l, nodes);
+        state = X8;
         break;
       case X8:
-        if(p->l == 0) {
+        if(l == 0) {
+          if(p->lds && p->discrepancy_cut) {
+            // Search again, allowing one more discrepancy.
+            ++p->discrepancy_limit;
+            p->discrepancy_cut = false;
+            state = X1;
+            break;
+          }
+          SAVE();
           return false;
         }
-        p->l = p->l - 1;
-        p->state = X6;
+        l = l - 1;
+        state = X6;
+        break;
+      case X9:
+        // Finish the subtree of level l with bitsets
+        SAVE();
+        switch(xcc_bitset_tail_next(p)) {
+          case XCC_BITSET_SOLUTION:
+            if(NOGOODS)
+              ++p->nogoods->solutions;
+            return true;
+          case XCC_BITSET_INTERRUPTED:
+            p->interrupted = true;
+            return false;
+          case XCC_BITSET_DONE:
+            LOAD();
+            state = X8;
+            break;
+        }
         break;
     }
   }
 
+#undef SAVE
+#undef LOAD
+#undef BUCKETS
+#undef NOGOODS
+#undef COSTS
+#undef COVER_N
+#undef UNCOVER_N
+
   return false;
 }
 
+static bool
+compute_next_result(xcc_algorithm* a, xcc_problem* p) {
+  return compute(a, p, XCC_HEURISTIC_CUSTOM, false, true);
+}
+
+static bool
+compute_next_result_naive(xcc_algorithm* a, xcc_problem* p) {
+  return compute(a, p, XCC_HEURISTIC_NAIVE, false, true);
+}
+
+static XCC_NOINLINE bool
+compute_next_result_mrv_scan(xcc_algorithm* a, xcc_problem* p) {
+  return compute(a, p, XCC_HEURISTIC_MRV, false, false);
+}
+
+static XCC_NOINLINE bool
+compute_next_result_mrv_buckets(xcc_algorithm* a, xcc_problem* p) {
+  return compute(a, p, XCC_HEURISTIC_MRV, true, false);
+}
+
+static XCC_NOINLINE bool
+compute_next_result_mrv_extended(xcc_algorithm* a, xcc_problem* p) {
+  return compute(
+    a, p, XCC_HEURISTIC_MRV, p->N_1 >= XCC_MRV_BUCKET_ITEMS, true);
+}
+
+static bool
+compute_next_result_mrv(xcc_algorithm* a, xcc_problem* p) {
+  // Only large problems use buckets, smaller ones are spared their checks.
+  // The nogood cache and costs have a kernel of their own.
+  if(p->nogoods || p->costs)
+    return compute_next_result_mrv_extended(a, p);
+  if(p->N_1 >= XCC_MRV_BUCKET_ITEMS)
+    return compute_next_result_mrv_buckets(a, p);
+  return compute_next_result_mrv_scan(a, p);
+}
+
+static bool
+compute_next_result_mrv_slacker(xcc_algorithm* a, xcc_problem* p) {
+  return compute(a, p, XCC_HEURISTIC_MRV_SLACKER, false, true);
+}
+
+void
+xcc_algorithm_x_specialize(xcc_algorithm* a) {
+  switch(xcc_heuristic_of(a->choose_i)) {
+    case XCC_HEURISTIC_NAIVE:
+      a->compute_next_result = &compute_next_result_naive;
+      break;
+    case XCC_HEURISTIC_MRV:
+      a->compute_next_result = &compute_next_result_mrv;
+      break;
+    case XCC_HEURISTIC_MRV_SLACKER:
+      a->compute_next_result = &compute_next_result_mrv_slacker;
+      break;
+    default:
+      a->compute_next_result = &compute_next_result;
+      break;
+  }
+}
+
 void
 xcc_algorithm_x_set(xcc_algorithm* a) {
   xcc_algorithm_standard_functions(a);
 
   a->compute_next_result = &compute_next_result;
   a->choose_i = &xcc_choose_i_mrv;
+  a->free_userdata = &xcc_bitset_free_userdata;
 }
@@ -0,0 +1,326 @@
+/*
+    XCCSolve - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <xcc/algorithm.h>
+#include <xcc/assume.h>
+#include <xcc/ops.h>
+
+// The assumptions applied to the problem, which are undone in reverse order.
+// item is 0 for free items, -1 for items covered by a forced option and the
+// color that a forced option gave to a secondary item otherwise.
+typedef struct applied {
+  xcc_link* removed;
+  size_t removed_count;
+  xcc_link* forced;
+  size_t forced_count;
+  xcc_link* item;
+} applied;
+
+static void
+index_options(xcc_problem* p) {
+  if(p->option_node)
+    return;
+  p->option_node = calloc(p->option_count + 1, sizeof(xcc_link));
+  xcc_link first = p->N + 2;
+  for(xcc_link x = first; x <= p->Z; ++x) {
+    if(TOP(x) <= 0) {
+      assert(-TOP(x) <= p->option_count);
+      p->option_node[-TOP(x)] = first;
+      first = x + 1;
+    }
+  }
+}
+
+static inline bool
+is_linked(xcc_problem* p, xcc_link q) {
+  return DLINK(ULINK(q)) == q;
+}
+
+// Unlinks all nodes of the option of node x from their items, so that it can
+// no longer be selected.
+static void
+remove_option(xcc_problem* p, xcc_link x) {
+  HIDE(x);
+  xcc_link u = ULINK(x), d = DLINK(x);
+  DLINK(u) = d;
+  ULINK(d) = u;
+  LEN(TOP(x)) = LEN(TOP(x)) - 1;
+}
+
+static void
+restore_option(xcc_problem* p, xcc_link x) {
+  xcc_link u = ULINK(x), d = DLINK(x);
+  DLINK(u) = x;
+  ULINK(d) = x;
+  LEN(TOP(x)) = LEN(TOP(x)) + 1;
+  UNHIDE(x);
+}
+
+// Plain primary items of Algorithm M (BOUND 0 and SLACK 1) may be covered any
+// number of times, so the kernel never covers them and neither is their BOUND
+// counted down here. Items whose bound is used up have BOUND 0 as well, but
+// are covered.
+static inline bool
+is_plain_m_item(xcc_problem* p, xcc_link j) {
+  return BOUND(j) == 0 && SLACK(j) > 0 && RLINK(LLINK(j)) == j;
+}
+
+// Whether node q of an option to be forced is compatible with the
+// assumptions applied so far.
+static bool
+is_selectable_node(xcc_problem* p, int algorithm, applied* s, xcc_link q) {
+  xcc_link j = TOP(q);
+  if(!is_linked(p, q))
+    return false;// Hidden by an option that conflicts with it
+  if(algorithm == XCC_ALGORITHM_M && j <= p->N_1)
+    return BOUND(j) > 0 || is_plain_m_item(p, j);
+  if(s->item[j] < 0)
+    return false;
+  // Options with the color of the item stay linked, but are marked by PURIFY.
+  return s->item[j] == 0 || COLOR(q) < 0;
+}
+
+static bool
+is_selectable(xcc_problem* p, int algorithm, applied* s, xcc_link x) {
+  if(!is_selectable_node(p, algorithm, s, x))
+    return false;
+  for(xcc_link q = x + 1; q != x;) {
+    if(TOP(q) <= 0) {
+      q = ULINK(q);
+    } else {
+      if(!is_selectable_node(p, algorithm, s, q))
+        return false;
+      q = q + 1;
+    }
+  }
+  return true;
+}
+
+static void
+select_node(xcc_problem* p, int algorithm, applied* s, xcc_link q) {
+  xcc_link j = TOP(q);
+  if(algorithm == XCC_ALGORITHM_X) {
+    COVER(j);
+    s->item[j] = -1;
+  } else if(algorithm == XCC_ALGORITHM_M && j <= p->N_1) {
+    if(is_plain_m_item(p, j))
+      return;
+    BOUND(j) = BOUND(j) - 1;
+    if(BOUND(j) == 0)
+      COVER_PRIME(j);
+  } else {
+    if(COLOR(q) == 0)
+      s->item[j] = -1;
+    else if(COLOR(q) > 0)
+      s->item[j] = COLOR(q);
+    COMMIT(q, j);
+  }
+}
+
+static void
+deselect_node(xcc_problem* p, int algorithm, applied* s, xcc_link q) {
+  xcc_link j = TOP(q);
+  if(algorithm == XCC_ALGORITHM_X) {
+    UNCOVER(j);
+  } else if(algorithm == XCC_ALGORITHM_M && j <= p->N_1) {
+    if(is_plain_m_item(p, j))
+      return;
+    if(BOUND(j) == 0)
+      UNCOVER_PRIME(j);
+    BOUND(j) = BOUND(j) + 1;
+  } else {
+    UNCOMMIT(q, j);
+  }
+  if(COLOR(q) >= 0)
+    s->item[j] = 0;
+}
+
+// Selects the option of node x like the search does, after removing it from
+// its items so that it is not selected a second time.
+static void
+select_option(xcc_problem* p, int algorithm, applied* s, xcc_link x) {
+  remove_option(p, x);
+  select_node(p, algorithm, s, x);
+  for(xcc_link q = x + 1; q != x;) {
+    if(TOP(q) <= 0) {
+      q = ULINK(q);
+    } else {
+      select_node(p, algorithm, s, q);
+      q = q + 1;
+    }
+  }
+}
+
+static void
+deselect_option(xcc_problem* p, int algorithm, applied* s, xcc_link x) {
+  for(xcc_link q = x - 1; q != x;) {
+    if(TOP(q) <= 0) {
+      q = DLINK(q);
+    } else {
+      deselect_node(p, algorithm, s, q);
+      q = q - 1;
+    }
+  }
+  deselect_node(p, algorithm, s, x);
+  restore_option(p, x);
+}
+
+// Whether the option of node x was forced before, which unlinked it.
+static bool
+is_forced(applied* s, xcc_link x) {
+  for(size_t n = 0; n < s->forced_count; ++n)
+    if(s->forced[n] == x)
+      return true;
+  return false;
+}
+
+// Applies the assumptions, and returns false once a forced option conflicts
+// with them. Everything applied until then is recorded in s.
+static bool
+apply(xcc_problem* p, int algorithm, const xcc_assumptions* as, applied* s) {
+  for(size_t n = 0; n < as->excluded_count; ++n) {
+    xcc_link x = p->option_node[as->excluded[n]];
+    if(x && is_linked(p, x)) {
+      remove_option(p, x);
+      s->removed[s->removed_count++] = x;
+    }
+  }
+  for(size_t n = 0; n < as->excluded_item_count; ++n) {
+    xcc_link j = as->excluded_items[n];
+    while(DLINK(j) != j) {
+      xcc_link x = DLINK(j);
+      remove_option(p, x);
+      s->removed[s->removed_count++] = x;
+    }
+  }
+  for(size_t n = 0; n < as->forced_count; ++n) {
+    xcc_link x = p->option_node[as->forced[n]];
+    if(is_forced(s, x))
+      continue;
+    if(!x || !is_selectable(p, algorithm, s, x))
+      return false;
+    select_option(p, algorithm, s, x);
+    s->forced[s->forced_count++] = x;
+  }
+  return true;
+}
+
+static void
+undo(xcc_problem* p, int algorithm, applied* s) {
+  while(s->forced_count > 0)
+    deselect_option(p, algorithm, s, s->forced[--s->forced_count]);
+  while(s->removed_count > 0)
+    restore_option(p, s->removed[--s->removed_count]);
+}
+
+// Runs the search of a from the root. Returns the number of solutions found.
+static size_t
+search(xcc_algorithm* a,
+       xcc_problem* p,
+       size_t max_solutions,
+       xcc_solution_visitor visit,
+       void* userdata) {
+  p->state = 0;
+  p->l = 0;
+  p->fixed = 0;
+  p->nodes = 0;
+  p->forced = 0;
+
+  if(RLINK(0) == 0) {
+    // The forced options cover all primary items already.
+    p->x_size = 0;
+    if(visit)
+      visit(p, userdata);
+    return 1;
+  }
+
+  int tail_items = p->tail_items;
+  p->tail_items = 0;
+
+  size_t found = 0;
+  bool in_tree = false;
+  while(!max_solutions || found < max_solutions) {
+    in_tree = a->compute_next_result(a, p);
+    if(!in_tree)
+      break;
+    ++found;
+    if(visit && !visit(p, userdata))
+      break;
+  }
+  if(in_tree) {
+    // Backtrack to the root, trying no other branch.
+    p->fixed = p->l;
+    bool more = a->compute_next_result(a, p);
+    assert(!more);
+    (void)more;
+    p->fixed = 0;
+  }
+
+  // Searching again starts at the root.
+  p->state = 0;
+  p->tail_items = tail_items;
+  return found;
+}
+
+const char*
+xcc_solve_with_assumptions(xcc_algorithm* a,
+                           xcc_problem* p,
+                           int algorithm,
+                           const xcc_assumptions* as,
+                           size_t max_solutions,
+                           xcc_solution_visitor visit,
+                           void* userdata,
+                           size_t* solutions) {
+  assert(algorithm == XCC_ALGORITHM_X || algorithm == XCC_ALGORITHM_C ||
+         algorithm == XCC_ALGORITHM_M);
+  assert(!p->lds && !p->restart && !p->node_limit);
+
+  *solutions = 0;
+  if(p->nogoods || p->costs)
+    return "assumptions are not supported together with nogoods and costs";
+  for(size_t n = 0; n < as->forced_count; ++n)
+    if(as->forced[n] < 1 || as->forced[n] > p->option_count)
+      return "forced option out of range";
+  for(size_t n = 0; n < as->excluded_count; ++n)
+    if(as->excluded[n] < 1 || as->excluded[n] > p->option_count)
+      return "excluded option out of range";
+  for(size_t n = 0; n < as->excluded_item_count; ++n)
+    if(as->excluded_items[n] < 1 || as->excluded_items[n] > p->N)
+      return "excluded item out of range";
+
+  index_options(p);
+
+  applied s;
+  s.removed = malloc(p->option_count * sizeof(xcc_link));
+  s.removed_count = 0;
+  s.forced = malloc(p->option_count * sizeof(xcc_link));
+  s.forced_count = 0;
+  s.item = calloc(p->N + 1, sizeof(xcc_link));
+
+  if(apply(p, algorithm, as, &s))
+    *solutions = search(a, p, max_solutions, visit, userdata);
+  undo(p, algorithm, &s);
+
+  free(s.removed);
+  free(s.forced);
+  free(s.item);
+  return NULL;
+}
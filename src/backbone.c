@@ -0,0 +1,246 @@
+/*
+    XCCSolve - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef XCC_PARALLEL_AVAILABLE
+#include <pthread.h>
+#endif
+
+#include <xcc/algorithm.h>
+#include <xcc/assume.h>
+#include <xcc/backbone.h>
+
+// Classes of options that are still open: not in any solution found so far,
+// or in all of them.
+#define UNSEEN (XCC_BACKBONE_ALL + 1)
+#define CANDIDATE (XCC_BACKBONE_ALL + 2)
+
+typedef struct shared {
+  uint8_t* classes;
+  xcc_link option_count;
+  int algorithm;
+
+  // The next option whose turn it is, the options of the first solution that
+  // may still be in every solution, and marks for the options of a solution.
+  xcc_link next;
+  xcc_link* candidates;
+  size_t candidates_size;
+  uint8_t* in_solution;
+
+  xcc_backbone_stats stats;
+  const char* error;
+
+#ifdef XCC_PARALLEL_AVAILABLE
+  pthread_mutex_t lock;
+#endif
+} shared;
+
+typedef struct worker {
+  shared* s;
+  xcc_algorithm a;
+  xcc_problem* p;
+  const xcc_assumptions* as;
+
+  // Option indices of the last solution found.
+  xcc_link* solution;
+  xcc_link solution_size;
+
+#ifdef XCC_PARALLEL_AVAILABLE
+  pthread_t thread;
+#endif
+} worker;
+
+#ifdef XCC_PARALLEL_AVAILABLE
+#define LOCK(S) pthread_mutex_lock(&(S)->lock)
+#define UNLOCK(S) pthread_mutex_unlock(&(S)->lock)
+#else
+#define LOCK(S) ((void)(S))
+#define UNLOCK(S) ((void)(S))
+#endif
+
+static bool
+remember_solution(xcc_problem* p, void* userdata) {
+  worker* w = userdata;
+  w->solution_size = xcc_extract_solution_option_indices(p, w->solution);
+  for(size_t n = 0; n < w->as->forced_count; ++n)
+    w->solution[w->solution_size++] = w->as->forced[n];
+  return false;
+}
+
+// Searches for a solution under as. Returns the number of solutions found,
+// which is then in w->solution.
+static size_t
+query(worker* w, const xcc_assumptions* as, const char** error) {
+  size_t found = 0;
+  w->as = as;
+  *error = xcc_solve_with_assumptions(
+    &w->a, w->p, w->s->algorithm, as, 1, &remember_solution, w, &found);
+  return found;
+}
+
+// Marks the options of the solution of w as seen and takes away the
+// candidacy of all options that it does not contain. Called under the lock.
+static void
+record_solution(shared* s, worker* w) {
+  for(xcc_link n = 0; n < w->solution_size; ++n) {
+    xcc_link o = w->solution[n];
+    s->in_solution[o] = 1;
+    if(s->classes[o] == UNSEEN)
+      s->classes[o] = XCC_BACKBONE_SOME;
+  }
+  size_t kept = 0;
+  for(size_t n = 0; n < s->candidates_size; ++n) {
+    xcc_link o = s->candidates[n];
+    if(s->classes[o] != CANDIDATE)
+      continue;
+    if(s->in_solution[o])
+      s->candidates[kept++] = o;
+    else
+      s->classes[o] = XCC_BACKBONE_SOME;
+  }
+  s->candidates_size = kept;
+  for(xcc_link n = 0; n < w->solution_size; ++n)
+    s->in_solution[w->solution[n]] = 0;
+}
+
+// Decides the open options one after the other, as long as there are any.
+static void*
+decide(void* userdata) {
+  worker* w = userdata;
+  shared* s = w->s;
+  while(true) {
+    xcc_link o = 0;
+    uint8_t c = 0;
+    LOCK(s);
+    while(!o && !s->error && s->next <= s->option_count) {
+      xcc_link n = s->next++;
+      c = s->classes[n];
+      if(c == UNSEEN || c == CANDIDATE) {
+        o = n;
+        ++s->stats.queries;
+      } else {
+        ++s->stats.reused;
+      }
+    }
+    UNLOCK(s);
+    if(!o)
+      return NULL;
+
+    // Unseen options are in some solution if one can be forced, candidates
+    // are in all of them if there is none without them.
+    xcc_assumptions as;
+    memset(&as, 0, sizeof(as));
+    if(c == UNSEEN) {
+      as.forced = &o;
+      as.forced_count = 1;
+    } else {
+      as.excluded = &o;
+      as.excluded_count = 1;
+    }
+    const char* error;
+    size_t found = query(w, &as, &error);
+
+    LOCK(s);
+    if(error)
+      s->error = error;
+    else if(found)
+      record_solution(s, w);
+    else
+      s->classes[o] = c == UNSEEN ? XCC_BACKBONE_NONE : XCC_BACKBONE_ALL;
+    UNLOCK(s);
+  }
+}
+
+static void
+worker_init(worker* w, shared* s, xcc_algorithm* a, xcc_problem* p) {
+  w->s = s;
+  w->a = *a;
+  w->p = p;
+  w->as = NULL;
+  // Levels of M that cover an item no more also take an entry in x.
+  w->solution = malloc((p->option_count + p->N + 2) * sizeof(xcc_link));
+  w->solution_size = 0;
+}
+
+const char*
+xcc_backbone(xcc_algorithm* a,
+             xcc_problem* p,
+             int algorithm,
+             int threads,
+             uint8_t* classes,
+             xcc_backbone_stats* stats) {
+  assert(threads > 0);
+
+  shared s;
+  memset(&s, 0, sizeof(s));
+  s.classes = classes;
+  s.option_count = p->option_count;
+  s.algorithm = algorithm;
+  s.next = 1;
+  s.in_solution = calloc(p->option_count + 1, sizeof(uint8_t));
+  for(xcc_link o = 0; o <= p->option_count; ++o)
+    classes[o] = UNSEEN;
+
+  worker first;
+  worker_init(&first, &s, a, p);
+  xcc_assumptions none;
+  memset(&none, 0, sizeof(none));
+  ++s.stats.queries;
+  if(!query(&first, &none, &s.error)) {
+    for(xcc_link o = 0; o <= p->option_count; ++o)
+      classes[o] = XCC_BACKBONE_NONE;
+  } else {
+    s.candidates = malloc(first.solution_size * sizeof(xcc_link));
+    for(xcc_link n = 0; n < first.solution_size; ++n) {
+      classes[first.solution[n]] = CANDIDATE;
+      s.candidates[s.candidates_size++] = first.solution[n];
+    }
+
+#ifdef XCC_PARALLEL_AVAILABLE
+    if(threads > 1) {
+      pthread_mutex_init(&s.lock, NULL);
+      worker* workers = calloc(threads, sizeof(worker));
+      for(int i = 0; i < threads; ++i) {
+        worker_init(&workers[i], &s, a, xcc_problem_copy(p));
+        pthread_create(&workers[i].thread, NULL, &decide, &workers[i]);
+      }
+      for(int i = 0; i < threads; ++i) {
+        pthread_join(workers[i].thread, NULL);
+        xcc_problem_free(workers[i].p, &workers[i].a);
+        free(workers[i].solution);
+      }
+      free(workers);
+      pthread_mutex_destroy(&s.lock);
+    } else {
+      decide(&first);
+    }
+#else
+    decide(&first);
+#endif
+  }
+  classes[0] = XCC_BACKBONE_NONE;
+
+  free(first.solution);
+  free(s.candidates);
+  free(s.in_solution);
+  if(stats)
+    *stats = s.stats;
+  return s.error;
+}
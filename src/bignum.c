@@ -0,0 +1,170 @@
+/*
+    XCCSolve - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <xcc/bignum.h>
+
+static void
+reserve(xcc_bignum* n, size_t size) {
+  if(size > n->capacity) {
+    n->capacity = size > 2 * n->capacity ? size : 2 * n->capacity;
+    n->limbs = realloc(n->limbs, n->capacity * sizeof(uint32_t));
+  }
+}
+
+static void
+trim(xcc_bignum* n) {
+  while(n->size > 0 && n->limbs[n->size - 1] == 0)
+    --n->size;
+}
+
+void
+xcc_bignum_init(xcc_bignum* n) {
+  n->limbs = NULL;
+  n->size = 0;
+  n->capacity = 0;
+}
+
+void
+xcc_bignum_free(xcc_bignum* n) {
+  free(n->limbs);
+  xcc_bignum_init(n);
+}
+
+void
+xcc_bignum_set_u64(xcc_bignum* n, uint64_t v) {
+  reserve(n, 2);
+  n->limbs[0] = (uint32_t)v;
+  n->limbs[1] = (uint32_t)(v >> 32);
+  n->size = 2;
+  trim(n);
+}
+
+void
+xcc_bignum_set(xcc_bignum* n, const xcc_bignum* v) {
+  if(n == v)
+    return;
+  reserve(n, v->size);
+  if(v->size)
+    memcpy(n->limbs, v->limbs, v->size * sizeof(uint32_t));
+  n->size = v->size;
+}
+
+void
+xcc_bignum_add(xcc_bignum* n, const xcc_bignum* v) {
+  size_t size = n->size > v->size ? n->size : v->size;
+  reserve(n, size + 1);
+  uint64_t carry = 0;
+  for(size_t i = 0; i < size; ++i) {
+    uint64_t a = i < n->size ? n->limbs[i] : 0;
+    uint64_t b = i < v->size ? v->limbs[i] : 0;
+    carry += a + b;
+    n->limbs[i] = (uint32_t)carry;
+    carry >>= 32;
+  }
+  n->limbs[size] = (uint32_t)carry;
+  n->size = size + 1;
+  trim(n);
+}
+
+void
+xcc_bignum_sub(xcc_bignum* n, const xcc_bignum* v) {
+  assert(xcc_bignum_cmp(n, v) >= 0);
+  int64_t borrow = 0;
+  for(size_t i = 0; i < n->size; ++i) {
+    int64_t d = (int64_t)n->limbs[i] - (i < v->size ? v->limbs[i] : 0) - borrow;
+    borrow = d < 0;
+    n->limbs[i] = (uint32_t)(d + (borrow << 32));
+  }
+  trim(n);
+}
+
+void
+xcc_bignum_mul(xcc_bignum* r, const xcc_bignum* a, const xcc_bignum* b) {
+  assert(r != a && r != b);
+  if(a->size == 0 || b->size == 0) {
+    r->size = 0;
+    return;
+  }
+  size_t size = a->size + b->size;
+  reserve(r, size);
+  memset(r->limbs, 0, size * sizeof(uint32_t));
+  for(size_t i = 0; i < a->size; ++i) {
+    uint64_t carry = 0;
+    for(size_t j = 0; j < b->size; ++j) {
+      carry += (uint64_t)a->limbs[i] * b->limbs[j] + r->limbs[i + j];
+      r->limbs[i + j] = (uint32_t)carry;
+      carry >>= 32;
+    }
+    r->limbs[i + b->size] = (uint32_t)carry;
+  }
+  r->size = size;
+  trim(r);
+}
+
+int
+xcc_bignum_cmp(const xcc_bignum* a, const xcc_bignum* b) {
+  if(a->size != b->size)
+    return a->size < b->size ? -1 : 1;
+  for(size_t i = a->size; i > 0; --i) {
+    if(a->limbs[i - 1] != b->limbs[i - 1])
+      return a->limbs[i - 1] < b->limbs[i - 1] ? -1 : 1;
+  }
+  return 0;
+}
+
+char*
+xcc_bignum_to_string(const xcc_bignum* n) {
+  // Every limb has at most 10 decimal digits.
+  size_t digits = n->size * 10 + 1;
+  char* str = malloc(digits + 1);
+  char* end = str + digits;
+  char* s = end;
+  *s = '\0';
+
+  uint32_t* limbs = malloc((n->size + 1) * sizeof(uint32_t));
+  size_t size = n->size;
+  if(size)
+    memcpy(limbs, n->limbs, size * sizeof(uint32_t));
+
+  do {
+    // Divide by 10^9 and emit the remainder as 9 digits.
+    uint64_t rem = 0;
+    for(size_t i = size; i > 0; --i) {
+      uint64_t cur = (rem << 32) | limbs[i - 1];
+      limbs[i - 1] = (uint32_t)(cur / 1000000000u);
+      rem = cur % 1000000000u;
+    }
+    while(size > 0 && limbs[size - 1] == 0)
+      --size;
+    for(int d = 0; d < 9 && (size > 0 || rem > 0 || d == 0); ++d) {
+      *--s = '0' + rem % 10;
+      rem /= 10;
+    }
+    // Pad inner groups with zeros.
+    if(size > 0)
+      while((end - s) % 9 != 0)
+        *--s = '0';
+  } while(size > 0);
+
+  free(limbs);
+  memmove(str, s, end - s + 1);
+  return str;
+}
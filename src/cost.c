@@ -0,0 +1,200 @@
+/*
+    XCCSolve - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <xcc/algorithm.h>
+#include <xcc/cost.h>
+#include <xcc/ops.h>
+#include <xcc/order.h>
+
+static inline bool
+worse(const xcc_cost_solution* a, const xcc_cost_solution* b) {
+  if(a->cost != b->cost)
+    return a->cost > b->cost;
+  return a->found > b->found;
+}
+
+static int
+compare_solutions(const void* a, const void* b) {
+  const xcc_cost_solution* x = a;
+  const xcc_cost_solution* y = b;
+  return worse(x, y) ? 1 : worse(y, x) ? -1 : 0;
+}
+
+// Restores the max-heap property of best below position n.
+static void
+sift_down(xcc_costs* c, size_t n) {
+  while(true) {
+    size_t largest = n;
+    size_t left = 2 * n + 1, right = 2 * n + 2;
+    if(left < c->best_count && worse(&c->best[left], &c->best[largest]))
+      largest = left;
+    if(right < c->best_count && worse(&c->best[right], &c->best[largest]))
+      largest = right;
+    if(largest == n)
+      return;
+    xcc_cost_solution t = c->best[n];
+    c->best[n] = c->best[largest];
+    c->best[largest] = t;
+    n = largest;
+  }
+}
+
+static void
+sift_up(xcc_costs* c, size_t n) {
+  while(n > 0) {
+    size_t parent = (n - 1) / 2;
+    if(!worse(&c->best[n], &c->best[parent]))
+      return;
+    xcc_cost_solution t = c->best[n];
+    c->best[n] = c->best[parent];
+    c->best[parent] = t;
+    n = parent;
+  }
+}
+
+// Keeps the solution currently in p if it is among the k cheapest so far.
+// The kernels only report solutions below the bound, so it always is.
+static void
+add_solution(xcc_costs* c, const xcc_problem* p) {
+  xcc_cost_solution* s;
+  if(c->best_count < c->k) {
+    s = &c->best[c->best_count++];
+    s->x = malloc((p->l + 1) * sizeof(xcc_link));
+  } else {
+    // Replaces the most expensive one.
+    s = &c->best[0];
+    s->x = realloc(s->x, (p->l + 1) * sizeof(xcc_link));
+  }
+  s->cost = c->sum;
+  s->l = p->l;
+  s->found = c->found++;
+  memcpy(s->x, p->x, p->l * sizeof(xcc_link));
+
+  if(s == &c->best[0])
+    sift_down(c, 0);
+  else
+    sift_up(c, c->best_count - 1);
+
+  if(c->best_count == c->k)
+    c->bound = c->best[0].cost;
+}
+
+xcc_costs*
+xcc_costs_create(xcc_problem* p, size_t k) {
+  assert(k > 0);
+  xcc_order_options(p, XCC_ORDER_COST);
+
+  xcc_costs* c = calloc(1, sizeof(xcc_costs));
+  c->option = calloc(p->Z + 1, sizeof(int64_t));
+  c->share = calloc(p->Z + 1, sizeof(int64_t));
+  c->best = calloc(k, sizeof(xcc_cost_solution));
+  c->k = k;
+  c->bound = INT64_MAX;
+
+  // Every node first gets the cost and the even share of its option. Options
+  // without primary items are never selected.
+  int64_t* even = calloc(p->Z + 1, sizeof(int64_t));
+  xcc_link first = p->N + 2;
+  int64_t primaries = 0;
+  for(xcc_link x = first; x <= p->Z; ++x) {
+    if(TOP(x) > 0) {
+      primaries += TOP(x) <= p->N_1;
+      continue;
+    }
+    int64_t cost = xcc_option_cost(p, -TOP(x));
+    for(xcc_link y = first; y < x; ++y) {
+      c->option[y] = cost;
+      even[y] = primaries ? cost / primaries : 0;
+    }
+    first = x + 1;
+    primaries = 0;
+  }
+
+  // Only options still in the lists count, earlier steps may have removed
+  // others.
+  int64_t* charge = calloc(p->N_1 + 1, sizeof(int64_t));
+  for(xcc_link j = 1; j <= p->N_1; ++j) {
+    if(DLINK(j) == j)
+      continue;
+    charge[j] = INT64_MAX;
+    for(xcc_link x = DLINK(j); x != j; x = DLINK(x))
+      if(even[x] < charge[j])
+        charge[j] = even[x];
+  }
+  for(xcc_link j = RLINK(0); j != 0; j = RLINK(j))
+    c->rest += charge[j];
+
+  first = p->N + 2;
+  int64_t charged = 0;
+  for(xcc_link x = first; x <= p->Z; ++x) {
+    if(TOP(x) > 0) {
+      if(TOP(x) <= p->N_1)
+        charged += charge[TOP(x)];
+      continue;
+    }
+    for(xcc_link y = first; y < x; ++y)
+      c->share[y] = charged;
+    first = x + 1;
+    charged = 0;
+  }
+
+  free(charge);
+  free(even);
+  return c;
+}
+
+void
+xcc_costs_free(xcc_costs* c) {
+  if(!c)
+    return;
+  for(size_t n = 0; n < c->best_count; ++n)
+    free(c->best[n].x);
+  free(c->best);
+  free(c->option);
+  free(c->share);
+  free(c);
+}
+
+bool
+xcc_search_cheapest(xcc_algorithm* a, xcc_problem* p) {
+  xcc_costs* c = p->costs;
+  assert(c);
+
+  // The bitset tail does not know about costs.
+  p->tail_items = 0;
+  while(a->compute_next_result(a, p))
+    add_solution(c, p);
+
+  qsort(c->best,
+        c->best_count,
+        sizeof(xcc_cost_solution),
+        &compare_solutions);
+  return c->best_count > 0;
+}
+
+void
+xcc_costs_restore(xcc_problem* p, size_t n) {
+  assert(n < p->costs->best_count);
+  const xcc_cost_solution* s = &p->costs->best[n];
+  memcpy(p->x, s->x, s->l * sizeof(xcc_link));
+  p->l = s->l;
+  p->x_size = s->l;
+}
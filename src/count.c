@@ -0,0 +1,404 @@
+/*
+    XCCSolve - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <xcc/algorithm.h>
+#include <xcc/count.h>
+#include <xcc/ops.h>
+#include <xcc/signature.h>
+
+typedef struct entry {
+  uint64_t hash;
+  // Search nodes it took to compute the count, 0 for empty entries.
+  size_t work;
+  xcc_bignum count;
+} entry;
+
+typedef struct counter {
+  xcc_problem* p;
+  xcc_signature sig;
+
+  entry* entries;
+  uint64_t* keys;
+  size_t buckets;
+  size_t max_buckets;
+
+  // Result of every level of the search.
+  xcc_bignum* level;
+  xcc_bignum product;
+
+  // The sub-problem is split into components in the first levels only.
+  size_t component_depth;
+  xcc_link* component;
+  xcc_link* queue;
+
+  xcc_count_stats stats;
+} counter;
+
+static inline void
+cover(counter* c, xcc_link i) {
+  xcc_problem* p = c->p;
+  COVER(i);
+  xcc_signature_toggle(&c->sig, i);
+}
+
+static inline void
+uncover(counter* c, xcc_link i) {
+  xcc_problem* p = c->p;
+  UNCOVER(i);
+  xcc_signature_toggle(&c->sig, i);
+}
+
+static inline entry*
+bucket(counter* c) {
+  return c->entries + (c->sig.hash & (c->buckets - 1)) * XCC_COUNT_WAYS;
+}
+
+static inline uint64_t*
+key(counter* c, entry* e) {
+  return c->keys + (e - c->entries) * c->sig.words;
+}
+
+static entry*
+lookup(counter* c) {
+  entry* b = bucket(c);
+  for(entry* e = b; e < b + XCC_COUNT_WAYS; ++e) {
+    if(e->work && e->hash == c->sig.hash &&
+       xcc_signature_equals(&c->sig, key(c, e)))
+      return e;
+  }
+  return NULL;
+}
+
+static void
+allocate(counter* c, size_t buckets) {
+  size_t slots = buckets * XCC_COUNT_WAYS;
+  c->entries = calloc(slots, sizeof(entry));
+  c->keys = malloc(slots * c->sig.words * sizeof(uint64_t));
+  c->buckets = buckets;
+}
+
+// The table starts small and doubles while it is more than half full, until it
+// reaches the memory budget. Only then, entries are replaced.
+static void
+grow(counter* c) {
+  entry* entries = c->entries;
+  uint64_t* keys = c->keys;
+  size_t slots = c->buckets * XCC_COUNT_WAYS;
+  size_t words = c->sig.words;
+  allocate(c, c->buckets * 2);
+
+  for(size_t s = 0; s < slots; ++s) {
+    entry* e = &entries[s];
+    if(!e->work)
+      continue;
+    entry* b = c->entries + (e->hash & (c->buckets - 1)) * XCC_COUNT_WAYS;
+    while(b->work)
+      ++b;// Cannot overflow, the new bucket had at most as many entries.
+    *b = *e;
+    memcpy(key(c, b), keys + s * words, words * sizeof(uint64_t));
+  }
+  free(entries);
+  free(keys);
+}
+
+static void
+store(counter* c, const xcc_bignum* count, size_t work) {
+  if(c->buckets < c->max_buckets &&
+     2 * c->stats.entries >= c->buckets * XCC_COUNT_WAYS)
+    grow(c);
+
+  entry* b = bucket(c);
+  entry* victim = b;
+  for(entry* e = b; e < b + XCC_COUNT_WAYS; ++e) {
+    if(e->work < victim->work)
+      victim = e;
+  }
+  if(victim->work) {
+    // Keep the more expensive sub-problems.
+    if(victim->work > work)
+      return;
+    ++c->stats.evictions;
+  } else {
+    ++c->stats.entries;
+  }
+  ++c->stats.stores;
+  victim->hash = c->sig.hash;
+  victim->work = work;
+  xcc_bignum_set(&victim->count, count);
+  memcpy(key(c, victim), c->sig.active, c->sig.words * sizeof(uint64_t));
+}
+
+// Labels the active items reachable from active primary items with their
+// component, starting with 1, and lists them in c->queue grouped by component.
+// Returns the number of components.
+static xcc_link
+label_components(counter* c, xcc_link* queued) {
+  xcc_problem* p = c->p;
+  xcc_link components = 0, head = 0, tail = 0;
+  for(xcc_link i = RLINK(0); i != 0; i = RLINK(i)) {
+    if(c->component[i])
+      continue;
+    c->component[i] = ++components;
+    c->queue[tail++] = i;
+    while(head < tail) {
+      xcc_link j = c->queue[head++];
+      for(xcc_link x = DLINK(j); x != j; x = DLINK(x)) {
+        for(xcc_link q = x + 1; q != x;) {
+          xcc_link k = TOP(q);
+          if(k <= 0) {
+            q = ULINK(q);
+          } else {
+            if(!c->component[k]) {
+              c->component[k] = components;
+              c->queue[tail++] = k;
+            }
+            ++q;
+          }
+        }
+      }
+    }
+  }
+  *queued = tail;
+  return components;
+}
+
+// Links the primary items of component k, or all of them for k = 0, into the
+// list of active items in their original order.
+static void
+link_primary(xcc_problem* p,
+             const xcc_link* primary,
+             const xcc_link* label,
+             xcc_link size,
+             xcc_link k) {
+  xcc_link last = 0;
+  for(xcc_link n = 0; n < size; ++n) {
+    xcc_link i = primary[n];
+    if(k && label[n] != k)
+      continue;
+    RLINK(last) = i;
+    LLINK(i) = last;
+    last = i;
+  }
+  RLINK(last) = 0;
+  LLINK(0) = last;
+}
+
+static void
+count(counter* c, int d);
+
+// Multiplies the counts of the components into level[d]. Every component is
+// a sub-problem of its own, keyed by its items only, so that it is found in
+// the cache wherever it occurs again.
+static void
+count_components(counter* c, int d, xcc_link components, xcc_link queued) {
+  xcc_problem* p = c->p;
+  xcc_bignum* r = &c->level[d];
+  ++c->stats.splits;
+  c->stats.components += components;
+
+  // The labels and the queue are reused deeper in the search, so the
+  // components are copied first.
+  xcc_link size = 0;
+  for(xcc_link i = RLINK(0); i != 0; i = RLINK(i))
+    ++size;
+  xcc_link* primary = malloc((2 * size + queued + 2 * components + 2) *
+                             sizeof(xcc_link));
+  xcc_link* label = primary + size;
+  xcc_link* items = label + size;
+  xcc_link* first = items + queued;
+  xcc_link* order = first + components + 2;
+  size = 0;
+  for(xcc_link i = RLINK(0); i != 0; i = RLINK(i)) {
+    label[size] = c->component[i];
+    primary[size++] = i;
+  }
+  for(xcc_link n = queued; n > 0; --n)
+    first[c->component[c->queue[n - 1]]] = n - 1;
+  first[components + 1] = queued;
+  for(xcc_link n = 0; n < queued; ++n) {
+    items[n] = c->queue[n];
+    c->component[items[n]] = 0;
+  }
+
+  size_t words = c->sig.words;
+  uint64_t* active = malloc(words * sizeof(uint64_t));
+  memcpy(active, c->sig.active, words * sizeof(uint64_t));
+  uint64_t hash = c->sig.hash;
+
+  // Small components are cheap to count, and if one of them has no solution,
+  // the others need not be counted at all.
+  for(xcc_link k = 1; k <= components; ++k) {
+    xcc_link n = k - 1;
+    for(; n > 0; --n) {
+      xcc_link o = order[n - 1];
+      if(first[o + 1] - first[o] <= first[k + 1] - first[k])
+        break;
+      order[n] = o;
+    }
+    order[n] = k;
+  }
+
+  xcc_bignum_set_u64(r, 1);
+  for(xcc_link n = 0; n < components && !xcc_bignum_is_zero(r); ++n) {
+    xcc_link k = order[n];
+    link_primary(p, primary, label, size, k);
+    memset(c->sig.active, 0, words * sizeof(uint64_t));
+    c->sig.hash = 0;
+    for(xcc_link m = first[k]; m < first[k + 1]; ++m)
+      xcc_signature_toggle(&c->sig, items[m]);
+
+    count(c, d + 1);
+    xcc_bignum_mul(&c->product, r, &c->level[d + 1]);
+    xcc_bignum_set(r, &c->product);
+  }
+
+  link_primary(p, primary, label, size, 0);
+  memcpy(c->sig.active, active, words * sizeof(uint64_t));
+  c->sig.hash = hash;
+  free(active);
+  free(primary);
+}
+
+// Computes the number of solutions of the current sub-problem into level[d].
+static void
+count(counter* c, int d) {
+  xcc_problem* p = c->p;
+  xcc_bignum* r = &c->level[d];
+  if(RLINK(0) == 0) {
+    xcc_bignum_set_u64(r, 1);
+    return;
+  }
+
+  entry* e = lookup(c);
+  if(e) {
+    ++c->stats.hits;
+    xcc_bignum_set(r, &e->count);
+    return;
+  }
+
+  xcc_bignum_set_u64(r, 0);
+  xcc_link i = xcc_choose_mrv(p);
+  if(LEN(i) == 0)
+    return;
+
+  if((size_t)d < c->component_depth && RLINK(RLINK(0)) != 0) {
+    xcc_link queued;
+    xcc_link components = label_components(c, &queued);
+    if(components > 1) {
+      size_t start = p->nodes++;
+      count_components(c, d, components, queued);
+      store(c, r, p->nodes - start);
+      return;
+    }
+    for(xcc_link n = 0; n < queued; ++n)
+      c->component[c->queue[n]] = 0;
+  }
+
+  size_t start = p->nodes++;
+  cover(c, i);
+  for(xcc_link x = DLINK(i); x != i; x = DLINK(x)) {
+    for(xcc_link q = x + 1; q != x;) {
+      xcc_link j = TOP(q);
+      if(j <= 0) {
+        q = ULINK(q);
+      } else {
+        cover(c, j);
+        ++q;
+      }
+    }
+
+    count(c, d + 1);
+    xcc_bignum_add(r, &c->level[d + 1]);
+
+    for(xcc_link q = x - 1; q != x;) {
+      xcc_link j = TOP(q);
+      if(j <= 0) {
+        q = DLINK(q);
+      } else {
+        uncover(c, j);
+        --q;
+      }
+    }
+  }
+  uncover(c, i);
+
+  store(c, r, p->nodes - start);
+}
+
+const char*
+xcc_count_solutions_memoized(xcc_problem* p,
+                             size_t cache_bytes,
+                             size_t component_depth,
+                             xcc_bignum* result,
+                             xcc_count_stats* stats) {
+  assert(p);
+  assert(result);
+
+  const char* error = xcc_signature_check(p);
+  if(error)
+    return error;
+
+  counter c;
+  memset(&c, 0, sizeof(c));
+  c.p = p;
+  xcc_signature_init(&c.sig, p->N);
+
+  // Entries with their keys and about two limbs for the count each.
+  size_t entry_bytes =
+    sizeof(entry) + c.sig.words * sizeof(uint64_t) + 2 * sizeof(uint32_t);
+  c.max_buckets = 1;
+  while(2 * c.max_buckets * XCC_COUNT_WAYS * entry_bytes <= cache_bytes)
+    c.max_buckets *= 2;
+  allocate(&c, c.max_buckets < 1024 ? c.max_buckets : 1024);
+
+  // Every level covers at least one primary item, or splits the sub-problem
+  // into components. The next level of a component covers an item again.
+  xcc_link levels = 2 * p->N_1 + 3;
+  c.level = malloc(levels * sizeof(xcc_bignum));
+  for(xcc_link l = 0; l < levels; ++l)
+    xcc_bignum_init(&c.level[l]);
+  xcc_bignum_init(&c.product);
+
+  c.component_depth = component_depth;
+  if(component_depth) {
+    c.component = calloc(p->N + 1, sizeof(xcc_link));
+    c.queue = malloc((p->N + 1) * sizeof(xcc_link));
+  }
+
+  count(&c, 0);
+  xcc_bignum_set(result, &c.level[0]);
+
+  for(xcc_link l = 0; l < levels; ++l)
+    xcc_bignum_free(&c.level[l]);
+  free(c.level);
+  xcc_bignum_free(&c.product);
+  free(c.component);
+  free(c.queue);
+  for(size_t s = 0; s < c.buckets * XCC_COUNT_WAYS; ++s)
+    xcc_bignum_free(&c.entries[s].count);
+  free(c.entries);
+  free(c.keys);
+  xcc_signature_free(&c.sig);
+
+  if(stats)
+    *stats = c.stats;
+  return NULL;
+}
@@ -0,0 +1,357 @@
+/*
+    XCCSolve - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+// Count the mems of the operations of ops.h in this file.
+#define XCC_COUNT_MEMS
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <xcc/algorithm.h>
+#include <xcc/estimate.h>
+#include <xcc/ops.h>
+#include <xcc/signature.h>
+
+// The estimates of one probe. Every level of the probe remembers the weight
+// of its node and of the child that the probe went on with, which is d times
+// as large, so that undoing the level is charged like doing it.
+typedef struct probe {
+  double nodes;
+  double mems;
+  double solutions;
+  double* node_weight;
+  double* child_weight;
+} probe;
+
+// The running mean and sum of squared deviations of the estimates of one
+// quantity, see Welford's algorithm.
+typedef struct moments {
+  double mean;
+  double m2;
+} moments;
+
+static void
+moments_add(moments* m, double v, size_t n) {
+  double delta = v - m->mean;
+  m->mean += delta / n;
+  m->m2 += delta * (v - m->mean);
+}
+
+static xcc_estimate_value
+moments_value(const moments* m, size_t n) {
+  xcc_estimate_value v = { m->mean, 0 };
+  if(n > 1)
+    v.error = 1.96 * sqrt(m->m2 / (n - 1) / n);
+  return v;
+}
+
+// Returns the mems counted since *mark and moves the mark.
+static double
+spent(xcc_problem* p, size_t* mark) {
+  size_t mems = p->mems - *mark;
+  *mark = p->mems;
+  return mems;
+}
+
+static xcc_link
+random_branch(xcc_link d, uint64_t* state) {
+  return xcc_xorshift64(state) % (uint64_t)d;
+}
+
+// Covers the other items of the option of node x like X5 or C5.
+static void
+cover_option_xc(xcc_problem* p, xcc_link x, bool colors) {
+  for(xcc_link q = x + 1; q != x;) {
+    xcc_link j = TOP(q);
+    if(j <= 0) {
+      q = ULINK(q);
+    } else {
+      if(colors)
+        COMMIT(q, j);
+      else
+        COVER(j);
+      q = q + 1;
+    }
+  }
+}
+
+static void
+uncover_option_xc(xcc_problem* p, xcc_link x, bool colors) {
+  for(xcc_link q = x - 1; q != x;) {
+    xcc_link j = TOP(q);
+    if(j <= 0) {
+      q = DLINK(q);
+    } else {
+      if(colors)
+        UNCOMMIT(q, j);
+      else
+        UNCOVER(j);
+      q = q - 1;
+    }
+  }
+}
+
+// Covers the other items of the option of node x like M6.
+static void
+cover_option_m(xcc_problem* p, xcc_link x) {
+  for(xcc_link q = x + 1; q != x;) {
+    xcc_link j = TOP(q);
+    if(j <= 0) {
+      q = ULINK(q);
+    } else if(j <= p->N_1) {
+      BOUND(j) = BOUND(j) - 1;
+      if(BOUND(j) == 0)
+        COVER_PRIME(j);
+      q = q + 1;
+    } else {
+      COMMIT(q, j);
+      q = q + 1;
+    }
+  }
+}
+
+static void
+uncover_option_m(xcc_problem* p, xcc_link x) {
+  for(xcc_link q = x - 1; q != x;) {
+    xcc_link j = TOP(q);
+    if(j <= 0) {
+      q = DLINK(q);
+    } else if(j <= p->N_1) {
+      BOUND(j) = BOUND(j) + 1;
+      if(BOUND(j) == 1)
+        UNCOVER_PRIME(j);
+      q = q - 1;
+    } else {
+      UNCOMMIT(q, j);
+      q = q - 1;
+    }
+  }
+}
+
+// One probe of Algorithm X, or of C if colors is set.
+static void
+probe_xc(xcc_algorithm* a,
+         xcc_problem* p,
+         bool colors,
+         uint64_t* state,
+         probe* r) {
+  xcc_link* x = p->x;
+  size_t mark = p->mems;
+  double w = 1;
+  int l = 0;
+
+  while(RLINK(0) != 0) {
+    xcc_link i = a->choose_i(a, p);
+    xcc_link d = LEN(i);
+    if(d != 1)
+      r->nodes += w;// The kernels count no forced moves
+    if(colors)
+      COVER_PRIME(i);
+    else
+      COVER(i);
+    r->mems += w * spent(p, &mark);
+    if(d == 0) {
+      if(colors)
+        UNCOVER_PRIME(i);
+      else
+        UNCOVER(i);
+      r->mems += w * spent(p, &mark);
+      break;
+    }
+
+    x[l] = DLINK(i);
+    for(xcc_link k = random_branch(d, state); k > 0; --k)
+      x[l] = DLINK(x[l]);
+    r->node_weight[l] = w;
+    w *= d;
+    r->child_weight[l] = w;
+    cover_option_xc(p, x[l], colors);
+    r->mems += w * spent(p, &mark);
+    ++l;
+  }
+
+  if(RLINK(0) == 0)
+    r->solutions += w;
+
+  while(l > 0) {
+    --l;
+    uncover_option_xc(p, x[l], colors);
+    r->mems += r->child_weight[l] * spent(p, &mark);
+    xcc_link i = TOP(x[l]);
+    if(colors)
+      UNCOVER_PRIME(i);
+    else
+      UNCOVER(i);
+    r->mems += r->node_weight[l] * spent(p, &mark);
+  }
+}
+
+// One probe of Algorithm M. The d = THETA(i) branches of a node are the
+// options of i in the order of M5 and, if i may be covered less often than
+// BOUND(i), finally the branch that covers i no more. Taking branch k tweaks
+// the options of the k branches before it, like M5 does.
+static void
+probe_m(xcc_algorithm* a, xcc_problem* p, uint64_t* state, probe* r) {
+  xcc_link* x = p->x;
+  size_t mark = p->mems;
+  double w = 1;
+  int l = 0;
+
+  while(RLINK(0) != 0) {
+    xcc_link i = a->choose_i(a, p);
+    if(LEN(i) == 1 && BOUND(i) == 1 && SLACK(i) == 0) {
+      BOUND(i) = 0;
+      COVER_PRIME(i);
+      x[l] = DLINK(i);
+      cover_option_m(p, x[l]);
+      r->mems += w * spent(p, &mark);
+      r->node_weight[l] = w;
+      r->child_weight[l] = w;
+      ++l;
+      continue;
+    }
+
+    r->nodes += w;
+    xcc_link d = THETA(i);
+    if(d == 0)
+      break;
+
+    // M4
+    x[l] = DLINK(i);
+    BOUND(i) = BOUND(i) - 1;
+    if(BOUND(i) == 0)
+      COVER_PRIME(i);
+    if(BOUND(i) != 0 || SLACK(i) != 0)
+      FT(l) = x[l];
+    r->mems += w * spent(p, &mark);
+
+    xcc_link k = random_branch(d, state);
+    if(BOUND(i) == 0 && SLACK(i) == 0) {
+      for(; k > 0; --k)
+        x[l] = DLINK(x[l]);
+    } else {
+      for(; k > 0; --k) {
+        assert(x[l] != i);
+        if(BOUND(i) == 0)
+          TWEAK_PRIME(x[l], i);
+        else
+          TWEAK(x[l], i);
+        x[l] = DLINK(x[l]);
+      }
+      spent(p, &mark);// The earlier branches are estimated by their sibling
+      if(x[l] != i) {
+        if(BOUND(i) == 0)
+          TWEAK_PRIME(x[l], i);
+        else
+          TWEAK(x[l], i);
+      } else if(BOUND(i) != 0) {
+        xcc_link left = LLINK(i), right = RLINK(i);
+        RLINK(left) = right;
+        LLINK(right) = left;
+      }
+    }
+
+    r->node_weight[l] = w;
+    w *= d;
+    r->child_weight[l] = w;
+    if(x[l] != i)
+      cover_option_m(p, x[l]);
+    r->mems += w * spent(p, &mark);
+    ++l;
+  }
+
+  if(RLINK(0) == 0)
+    r->solutions += w;
+
+  // Undone like M7, M8 and M9.
+  while(l > 0) {
+    --l;
+    xcc_link i;
+    if(x[l] <= p->N) {
+      i = x[l];
+      xcc_link left = LLINK(i), right = RLINK(i);
+      RLINK(left) = i;
+      LLINK(right) = i;
+    } else {
+      i = TOP(x[l]);
+      uncover_option_m(p, x[l]);
+    }
+    r->mems += r->child_weight[l] * spent(p, &mark);
+    if(BOUND(i) == 0 && SLACK(i) == 0)
+      UNCOVER_PRIME(i);
+    else if(BOUND(i) == 0)
+      UNTWEAK_PRIME(l);
+    else
+      UNTWEAK(l);
+    BOUND(i) = BOUND(i) + 1;
+    r->mems += r->node_weight[l] * spent(p, &mark);
+  }
+}
+
+void
+xcc_estimate_search(xcc_algorithm* a,
+                    xcc_problem* p,
+                    int algorithm,
+                    size_t probes,
+                    uint64_t seed,
+                    xcc_estimate* e) {
+  assert(a->choose_i);
+  assert(algorithm == XCC_ALGORITHM_X || algorithm == XCC_ALGORITHM_C ||
+         algorithm == XCC_ALGORITHM_M);
+
+  // Every level selects an option, except for the levels of M that cover an
+  // item no more, which happens at most once per item.
+  size_t levels = p->option_count + p->N + 1;
+  if(p->x_capacity < levels) {
+    p->x = realloc(p->x, sizeof(xcc_link) * levels);
+    p->x_capacity = levels;
+    p->x_size = 0;
+  }
+  p->buckets = false;
+
+  probe r;
+  r.node_weight = malloc(levels * sizeof(double));
+  r.child_weight = malloc(levels * sizeof(double));
+
+  uint64_t state = seed ^ 0x9e3779b97f4a7c15ull;
+  if(state == 0)
+    state = 1;
+
+  moments nodes = { 0, 0 }, mems = { 0, 0 }, solutions = { 0, 0 };
+  for(size_t n = 1; n <= probes; ++n) {
+    r.nodes = 0;
+    r.mems = 0;
+    r.solutions = 0;
+    if(algorithm == XCC_ALGORITHM_M)
+      probe_m(a, p, &state, &r);
+    else
+      probe_xc(a, p, algorithm == XCC_ALGORITHM_C, &state, &r);
+    moments_add(&nodes, r.nodes, n);
+    moments_add(&mems, r.mems, n);
+    moments_add(&solutions, r.solutions, n);
+  }
+
+  free(r.node_weight);
+  free(r.child_weight);
+
+  e->probes = probes;
+  e->nodes = moments_value(&nodes, probes);
+  e->mems = moments_value(&mems, probes);
+  e->solutions = moments_value(&solutions, probes);
+}
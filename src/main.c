@@ -22,11 +22,23 @@
 #include <string.h>
 
 #include <xcc/algorithm.h>
+#include <xcc/algorithm_bitset.h>
+#include <xcc/backbone.h>
+#include <xcc/cost.h>
+#include <xcc/count.h>
+#include <xcc/estimate.h>
 #include <xcc/git.h>
 #include <xcc/log.h>
+#include <xcc/nogood.h>
 #include <xcc/ops.h>
+#include <xcc/order.h>
+#include <xcc/parallel.h>
 #include <xcc/parse.h>
+#include <xcc/preprocess.h>
+#include <xcc/restart.h>
+#include <xcc/symmetry.h>
 #include <xcc/xcc.h>
+#include <xcc/zdd.h>
 
 static void
 print_help() {
@@ -36,14 +48,80 @@ print_help() {
   printf("  -p\t\tprint selected options\n");
   printf("  -e\t\tenumerate all solutions\n");
   printf("  -E\t\tprint the problem matrix in libExact format (only -x)\n");
+  printf("  -t N\t\tsearch with N threads (X, C and M)\n");
+  printf("  --count\tcount all solutions with a cache of sub-problems\n"
+         "    \t\t    (no colors or multiplicities)\n");
+  printf("  --cache-size MB\tmemory budget of the --count and --nogoods "
+         "caches\n    \t\t    (default %d)\n",
+         XCC_COUNT_DEFAULT_CACHE_MB);
+  printf("  --components D	count independent parts of sub-problems separately "
+         "\n    \t\t    in the first D levels of the --count search\n");
+  printf("  --preprocess\tremove options and items that cannot matter before "
+         "\n    \t\t    solving (not with -m, -p prints the reduced "
+         "options)\n");
+  printf("  --probe\tremove options after which some primary item cannot "
+         "be\n    \t\t    covered anymore before solving (-p prints the "
+         "reduced options)\n");
+  printf("  --probe-time S\tstop probing after S seconds of processor "
+         "time\n");
+  printf("  --symmetry\tfind every solution only once up to the automorphisms "
+         "\n    \t\t    of the problem (not with -t, --count and -z)\n");
+  printf("  --orbits\tprint the size of the orbit of every solution (implies "
+         "\n    \t\t    --symmetry)\n");
+  printf("  --nogoods\tskip sub-problems that were searched before without a "
+         "\n    \t\t    solution (-x and -c, not with -t, --count, -z "
+         "and --lds)\n");
+  printf("  --lds\t\tsearch by limited discrepancy, i.e. first all paths that "
+         "take\n    \t\t    the first branch everywhere, then those that "
+         "deviate once,\n    \t\t    and so on (-x, -c and -m, not with -t, "
+         "--count, -z,\n    \t\t    --symmetry and --restarts)\n");
+  printf("  --restarts N\tsearch with restarts after N times the Luby "
+         "sequence\n    \t\t    of branches, in a random order after the "
+         "first run\n    \t\t    (-x, -c and -m, not with -t, --count, -z "
+         "and --symmetry)\n");
+  printf("  --restart-growth F\trestart after N, N * F, N * F^2, ... "
+         "branches\n");
+  printf("  --seed S\tseed of the random order of --restarts and of the "
+         "random\n    \t\t    choices of --sample and --estimate (default "
+         "0)\n");
+  printf("  --order O\ttry the options of an item in the order O: least "
+         "(fewest\n    \t\t    conflicts first), most (most conflicts "
+         "first),\n    \t\t    priority (highest = N in the input "
+         "first) or cost\n    \t\t    (lowest $ N first, not with -b)\n");
+  printf("  --min-cost\tfind the solution with the smallest sum of the costs "
+         "\n    \t\t    ($ N in the input) of its options (-x and -c, not "
+         "with\n    \t\t    -t, --count, -z, --symmetry, --lds, --restarts, "
+         "--nogoods\n    \t\t    and --order)\n");
+  printf("  --top K\tfind the K cheapest solutions like --min-cost\n");
+  printf("  -z FILE\tbuild the ZDD of all solutions and write it to FILE\n"
+         "    \t\t    (Algorithm Z, no colors or multiplicities)\n");
+  printf("  --sample N\tprint N solutions drawn uniformly at random from the "
+         "ZDD\n    \t\t    of all solutions (like -z)\n");
+  printf("  --estimate N\testimate the branches, mems and solutions of the "
+         "search\n    \t\t    from N random paths from the root to a leaf "
+         "(not with\n    \t\t    -t, --count, -z, --sample, --symmetry, "
+         "--lds, --restarts,\n    \t\t    --nogoods, --min-cost and -k)\n");
+  printf("  --backbone\tprint for every option whether it is in all, some or "
+         "no\n    \t\t    solutions (-p also prints the option, -t N splits "
+         "the\n    \t\t    options among N threads)\n");
   printf("ALGORITHM SELECTORS:\n");
   printf("  --naive\tuse naive in-order for i selection\n");
   printf("  --mrv\t\tuse MRV for i selection (default)\n");
   printf("  --smrv\tuse slack-aware MRV for i selection (default for M)\n    "
          "    \t    (see answer to ex. 166, p. 271)\n");
+  printf("  --wmrv\tuse MRV weighted by the items that ran out of options "
+         "\n    \t\t    before (dom/wdeg, not with -d and -b)\n");
   printf("  -x\t\tuse Algorithm X\n");
   printf("  -c\t\tuse Algorithm C\n");
   printf("  -m\t\tuse Algorithm M\n");
+  printf("  -d\t\tuse dancing cells (sparse sets) instead of dancing links\n"
+         "    \t\t    (XCC like -c, always uses MRV)\n");
+  printf("  -b\t\tuse bitsets instead of dancing links (at most %d items,\n"
+         "    \t\t    XCC like -c, always uses MRV)\n",
+         XCC_BITSET_MAX_ITEMS);
+  printf("  --no-bitset\tnever switch -x or -c to bitsets (done by default for "
+         "\n    \t\t    at most %d items and MRV)\n",
+         XCC_BITSET_MAX_ITEMS);
   printf("  -k\t\tcall external binary to solve with SAT\n    \t\t    (Knuth's "
          "trivial encoding)\n");
   printf("VERSION:\n");
@@ -69,7 +147,7 @@ static void
 parse_cli(xcc_config* cfg, int argc, char* argv[]) {
   int c;
 
-  int sel[5];
+  int sel[6];
   memset(sel, 0, sizeof(sel));
 
   struct option long_options[] = {
@@ -79,13 +157,38 @@ parse_cli(xcc_config* cfg, int argc, char* argv[]) {
     { "print", no_argument, 0, 'p' },
     { "print-x", no_argument, 0, XCC_OPTION_PRINT_X },
     { "enumerate", no_argument, 0, 'e' },
+    { "threads", required_argument, 0, 't' },
+    { "zdd", required_argument, 0, 'z' },
+    { "count", no_argument, &cfg->count, 1 },
+    { "cache-size", required_argument, 0, XCC_OPTION_CACHE_SIZE },
+    { "components", required_argument, 0, XCC_OPTION_COMPONENTS },
+    { "preprocess", no_argument, &cfg->preprocess, 1 },
+    { "probe", no_argument, &cfg->probe, 1 },
+    { "probe-time", required_argument, 0, XCC_OPTION_PROBE_TIME },
+    { "symmetry", no_argument, &cfg->symmetry, 1 },
+    { "orbits", no_argument, &cfg->orbits, 1 },
+    { "lds", no_argument, &cfg->lds, 1 },
+    { "nogoods", no_argument, &cfg->nogoods, 1 },
+    { "backbone", no_argument, &cfg->backbone, 1 },
+    { "order", required_argument, 0, XCC_OPTION_ORDER },
+    { "min-cost", no_argument, 0, XCC_OPTION_MIN_COST },
+    { "top", required_argument, 0, XCC_OPTION_TOP },
+    { "sample", required_argument, 0, XCC_OPTION_SAMPLE },
+    { "estimate", required_argument, 0, XCC_OPTION_ESTIMATE },
+    { "restarts", required_argument, 0, XCC_OPTION_RESTARTS },
+    { "restart-growth", required_argument, 0, XCC_OPTION_RESTART_GROWTH },
+    { "seed", required_argument, 0, XCC_OPTION_SEED },
     { "naive", no_argument, &sel[0], XCC_ALGORITHM_NAIVE },
     { "mrv", no_argument, &sel[1], XCC_ALGORITHM_MRV },
     { "smrv", no_argument, &sel[1], XCC_ALGORITHM_MRV },
+    { "wmrv", no_argument, &sel[1], XCC_ALGORITHM_WEIGHTED },
     { "x", no_argument, &sel[2], XCC_ALGORITHM_X },
     { "c", no_argument, &sel[3], XCC_ALGORITHM_C },
     { "m", no_argument, &sel[3], XCC_ALGORITHM_M },
     { "k", no_argument, &sel[4], XCC_ALGORITHM_KNUTH_CNF },
+    { "dc", no_argument, &sel[3], XCC_ALGORITHM_DC },
+    { "bitset", no_argument, &sel[3], XCC_ALGORITHM_BITSET },
+    { "no-bitset", no_argument, &sel[5], XCC_ALGORITHM_NO_BITSET },
     { 0, 0, 0, 0 }
   };
 
@@ -93,7 +196,8 @@ parse_cli(xcc_config* cfg, int argc, char* argv[]) {
 
     int option_index = 0;
 
-    c = getopt_long(argc, argv, "eEpsxcmkhVv", long_options, &option_index);
+    c = getopt_long(
+      argc, argv, "eEpsxcmdbkhVvt:z:", long_options, &option_index);
 
     if(c == -1)
       break;
@@ -117,6 +221,93 @@ parse_cli(xcc_config* cfg, int argc, char* argv[]) {
       case 'E':
         cfg->transform_to_libexact = 1;
         break;
+      case 't':
+        cfg->threads = atoi(optarg);
+        if(cfg->threads < 1) {
+          err("Invalid number of threads: %s", optarg);
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case 'z':
+        cfg->zdd_file = optarg;
+        break;
+      case XCC_OPTION_CACHE_SIZE:
+        if(atoi(optarg) < 1) {
+          err("Invalid cache size: %s", optarg);
+          exit(EXIT_FAILURE);
+        }
+        cfg->cache_mb = atoi(optarg);
+        break;
+      case XCC_OPTION_PROBE_TIME:
+        if(atof(optarg) <= 0) {
+          err("Invalid probing time: %s", optarg);
+          exit(EXIT_FAILURE);
+        }
+        cfg->probe_seconds = atof(optarg);
+        break;
+      case XCC_OPTION_RESTARTS:
+        if(atoi(optarg) < 1) {
+          err("Invalid restart interval: %s", optarg);
+          exit(EXIT_FAILURE);
+        }
+        cfg->restart_unit = atoi(optarg);
+        break;
+      case XCC_OPTION_RESTART_GROWTH:
+        if(atof(optarg) <= 1) {
+          err("Invalid restart growth: %s", optarg);
+          exit(EXIT_FAILURE);
+        }
+        cfg->restart_growth = atof(optarg);
+        break;
+      case XCC_OPTION_ORDER:
+        if(strcmp(optarg, "least") == 0)
+          cfg->option_order = XCC_ORDER_LEAST_CONSTRAINING;
+        else if(strcmp(optarg, "most") == 0)
+          cfg->option_order = XCC_ORDER_MOST_CONSTRAINING;
+        else if(strcmp(optarg, "priority") == 0)
+          cfg->option_order = XCC_ORDER_PRIORITY;
+        else if(strcmp(optarg, "cost") == 0)
+          cfg->option_order = XCC_ORDER_COST;
+        else {
+          err("Invalid option order: %s", optarg);
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case XCC_OPTION_MIN_COST:
+        if(!cfg->cheapest)
+          cfg->cheapest = 1;
+        break;
+      case XCC_OPTION_TOP:
+        if(atoi(optarg) < 1) {
+          err("Invalid number of cheapest solutions: %s", optarg);
+          exit(EXIT_FAILURE);
+        }
+        cfg->cheapest = atoi(optarg);
+        break;
+      case XCC_OPTION_SAMPLE:
+        if(atoi(optarg) < 1) {
+          err("Invalid number of samples: %s", optarg);
+          exit(EXIT_FAILURE);
+        }
+        cfg->samples = atoi(optarg);
+        break;
+      case XCC_OPTION_ESTIMATE:
+        if(atoi(optarg) < 1) {
+          err("Invalid number of probes: %s", optarg);
+          exit(EXIT_FAILURE);
+        }
+        cfg->estimate = atoi(optarg);
+        break;
+      case XCC_OPTION_SEED:
+        cfg->seed = strtoull(optarg, NULL, 10);
+        break;
+      case XCC_OPTION_COMPONENTS:
+        if(atoi(optarg) < 1) {
+          err("Invalid component depth: %s", optarg);
+          exit(EXIT_FAILURE);
+        }
+        cfg->component_depth = atoi(optarg);
+        break;
       case 'h':
         print_help();
         exit(EXIT_SUCCESS);
@@ -132,6 +323,12 @@ parse_cli(xcc_config* cfg, int argc, char* argv[]) {
       case 'k':
         cfg->algorithm_select |= XCC_ALGORITHM_KNUTH_CNF;
         break;
+      case 'd':
+        cfg->algorithm_select |= XCC_ALGORITHM_DC;
+        break;
+      case 'b':
+        cfg->algorithm_select |= XCC_ALGORITHM_BITSET;
+        break;
       default:
         break;
     }
@@ -146,8 +343,451 @@ parse_cli(xcc_config* cfg, int argc, char* argv[]) {
     cfg->algorithm_select |= sel[i];
 }
 
+// Prints cfg->samples solutions drawn uniformly at random from z like the
+// solutions of a search.
+static void
+print_samples(xcc_problem* p, xcc_config* cfg, xcc_zdd* z) {
+  // First node of every option, which puts a sample into x.
+  xcc_link* start = calloc(p->option_count + 1, sizeof(xcc_link));
+  xcc_link first = p->N + 2;
+  for(xcc_link x = first; x <= p->Z; ++x) {
+    if(TOP(x) <= 0) {
+      start[-TOP(x)] = first;
+      first = x + 1;
+    }
+  }
+  if(p->x_capacity < (size_t)p->option_count + 1) {
+    p->x = realloc(p->x, sizeof(xcc_link) * (p->option_count + 1));
+    p->x_capacity = p->option_count + 1;
+  }
+
+  uint64_t state = cfg->seed ^ 0x9e3779b97f4a7c15ull;
+  if(state == 0)
+    state = 1;
+  uint32_t* options = malloc((z->option_count + 1) * sizeof(uint32_t));
+  for(size_t n = 0; n < cfg->samples && z->root != XCC_ZDD_BOTTOM; ++n) {
+    size_t l = xcc_zdd_random_solution(z, &state, options);
+    for(size_t k = 0; k < l; ++k)
+      p->x[k] = start[options[k]];
+    p->l = l;
+    p->x_size = l;
+    xcc_print_solution(p, cfg);
+    printf("\n");
+  }
+  free(options);
+  free(start);
+}
+
+static int
+build_zdd(xcc_problem* p, xcc_config* cfg) {
+  xcc_zdd* z = NULL;
+  const char* error = xcc_zdd_build(p, &z);
+  if(!error && cfg->zdd_file)
+    error = xcc_zdd_write(z, cfg->zdd_file);
+  if(error) {
+    err("ZDD error: %s", error);
+    xcc_zdd_free(z);
+    return EXIT_FAILURE;
+  }
+
+  char* count = xcc_bignum_to_string(xcc_zdd_count(z));
+  if(cfg->zdd_file)
+    printf("Wrote ZDD with %zu nodes to %s\n", z->size, cfg->zdd_file);
+  if(cfg->samples)
+    print_samples(p, cfg, z);
+  printf("Found %s solutions!\n", count);
+  int return_code = z->root != XCC_ZDD_BOTTOM ? 10 : 20;
+  free(count);
+  xcc_zdd_free(z);
+  return return_code;
+}
+
+// Which of Algorithms X, C and M was selected.
+static int
+dancing_links_algorithm(const xcc_config* cfg) {
+  if(cfg->algorithm_select & XCC_ALGORITHM_X)
+    return XCC_ALGORITHM_X;
+  if(cfg->algorithm_select & XCC_ALGORITHM_C)
+    return XCC_ALGORITHM_C;
+  return XCC_ALGORITHM_M;
+}
+
+static int
+estimate_search(xcc_algorithm* a, xcc_problem* p, xcc_config* cfg) {
+  int algorithm = dancing_links_algorithm(cfg);
+  xcc_estimate e;
+  xcc_estimate_search(a, p, algorithm, cfg->estimate, cfg->seed, &e);
+  printf("Estimated from %zu probes, with 95%% confidence intervals:\n",
+         e.probes);
+  printf("Branches: %.6g +- %.3g\n", e.nodes.mean, e.nodes.error);
+  printf("Mems: %.6g +- %.3g\n", e.mems.mean, e.mems.error);
+  printf("Solutions: %.6g +- %.3g\n", e.solutions.mean, e.solutions.error);
+  return EXIT_SUCCESS;
+}
+
+static int
+classify_options(xcc_algorithm* a, xcc_problem* p, xcc_config* cfg) {
+  static const char* names[] = { "none", "some", "all" };
+  uint8_t* classes = malloc(p->option_count + 1);
+  xcc_backbone_stats stats;
+  const char* error = xcc_backbone(a,
+                                   p,
+                                   dancing_links_algorithm(cfg),
+                                   cfg->threads > 1 ? cfg->threads : 1,
+                                   classes,
+                                   &stats);
+  if(error) {
+    err("Backbone error: %s", error);
+    free(classes);
+    return EXIT_FAILURE;
+  }
+
+  size_t count[3] = { 0, 0, 0 };
+  for(xcc_link o = 1; o <= p->option_count; ++o) {
+    ++count[classes[o]];
+    printf("%" XCC_PRI_LINK " %s", o, names[classes[o]]);
+    // Options removed by preprocessing have no nodes.
+    xcc_link x = p->option_node ? p->option_node[o] : 0;
+    if(cfg->print_options && x) {
+      printf(":");
+      for(; TOP(x) > 0; ++x) {
+        printf(" %s", NAME(TOP(x)));
+        if(COLOR(x) > 0)
+          printf(":%s", p->color_name[COLOR(x)]);
+      }
+      printf(";");
+    }
+    printf("\n");
+  }
+  printf("Options in all solutions: %zu, in some: %zu, in none: %zu\n",
+         count[XCC_BACKBONE_ALL],
+         count[XCC_BACKBONE_SOME],
+         count[XCC_BACKBONE_NONE]);
+  if(cfg->verbose)
+    printf("Searches: %zu, options decided by earlier solutions: %zu\n",
+           stats.queries,
+           stats.reused);
+  free(classes);
+  return count[XCC_BACKBONE_ALL] + count[XCC_BACKBONE_SOME] > 0 ? 10 : 20;
+}
+
+static int
+count_solutions(xcc_problem* p, xcc_config* cfg) {
+  size_t cache_mb = cfg->cache_mb ? cfg->cache_mb : XCC_COUNT_DEFAULT_CACHE_MB;
+  xcc_bignum count;
+  xcc_bignum_init(&count);
+  xcc_count_stats stats;
+  const char* error = xcc_count_solutions_memoized(
+    p, cache_mb << 20, cfg->component_depth, &count, &stats);
+  if(error) {
+    err("Count error: %s", error);
+    return EXIT_FAILURE;
+  }
+
+  if(cfg->verbose)
+    printf("Nodes: %zu, cache hits: %zu, stores: %zu, evictions: %zu, "
+           "entries: %zu, splits: %zu into %zu components\n",
+           p->nodes,
+           stats.hits,
+           stats.stores,
+           stats.evictions,
+           stats.entries,
+           stats.splits,
+           stats.components);
+
+  char* str = xcc_bignum_to_string(&count);
+  printf("Found %s solutions!\n", str);
+  int return_code = xcc_bignum_is_zero(&count) ? 20 : 10;
+  free(str);
+  xcc_bignum_free(&count);
+  return return_code;
+}
+
+static bool
+preprocess(xcc_algorithm* a, xcc_problem* p, xcc_config* cfg) {
+  xcc_preprocess_stats stats;
+  const char* error = xcc_preprocess(a, p, cfg->algorithm_select, &stats);
+  if(error) {
+    err("Preprocessing error: %s", error);
+    return false;
+  }
+  printf("Preprocessing removed %zu options (%zu blocked, %zu dominated, %zu "
+         "without primary items) and %zu items in %zu rounds\n",
+         stats.blocked_options + stats.dominated_options +
+           stats.secondary_options,
+         stats.blocked_options,
+         stats.dominated_options,
+         stats.secondary_options,
+         stats.removed_items,
+         stats.rounds);
+  return true;
+}
+
+static bool
+probe(xcc_algorithm* a, xcc_problem* p, xcc_config* cfg) {
+  xcc_preprocess_stats stats;
+  const char* error =
+    xcc_probe(a, p, cfg->algorithm_select, cfg->probe_seconds, &stats);
+  if(error) {
+    err("Probing error: %s", error);
+    return false;
+  }
+  printf("Probing removed %zu options with %zu probes in %zu rounds%s\n",
+         stats.blocked_options,
+         stats.probes,
+         stats.rounds,
+         stats.timed_out ? ", stopped after the time limit" : "");
+  return true;
+}
+
+static int
+solve_up_to_symmetry(xcc_algorithm* a, xcc_problem* p, xcc_config* cfg) {
+  xcc_symmetry s;
+  const char* error = xcc_symmetry_detect(p, &s);
+  if(error) {
+    err("Symmetry error: %s", error);
+    return EXIT_FAILURE;
+  }
+  xcc_symmetry_break(p, &s);
+
+  if(s.gave_up)
+    printf("Gave up detecting symmetries after %zu nodes\n", s.nodes);
+  else
+    printf("Found %zu automorphisms in %zu nodes\n", s.order, s.nodes);
+  if(s.item)
+    printf("Restricted %s to one option per orbit, removing %zu options\n",
+           p->name[s.item],
+           s.removed_options);
+
+  int return_code = 20;
+  size_t solutions = 0, total = 0;
+  xcc_link* solution = malloc((p->option_count + 1) * sizeof(xcc_link));
+  while(a->compute_next_result(a, p)) {
+    xcc_link l = xcc_extract_solution_option_indices(p, solution);
+    // Like the other searches, M does not report that no option is chosen.
+    if(!l)
+      continue;
+    size_t orbit = xcc_symmetry_orbit_size(&s, solution, l);
+    if(!orbit)
+      continue;
+    return_code = 10;
+    ++solutions;
+    total += orbit;
+    xcc_print_solution(p, cfg);
+    if(cfg->orbits)
+      printf("Orbit size: %zu\n", orbit);
+    if(!cfg->enumerate)
+      break;
+    printf("\n");
+  }
+
+  if(cfg->enumerate)
+    printf("Found %zu solutions up to symmetry, %zu in total!\n",
+           solutions,
+           total);
+
+  free(solution);
+  xcc_symmetry_free(&s);
+  return return_code;
+}
+
+static int
+solve_with_restarts(xcc_algorithm* a, xcc_problem* p, xcc_config* cfg) {
+  size_t restarts;
+  bool found = xcc_search_with_restarts(
+    a, p, cfg->restart_unit, cfg->restart_growth, cfg->seed, &restarts);
+
+  // The rest of the last run holds all other solutions.
+  size_t solutions = 0;
+  while(found) {
+    if(xcc_print_solution(p, cfg))
+      ++solutions;
+    if(!cfg->enumerate)
+      break;
+    printf("\n");
+    found = a->compute_next_result(a, p);
+  }
+
+  if(cfg->enumerate)
+    printf("Found %zu solutions!\n", solutions);
+  if(cfg->verbose)
+    printf("Branches: %zu, forced moves: %zu, restarts: %zu\n",
+           p->nodes,
+           p->forced,
+           restarts);
+  return solutions > 0 ? 10 : 20;
+}
+
+static int
+solve_cheapest(xcc_algorithm* a, xcc_problem* p, xcc_config* cfg) {
+  p->costs = xcc_costs_create(p, cfg->cheapest);
+  bool found = xcc_search_cheapest(a, p);
+
+  for(size_t n = 0; n < p->costs->best_count; ++n) {
+    if(n > 0)
+      printf("\n");
+    xcc_costs_restore(p, n);
+    xcc_print_solution(p, cfg);
+    printf("Cost: %" PRId64 "\n", p->costs->best[n].cost);
+  }
+
+  if(cfg->verbose)
+    printf("Branches: %zu, forced moves: %zu, pruned by cost: %zu\n",
+           p->nodes,
+           p->forced,
+           p->costs->pruned);
+  return found ? 10 : 20;
+}
+
+static void
+print_nogood_stats(const xcc_problem* p, const xcc_config* cfg) {
+  if(!cfg->verbose || !p->nogoods)
+    return;
+  const xcc_nogood_stats* s = &p->nogoods->stats;
+  printf("Nogood lookups: %zu, hits: %zu, stores: %zu, evictions: %zu, "
+         "entries: %zu\n",
+         s->lookups,
+         s->hits,
+         s->stores,
+         s->evictions,
+         s->entries);
+}
+
+// Plain searches of X and C use bitsets for small problems and deep subtrees.
+// The bitset engine tries the options in the order of the input and knows
+// nothing of discrepancies and the nogood cache.
+static void
+use_bitsets(xcc_algorithm* a, xcc_problem* p, xcc_config* cfg) {
+  if(!cfg->lds && !cfg->nogoods && !cfg->option_order)
+    xcc_algorithm_use_bitsets(cfg->algorithm_select, a, p);
+}
+
 static int
 process_file(xcc_config* cfg) {
+  if(cfg->orbits)
+    cfg->symmetry = 1;
+  if(cfg->symmetry && (cfg->threads > 1 || cfg->count || cfg->zdd_file)) {
+    err("Symmetry breaking is not supported with -t, --count and -z!");
+    return EXIT_FAILURE;
+  }
+
+  if((cfg->algorithm_select & XCC_ALGORITHM_WEIGHTED) &&
+     (cfg->algorithm_select & (XCC_ALGORITHM_DC | XCC_ALGORITHM_BITSET))) {
+    err("Weighted MRV is not supported with -d and -b!");
+    return EXIT_FAILURE;
+  }
+
+  if(cfg->lds &&
+     (cfg->threads > 1 || cfg->count || cfg->zdd_file || cfg->symmetry ||
+      cfg->restart_unit ||
+      (cfg->algorithm_select & (XCC_ALGORITHM_DC | XCC_ALGORITHM_BITSET |
+                                XCC_ALGORITHM_KNUTH_CNF)))) {
+    err("Limited discrepancy search is only supported with -x, -c and -m, "
+        "not with -t, --count, -z, --symmetry and --restarts!");
+    return EXIT_FAILURE;
+  }
+
+  if(cfg->restart_unit &&
+     (cfg->threads > 1 || cfg->count || cfg->zdd_file || cfg->symmetry ||
+      (cfg->algorithm_select & (XCC_ALGORITHM_DC | XCC_ALGORITHM_BITSET |
+                                XCC_ALGORITHM_KNUTH_CNF)))) {
+    err("Restarts are only supported with -x, -c and -m, not with -t, "
+        "--count, -z and --symmetry!");
+    return EXIT_FAILURE;
+  }
+
+  if(cfg->nogoods &&
+     (cfg->threads > 1 || cfg->count || cfg->zdd_file || cfg->lds ||
+      (cfg->algorithm_select &
+       (XCC_ALGORITHM_M | XCC_ALGORITHM_DC | XCC_ALGORITHM_BITSET |
+        XCC_ALGORITHM_KNUTH_CNF)))) {
+    err("The nogood cache is only supported with -x and -c, not with -t, "
+        "--count, -z and --lds!");
+    return EXIT_FAILURE;
+  }
+
+  if(cfg->option_order &&
+     (cfg->algorithm_select &
+      (XCC_ALGORITHM_BITSET | XCC_ALGORITHM_KNUTH_CNF))) {
+    err("Option orders are not supported with -b and -k!");
+    return EXIT_FAILURE;
+  }
+
+  if(cfg->cheapest &&
+     (cfg->threads > 1 || cfg->count || cfg->zdd_file || cfg->symmetry ||
+      cfg->lds || cfg->restart_unit || cfg->nogoods || cfg->option_order ||
+      (cfg->algorithm_select &
+       (XCC_ALGORITHM_M | XCC_ALGORITHM_DC | XCC_ALGORITHM_BITSET |
+        XCC_ALGORITHM_KNUTH_CNF)))) {
+    err("Minimum-cost search is only supported with -x and -c, not with -t, "
+        "--count, -z, --symmetry, --lds, --restarts, --nogoods and "
+        "--order!");
+    return EXIT_FAILURE;
+  }
+
+  if(cfg->samples &&
+     (cfg->threads > 1 || cfg->count || cfg->symmetry || cfg->lds ||
+      cfg->restart_unit || cfg->nogoods || cfg->cheapest)) {
+    err("Sampling is not supported with -t, --count, --symmetry, --lds, "
+        "--restarts, --nogoods and --min-cost!");
+    return EXIT_FAILURE;
+  }
+
+  if(cfg->estimate) {
+    if(cfg->threads > 1 || cfg->count || cfg->zdd_file || cfg->samples ||
+       cfg->symmetry || cfg->lds || cfg->restart_unit || cfg->nogoods ||
+       cfg->cheapest ||
+       !(cfg->algorithm_select &
+         (XCC_ALGORITHM_X | XCC_ALGORITHM_C | XCC_ALGORITHM_M |
+          XCC_ALGORITHM_DC | XCC_ALGORITHM_BITSET))) {
+      err("Estimates are only supported with -x, -c, -m, -d and -b, not with "
+          "-t, --count, -z, --sample, --symmetry, --lds, --restarts, "
+          "--nogoods and --min-cost!");
+      return EXIT_FAILURE;
+    }
+  }
+
+  if(cfg->backbone &&
+     (cfg->count || cfg->zdd_file || cfg->samples || cfg->symmetry ||
+      cfg->lds || cfg->restart_unit || cfg->nogoods || cfg->cheapest ||
+      cfg->estimate ||
+      !(cfg->algorithm_select &
+        (XCC_ALGORITHM_X | XCC_ALGORITHM_C | XCC_ALGORITHM_M |
+         XCC_ALGORITHM_DC | XCC_ALGORITHM_BITSET)))) {
+    err("Backbones are only supported with -x, -c, -m, -d and -b, not with "
+        "--count, -z, --sample, --symmetry, --lds, --restarts, --nogoods, "
+        "--min-cost and --estimate!");
+    return EXIT_FAILURE;
+  }
+
+  if((cfg->estimate || cfg->backbone) &&
+     !(cfg->algorithm_select & (XCC_ALGORITHM_X | XCC_ALGORITHM_C)) &&
+     (cfg->algorithm_select & (XCC_ALGORITHM_DC | XCC_ALGORITHM_BITSET))) {
+    // Dancing cells and bitsets search like Algorithm C with MRV, so the tree
+    // of C is estimated for them, and C finds their solutions. Both only
+    // work on dancing links. Their mems are not those of C, though.
+    if(cfg->estimate)
+      printf("Estimating the search of -c with MRV, which chooses the same "
+             "items as %s\n",
+             cfg->algorithm_select & XCC_ALGORITHM_DC ? "-d" : "-b");
+    cfg->algorithm_select =
+      (cfg->algorithm_select &
+       ~(XCC_ALGORITHM_DC | XCC_ALGORITHM_BITSET | XCC_ALGORITHM_NAIVE |
+         XCC_ALGORITHM_MRV_SLACKER | XCC_ALGORITHM_WEIGHTED)) |
+      XCC_ALGORITHM_C | XCC_ALGORITHM_MRV;
+  }
+
+  if((cfg->zdd_file || cfg->samples || cfg->count) &&
+     (cfg->algorithm_select & XCC_ALGORITHM_M)) {
+    err("Counting, -z and --sample do not support multiplicities, so they are "
+        "not supported with -m!");
+    return EXIT_FAILURE;
+  }
+
+  // The ZDD and the counter use the dancing links of Algorithm X.
+  if(cfg->zdd_file || cfg->samples || cfg->count)
+    cfg->algorithm_select |= XCC_ALGORITHM_X;
+
   xcc_algorithm a;
   if(!xcc_algorithm_from_select(cfg->algorithm_select, &a)) {
     err("Could not extract algorithm from algorithm select! Try different "
@@ -161,6 +801,7 @@ process_file(xcc_config* cfg) {
     return EXIT_FAILURE;
 
   p->cfg = cfg;
+  p->lds = cfg->lds;
 
   if(cfg->verbose)
     xcc_print_problem_matrix(p);
@@ -174,7 +815,83 @@ process_file(xcc_config* cfg) {
       return EXIT_SUCCESS;
   }
 
-  int return_code = xcc_solve_problem_and_print_solutions(&a, p, cfg);
+  if(cfg->preprocess && !preprocess(&a, p, cfg)) {
+    xcc_problem_free(p, &a);
+    return EXIT_FAILURE;
+  }
+
+  if(cfg->probe && !probe(&a, p, cfg)) {
+    xcc_problem_free(p, &a);
+    return EXIT_FAILURE;
+  }
+
+  xcc_order_options(p, cfg->option_order);
+
+  if(cfg->nogoods) {
+    size_t cache_mb =
+      cfg->cache_mb ? cfg->cache_mb : XCC_COUNT_DEFAULT_CACHE_MB;
+    p->nogoods = xcc_nogoods_create(p, cache_mb << 20);
+  }
+
+  if(cfg->symmetry) {
+    use_bitsets(&a, p, cfg);
+    int return_code = solve_up_to_symmetry(&a, p, cfg);
+    print_nogood_stats(p, cfg);
+    xcc_problem_free(p, &a);
+    return return_code;
+  }
+
+  if(cfg->estimate) {
+    int return_code = estimate_search(&a, p, cfg);
+    xcc_problem_free(p, &a);
+    return return_code;
+  }
+
+  if(cfg->backbone) {
+    int return_code = classify_options(&a, p, cfg);
+    xcc_problem_free(p, &a);
+    return return_code;
+  }
+
+  if(cfg->zdd_file || cfg->samples) {
+    int return_code = build_zdd(p, cfg);
+    xcc_problem_free(p, &a);
+    return return_code;
+  }
+
+  if(cfg->count) {
+    int return_code = count_solutions(p, cfg);
+    xcc_problem_free(p, &a);
+    return return_code;
+  }
+
+  if(cfg->restart_unit) {
+    int return_code = solve_with_restarts(&a, p, cfg);
+    print_nogood_stats(p, cfg);
+    xcc_problem_free(p, &a);
+    return return_code;
+  }
+
+  if(cfg->cheapest) {
+    int return_code = solve_cheapest(&a, p, cfg);
+    xcc_problem_free(p, &a);
+    return return_code;
+  }
+
+  int return_code;
+  if(cfg->threads > 1) {
+    if(!(cfg->algorithm_select &
+         (XCC_ALGORITHM_X | XCC_ALGORITHM_C | XCC_ALGORITHM_M))) {
+      err("Multi-threaded solving is only supported with -x, -c and -m!");
+      xcc_problem_free(p, &a);
+      return EXIT_FAILURE;
+    }
+    return_code = xcc_solve_problem_parallel_and_print_solutions(&a, p, cfg);
+  } else {
+    use_bitsets(&a, p, cfg);
+    return_code = xcc_solve_problem_and_print_solutions(&a, p, cfg);
+  }
+  print_nogood_stats(p, cfg);
 
   xcc_problem_free(p, &a);
   return return_code;
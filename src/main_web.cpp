@@ -52,6 +52,7 @@ solve(std::string problem,
   if(cfg.verbose)
     xcc_print_problem_matrix(p);
 
+  xcc_algorithm_use_bitsets(algorithm_select, &a, p);
   int status = xcc_solve_problem_and_print_solutions(&a, p, &cfg);
 
   xcc_problem_free(p, &a);
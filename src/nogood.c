@@ -0,0 +1,167 @@
+/*
+    XCCSolve - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdlib.h>
+#include <string.h>
+
+#include <xcc/nogood.h>
+#include <xcc/ops.h>
+
+static inline xcc_nogood_entry*
+bucket(xcc_nogoods* g, uint64_t hash) {
+  return g->entries + (hash & (g->buckets - 1)) * XCC_NOGOOD_WAYS;
+}
+
+static inline uint64_t*
+key(xcc_nogoods* g, xcc_nogood_entry* e) {
+  return g->keys + (e - g->entries) * g->key_words;
+}
+
+static inline bool
+equals(xcc_nogoods* g, const uint64_t* k) {
+  return xcc_signature_equals(&g->sig, k) &&
+         (!g->color || memcmp(g->color,
+                              k + g->sig.words,
+                              g->color_words * sizeof(uint64_t)) == 0);
+}
+
+static void
+allocate(xcc_nogoods* g, size_t buckets) {
+  size_t slots = buckets * XCC_NOGOOD_WAYS;
+  g->entries = calloc(slots, sizeof(xcc_nogood_entry));
+  g->keys = malloc(slots * g->key_words * sizeof(uint64_t));
+  g->buckets = buckets;
+}
+
+// Grows like the cache of xcc_count_solutions_memoized.
+static void
+grow(xcc_nogoods* g) {
+  xcc_nogood_entry* entries = g->entries;
+  uint64_t* keys = g->keys;
+  size_t slots = g->buckets * XCC_NOGOOD_WAYS;
+  allocate(g, g->buckets * 2);
+
+  for(size_t s = 0; s < slots; ++s) {
+    xcc_nogood_entry* e = &entries[s];
+    if(!e->work)
+      continue;
+    xcc_nogood_entry* b = bucket(g, e->hash);
+    while(b->work)
+      ++b;// Cannot overflow, the new bucket had at most as many entries.
+    *b = *e;
+    memcpy(key(g, b),
+           keys + s * g->key_words,
+           g->key_words * sizeof(uint64_t));
+  }
+  free(entries);
+  free(keys);
+}
+
+xcc_nogoods*
+xcc_nogoods_create(const xcc_problem* p, size_t cache_bytes) {
+  xcc_nogoods* g = calloc(1, sizeof(xcc_nogoods));
+  g->N_1 = p->N_1;
+
+  // Only the items in the lists are active, earlier steps may have covered
+  // others.
+  xcc_signature_init(&g->sig, p->N);
+  memset(g->sig.active, 0, g->sig.words * sizeof(uint64_t));
+  g->sig.hash = 0;
+  for(xcc_link i = RLINK(0); i != 0; i = RLINK(i))
+    xcc_signature_toggle(&g->sig, i);
+  for(xcc_link i = RLINK(p->N + 1); i != p->N + 1; i = RLINK(i))
+    xcc_signature_toggle(&g->sig, i);
+
+  // The first color name is the reserved NULL of uncolored nodes.
+  if(p->color_name_size > 1 && p->N > p->N_1) {
+    size_t bytes = (p->N - p->N_1) * sizeof(xcc_color);
+    g->color_words = (bytes + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    g->color = calloc(g->color_words, sizeof(uint64_t));
+  }
+  g->key_words = g->sig.words + g->color_words;
+
+  size_t entry_bytes =
+    sizeof(xcc_nogood_entry) + g->key_words * sizeof(uint64_t);
+  g->max_buckets = 1;
+  while(2 * g->max_buckets * XCC_NOGOOD_WAYS * entry_bytes <= cache_bytes)
+    g->max_buckets *= 2;
+  allocate(g, g->max_buckets < 1024 ? g->max_buckets : 1024);
+
+  g->level_solutions = malloc((p->option_count + 1) * sizeof(size_t));
+  g->level_nodes = malloc((p->option_count + 1) * sizeof(size_t));
+  return g;
+}
+
+void
+xcc_nogoods_free(xcc_nogoods* g) {
+  if(!g)
+    return;
+  xcc_signature_free(&g->sig);
+  free(g->color);
+  free(g->entries);
+  free(g->keys);
+  free(g->level_solutions);
+  free(g->level_nodes);
+  free(g);
+}
+
+bool
+xcc_nogoods_lookup(xcc_nogoods* g) {
+  ++g->stats.lookups;
+  xcc_nogood_entry* b = bucket(g, g->sig.hash);
+  for(xcc_nogood_entry* e = b; e < b + XCC_NOGOOD_WAYS; ++e) {
+    if(e->work && e->hash == g->sig.hash && equals(g, key(g, e))) {
+      ++g->stats.hits;
+      return true;
+    }
+  }
+  return false;
+}
+
+void
+xcc_nogoods_leave(xcc_nogoods* g, int l, size_t nodes) {
+  if(g->solutions != g->level_solutions[l])
+    return;
+  // Forced levels take no node, but are worth storing as well.
+  size_t work = nodes - g->level_nodes[l] + 1;
+
+  if(g->buckets < g->max_buckets &&
+     2 * g->stats.entries >= g->buckets * XCC_NOGOOD_WAYS)
+    grow(g);
+
+  xcc_nogood_entry* b = bucket(g, g->sig.hash);
+  xcc_nogood_entry* victim = b;
+  for(xcc_nogood_entry* e = b; e < b + XCC_NOGOOD_WAYS; ++e) {
+    if(e->work < victim->work)
+      victim = e;
+  }
+  if(victim->work) {
+    // Keep the more expensive sub-problems.
+    if(victim->work > work)
+      return;
+    ++g->stats.evictions;
+  } else {
+    ++g->stats.entries;
+  }
+  ++g->stats.stores;
+  victim->hash = g->sig.hash;
+  victim->work = work;
+  uint64_t* k = key(g, victim);
+  memcpy(k, g->sig.active, g->sig.words * sizeof(uint64_t));
+  if(g->color)
+    memcpy(k + g->sig.words, g->color, g->color_words * sizeof(uint64_t));
+}
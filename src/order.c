@@ -0,0 +1,152 @@
+/*
+    XCCSolve - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <xcc/ops.h>
+#include <xcc/order.h>
+
+typedef struct entry {
+  int64_t key;
+  xcc_link pos;
+  xcc_link node;
+} entry;
+
+static int
+compare_entries(const void* a, const void* b) {
+  const entry* x = a;
+  const entry* y = b;
+  if(x->key != y->key)
+    return x->key < y->key ? -1 : 1;
+  return x->pos < y->pos ? -1 : x->pos > y->pos;
+}
+
+static int
+compare_colors(const void* a, const void* b) {
+  xcc_color x = *(const xcc_color*)a;
+  xcc_color y = *(const xcc_color*)b;
+  return x < y ? -1 : x > y;
+}
+
+// Index of the first color in the sorted colors that is at least c.
+static xcc_link
+lower_bound(const xcc_color* colors, xcc_link n, xcc_color c) {
+  xcc_link lo = 0, hi = n;
+  while(lo < hi) {
+    xcc_link mid = lo + (hi - lo) / 2;
+    if(colors[mid] < c)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+// Stores in conflicts[x] the number of other nodes in the list of TOP(x) that
+// cannot be selected together with x. Nodes of the same color are compatible.
+static void
+count_conflicts(xcc_problem* p, int64_t* conflicts, xcc_color* colors) {
+  for(xcc_link j = 1; j <= p->N; ++j) {
+    xcc_link n = 0;
+    bool colored = false;
+    for(xcc_link x = DLINK(j); x != j; x = DLINK(x)) {
+      colors[n++] = COLOR(x);
+      colored |= COLOR(x) > 0;
+    }
+    if(colored)
+      qsort(colors, n, sizeof(xcc_color), &compare_colors);
+    for(xcc_link x = DLINK(j); x != j; x = DLINK(x)) {
+      xcc_color c = COLOR(x);
+      if(c > 0)
+        conflicts[x] = n - (lower_bound(colors, n, c + 1) -
+                            lower_bound(colors, n, c));
+      else
+        conflicts[x] = n - 1;
+    }
+  }
+}
+
+void
+xcc_relink_column(xcc_problem* p,
+                  xcc_link j,
+                  const xcc_link* nodes,
+                  xcc_link n) {
+  xcc_link prev = j;
+  for(xcc_link k = 0; k < n; ++k) {
+    DLINK(prev) = nodes[k];
+    ULINK(nodes[k]) = prev;
+    prev = nodes[k];
+  }
+  DLINK(prev) = j;
+  ULINK(j) = prev;
+}
+
+void
+xcc_order_options(xcc_problem* p, xcc_option_order order) {
+  if(order == XCC_ORDER_INPUT)
+    return;
+
+  // Every node gets the sort key of its option.
+  int64_t* key = calloc(p->Z + 1, sizeof(int64_t));
+  if(order != XCC_ORDER_PRIORITY && order != XCC_ORDER_COST) {
+    xcc_color* colors = malloc((p->option_count + 1) * sizeof(xcc_color));
+    count_conflicts(p, key, colors);
+    free(colors);
+  }
+  xcc_link first = p->N + 2;
+  int64_t sum = 0;
+  for(xcc_link x = first; x <= p->Z; ++x) {
+    if(TOP(x) > 0) {
+      sum += key[x];
+      continue;
+    }
+    int64_t k = sum;
+    if(order == XCC_ORDER_MOST_CONSTRAINING)
+      k = -sum;
+    else if(order == XCC_ORDER_PRIORITY)
+      k = -(int64_t)xcc_option_priority(p, -TOP(x));
+    else if(order == XCC_ORDER_COST)
+      k = xcc_option_cost(p, -TOP(x));
+    for(xcc_link y = first; y < x; ++y)
+      key[y] = k;
+    first = x + 1;
+    sum = 0;
+  }
+
+  entry* entries = malloc((p->option_count + 1) * sizeof(entry));
+  xcc_link* nodes = malloc((p->option_count + 1) * sizeof(xcc_link));
+  for(xcc_link j = 1; j <= p->N; ++j) {
+    xcc_link n = 0;
+    for(xcc_link x = DLINK(j); x != j; x = DLINK(x)) {
+      entries[n].key = key[x];
+      entries[n].pos = n;
+      entries[n].node = x;
+      ++n;
+    }
+    if(n < 2)
+      continue;
+    qsort(entries, n, sizeof(entry), &compare_entries);
+    for(xcc_link k = 0; k < n; ++k)
+      nodes[k] = entries[k].node;
+    xcc_relink_column(p, j, nodes, n);
+  }
+
+  free(nodes);
+  free(entries);
+  free(key);
+}
@@ -0,0 +1,305 @@
+/*
+    XCCSolve - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <xcc/algorithm.h>
+#include <xcc/log.h>
+#include <xcc/ops.h>
+#include <xcc/parallel.h>
+#include <xcc/util.h>
+#include <xcc/xcc.h>
+
+// A task is a path from the root of the search tree. The worker replays the
+// nodes in prefix and explores everything after the last one of them.
+typedef struct task {
+  xcc_link* prefix;
+  int prefix_size;
+} task;
+
+typedef struct shared {
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  pthread_mutex_t print_lock;
+
+  task* tasks;
+  size_t tasks_size;
+  size_t tasks_capacity;
+
+  int threads;
+  int idle;
+  bool done;
+
+  atomic_int waiting;
+  atomic_bool stop;
+
+  size_t yield_nodes;
+  xcc_config* cfg;
+  bool (*visit)(xcc_problem* p, void* userdata);
+  void* userdata;
+} shared;
+
+typedef struct worker {
+  pthread_t thread;
+  shared* s;
+  xcc_algorithm a;
+  xcc_problem* p;
+  size_t solutions;
+} worker;
+
+static void
+push_task(shared* s, xcc_link* prefix, int prefix_size) {
+  pthread_mutex_lock(&s->lock);
+  if(s->tasks_size == s->tasks_capacity) {
+    s->tasks_capacity = s->tasks_capacity ? s->tasks_capacity * 2 : 16;
+    s->tasks = realloc(s->tasks, s->tasks_capacity * sizeof(task));
+  }
+  s->tasks[s->tasks_size].prefix = prefix;
+  s->tasks[s->tasks_size].prefix_size = prefix_size;
+  ++s->tasks_size;
+  pthread_cond_signal(&s->cond);
+  pthread_mutex_unlock(&s->lock);
+}
+
+static bool
+pop_task(shared* s, task* t) {
+  bool success = false;
+  pthread_mutex_lock(&s->lock);
+  ++s->idle;
+  atomic_fetch_add(&s->waiting, 1);
+  while(true) {
+    if(s->done || atomic_load(&s->stop)) {
+      s->done = true;
+      break;
+    }
+    if(s->tasks_size > 0) {
+      *t = s->tasks[--s->tasks_size];
+      success = true;
+      break;
+    }
+    if(s->idle == s->threads) {
+      // Nobody is working anymore, so nobody can donate new tasks.
+      s->done = true;
+      break;
+    }
+    pthread_cond_wait(&s->cond, &s->lock);
+  }
+  --s->idle;
+  atomic_fetch_sub(&s->waiting, 1);
+  if(s->done)
+    pthread_cond_broadcast(&s->cond);
+  pthread_mutex_unlock(&s->lock);
+  return success;
+}
+
+static void
+stop_all(shared* s) {
+  pthread_mutex_lock(&s->lock);
+  atomic_store(&s->stop, true);
+  pthread_cond_broadcast(&s->cond);
+  pthread_mutex_unlock(&s->lock);
+}
+
+// Hand the unexplored branches of the shallowest open level to the task queue.
+// Levels that are already in their last branch (Algorithm M skipping an item)
+// cannot be split.
+static void
+donate(worker* w) {
+  xcc_problem* p = w->p;
+  if(p->prefix_size > 0)
+    return;
+
+  for(int l = p->fixed; l < p->l; ++l) {
+    if(p->x[l] <= p->N)
+      continue;
+
+    xcc_link* prefix = malloc((l + 1) * sizeof(xcc_link));
+    memcpy(prefix, p->x, (l + 1) * sizeof(xcc_link));
+    p->fixed = l + 1;
+    push_task(w->s, prefix, l + 1);
+    return;
+  }
+}
+
+// Returns false if the search should stop after this solution.
+static bool
+report_solution(worker* w) {
+  shared* s = w->s;
+  if(!s->cfg && !s->visit) {
+    ++w->solutions;
+    return true;
+  }
+
+  bool go_on = true;
+  pthread_mutex_lock(&s->print_lock);
+  if(atomic_load(&s->stop)) {
+    go_on = false;
+  } else if(s->visit) {
+    ++w->solutions;
+    go_on = s->visit(w->p, s->userdata);
+  } else {
+    if(xcc_print_solution(w->p, s->cfg))
+      ++w->solutions;
+    if(s->cfg->enumerate)
+      printf("\n");
+    else
+      go_on = false;
+  }
+  pthread_mutex_unlock(&s->print_lock);
+  return go_on;
+}
+
+static void
+run_task(worker* w, task* t) {
+  shared* s = w->s;
+  xcc_problem* p = w->p;
+
+  p->prefix = t->prefix;
+  p->prefix_size = t->prefix_size;
+  p->fixed = t->prefix_size > 0 ? t->prefix_size - 1 : 0;
+  p->state = 0;
+  p->node_limit = p->nodes + s->yield_nodes;
+
+  while(!atomic_load(&s->stop)) {
+    bool has_solution = w->a.compute_next_result(&w->a, p);
+    if(has_solution) {
+      if(!report_solution(w)) {
+        stop_all(s);
+        break;
+      }
+      continue;
+    }
+    if(!p->interrupted)
+      break;
+
+    if(atomic_load(&s->waiting) > 0)
+      donate(w);
+    p->node_limit = p->nodes + s->yield_nodes;
+  }
+
+  p->prefix = NULL;
+  p->prefix_size = 0;
+}
+
+static void*
+work(void* userdata) {
+  worker* w = userdata;
+  task t;
+  while(pop_task(w->s, &t)) {
+    run_task(w, &t);
+    free(t.prefix);
+  }
+  return NULL;
+}
+
+static size_t
+solve(xcc_algorithm* a,
+      xcc_problem* p,
+      xcc_config* cfg,
+      int threads,
+      size_t yield_nodes,
+      bool (*visit)(xcc_problem* p, void* userdata),
+      void* userdata) {
+  assert(threads > 0);
+
+  shared s;
+  memset(&s, 0, sizeof(s));
+  pthread_mutex_init(&s.lock, NULL);
+  pthread_mutex_init(&s.print_lock, NULL);
+  pthread_cond_init(&s.cond, NULL);
+  atomic_init(&s.waiting, 0);
+  atomic_init(&s.stop, false);
+  s.threads = threads;
+  s.yield_nodes = yield_nodes ? yield_nodes : XCC_PARALLEL_YIELD_NODES;
+  s.cfg = cfg;
+  s.visit = visit;
+  s.userdata = userdata;
+
+  // The root task: an empty prefix, i.e. the whole search tree.
+  push_task(&s, NULL, 0);
+
+  worker* workers = calloc(threads, sizeof(worker));
+  for(int i = 0; i < threads; ++i) {
+    workers[i].s = &s;
+    workers[i].a = *a;
+    workers[i].p = xcc_problem_copy(p);
+    pthread_create(&workers[i].thread, NULL, &work, &workers[i]);
+  }
+
+  size_t solutions = 0;
+  for(int i = 0; i < threads; ++i) {
+    pthread_join(workers[i].thread, NULL);
+    solutions += workers[i].solutions;
+    p->nodes += workers[i].p->nodes;
+    p->forced += workers[i].p->forced;
+    xcc_problem_free(workers[i].p, &workers[i].a);
+  }
+  free(workers);
+
+  for(size_t i = 0; i < s.tasks_size; ++i)
+    free(s.tasks[i].prefix);
+  free(s.tasks);
+
+  pthread_cond_destroy(&s.cond);
+  pthread_mutex_destroy(&s.print_lock);
+  pthread_mutex_destroy(&s.lock);
+
+  return solutions;
+}
+
+int
+xcc_solve_problem_parallel_and_print_solutions(struct xcc_algorithm* a,
+                                               struct xcc_problem* p,
+                                               struct xcc_config* cfg) {
+  if(!a->compute_next_result) {
+    err("Algorithm does not support solving!");
+    return EXIT_FAILURE;
+  }
+
+  size_t solutions = solve(a, p, cfg, cfg->threads, 0, NULL, NULL);
+
+  if(cfg->enumerate) {
+    printf("Found %zu solutions!\n", solutions);
+  }
+  if(cfg->verbose)
+    printf("Branches: %zu, forced moves: %zu\n", p->nodes, p->forced);
+
+  return solutions > 0 ? 10 : 20;
+}
+
+size_t
+xcc_count_solutions_parallel(struct xcc_algorithm* a,
+                             struct xcc_problem* p,
+                             int threads) {
+  return solve(a, p, NULL, threads, 0, NULL, NULL);
+}
+
+size_t
+xcc_visit_solutions_parallel(struct xcc_algorithm* a,
+                             struct xcc_problem* p,
+                             int threads,
+                             size_t yield_nodes,
+                             bool (*visit)(struct xcc_problem* p,
+                                           void* userdata),
+                             void* userdata) {
+  return solve(a, p, NULL, threads, yield_nodes, visit, userdata);
+}
@@ -62,7 +62,9 @@ typedef enum xcc_token {
   LESS_THAN,
   GREATER_THAN,
   COLON,
-  SEMICOLON
+  SEMICOLON,
+  EQUALS,
+  DOLLAR
 } xcc_token;
 
 #define GETC(P) P->getc(P)
@@ -86,6 +88,17 @@ isonlydigits(xcc_parser* p) {
   return true;
 }
 
+inline static bool
+isinteger(xcc_parser* p) {
+  size_t i = p->ident[0] == '-' ? 1 : 0;
+  if(i == p->ident_len)
+    return false;
+  for(; i < p->ident_len; ++i)
+    if(p->ident[i] > '9' || p->ident[i] < '0')
+      return false;
+  return true;
+}
+
 static xcc_token
 next(xcc_parser* p) {
   int c = 0;
@@ -111,6 +124,10 @@ next(xcc_parser* p) {
       return SEMICOLON;
     case ':':
       return COLON;
+    case '=':
+      return EQUALS;
+    case '$':
+      return DOLLAR;
     case '[':
       return LBRACK;
     case ']':
@@ -273,6 +290,34 @@ parse(xcc_parser* p) {
           return e;
       }
 
+      // The option ends with its cost and its priority, in any order.
+      while(t == EQUALS || t == DOLLAR) {
+        xcc_token annotation = t;
+        t = next(p);
+        if(annotation == EQUALS) {
+          // At most 10 digits after the sign, so that strtoll cannot
+          // overflow either.
+          if(t != IDENT || !isinteger(p) ||
+             p->ident_len > (size_t)(p->ident[0] == '-') + 10 ||
+             strtoll(p->ident, NULL, 10) > INT32_MAX ||
+             strtoll(p->ident, NULL, 10) < INT32_MIN)
+            return "priority after = must be a number from -2147483648 to "
+                   "2147483647";
+          xcc_set_option_priority(
+            p->p, p->p->option_count + 1, strtoll(p->ident, NULL, 10));
+        } else {
+          // Bounded, so that sums of costs cannot overflow.
+          if(t != IDENT || !isonlydigits(p) || p->ident_len > 10 ||
+             strtoll(p->ident, NULL, 10) > INT32_MAX)
+            return "cost after $ must be a number from 0 to 2147483647";
+          xcc_set_option_cost(
+            p->p, p->p->option_count + 1, strtoll(p->ident, NULL, 10));
+        }
+        t = next(p);
+        if(t != SEMICOLON && t != END && t != EQUALS && t != DOLLAR)
+          return "cost and priority must end the option";
+      }
+
       if(t == SEMICOLON || t == END) {
         if((e = p->a->end_option(p->a, p->p)))
           return e;
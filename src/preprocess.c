@@ -0,0 +1,399 @@
+/*
+    XCCSolve - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <xcc/algorithm.h>
+#include <xcc/ops.h>
+#include <xcc/preprocess.h>
+
+typedef struct reducer {
+  xcc_problem* p;
+
+  // Per item
+  bool* removed;
+  bool* colored;
+  xcc_link* count;
+
+  bool* member;
+
+  // Per option, by the index it has in solutions
+  bool* gone;
+
+  // Probing stops at this processor time, unless it is 0.
+  clock_t deadline;
+
+  // Plain primary items of Algorithm M may be covered any number of times.
+  bool m;
+
+  xcc_preprocess_stats stats;
+} reducer;
+
+// Number of options primary item i needs at least, 1 without multiplicities.
+// Algorithm M never covers plain items (BOUND 0 and SLACK 1), so they need
+// none.
+static inline xcc_link
+need(const reducer* r, xcc_link i) {
+  xcc_problem* p = r->p;
+  if(BOUND(i))
+    return BOUND(i) - SLACK(i);
+  return r->m ? 0 : 1;
+}
+
+// Whether item j stays active after an option with it is selected, like in
+// Algorithm M.
+static inline bool
+multiple(const reducer* r, xcc_link j) {
+  xcc_problem* p = r->p;
+  return j <= p->N_1 && (BOUND(j) > 1 || (r->m && BOUND(j) == 0));
+}
+
+static inline size_t
+options_removed(const reducer* r) {
+  return r->stats.blocked_options + r->stats.dominated_options +
+         r->stats.secondary_options;
+}
+
+static bool
+contains(xcc_problem* p, xcc_link x, xcc_link i) {
+  while(TOP(x - 1) > 0)
+    --x;
+  for(; TOP(x) > 0; ++x)
+    if(TOP(x) == i)
+      return true;
+  return false;
+}
+
+// Unlinks all nodes of the option of node x from their items for good.
+static void
+remove_option(reducer* r, xcc_link x) {
+  xcc_problem* p = r->p;
+  while(TOP(x - 1) > 0)
+    --x;
+  for(; TOP(x) > 0; ++x) {
+    xcc_link u = ULINK(x), d = DLINK(x), j = TOP(x);
+    DLINK(u) = d;
+    ULINK(d) = u;
+    LEN(j) = LEN(j) - 1;
+    if(j <= p->N_1 && LEN(j) < need(r, j))
+      r->stats.unsatisfiable = true;
+  }
+  r->gone[-TOP(x)] = true;
+}
+
+static void
+count_items(reducer* r, xcc_link i, xcc_link add) {
+  xcc_problem* p = r->p;
+  for(xcc_link x = DLINK(i); x != i; x = DLINK(x)) {
+    for(xcc_link q = x + 1; q != x;) {
+      if(TOP(q) <= 0) {
+        q = ULINK(q);
+      } else {
+        r->count[TOP(q)] += add;
+        ++q;
+      }
+    }
+  }
+}
+
+static void
+remove_secondary_options(reducer* r) {
+  xcc_problem* p = r->p;
+  xcc_link first = p->N + 2;
+  for(xcc_link x = first; x <= p->Z; ++x) {
+    if(TOP(x) > 0)
+      continue;
+    bool primary = false;
+    for(xcc_link y = first; y < x; ++y)
+      primary = primary || TOP(y) <= p->N_1;
+    if(!primary && first < x && !r->gone[-TOP(x)]) {
+      remove_option(r, first);
+      ++r->stats.secondary_options;
+    }
+    first = x + 1;
+  }
+}
+
+// Every option of primary item i contains the items that occur in as many of
+// its options as LEN(i). Such an item j is covered whenever i is, so options
+// with j but without i are never selected and j itself is redundant.
+static void
+remove_implied(reducer* r, xcc_link i) {
+  xcc_problem* p = r->p;
+  if(LEN(i) == 0)
+    return;
+  count_items(r, i, 1);
+
+  // Candidates occur in every option, so in the first one too.
+  xcc_link first = DLINK(i);
+  for(xcc_link q = first + 1; q != first;) {
+    xcc_link j = TOP(q);
+    if(j <= 0) {
+      q = ULINK(q);
+      continue;
+    }
+    ++q;
+    if(r->count[j] != LEN(i) || r->removed[j] || r->colored[j])
+      continue;
+    for(xcc_link x = DLINK(j), next; x != j; x = next) {
+      next = DLINK(x);
+      if(!contains(p, x, i)) {
+        remove_option(r, x);
+        ++r->stats.dominated_options;
+      }
+    }
+    r->removed[j] = true;
+    ++r->stats.removed_items;
+  }
+
+  count_items(r, i, -1);
+}
+
+// Selects the option starting at node x tentatively and checks whether some
+// primary item is left with fewer options than it needs. The option is taken
+// out of its items, which are then committed like Algorithm C does, except for
+// items that may be covered again.
+static bool
+fails(reducer* r, xcc_link x) {
+  xcc_problem* p = r->p;
+  xcc_link end = x;
+  for(; TOP(end) > 0; ++end) {
+    xcc_link u = ULINK(end), d = DLINK(end);
+    DLINK(u) = d;
+    ULINK(d) = u;
+    LEN(TOP(end)) = LEN(TOP(end)) - 1;
+    r->member[TOP(end)] = true;
+  }
+  for(xcc_link q = x; q < end; ++q)
+    if(!multiple(r, TOP(q)))
+      COMMIT(q, TOP(q));
+
+  // The option itself counts for the items it leaves active.
+  bool failed = false;
+  for(xcc_link k = RLINK(0); k != 0 && !failed; k = RLINK(k))
+    failed = LEN(k) + r->member[k] < need(r, k);
+
+  for(xcc_link q = end - 1; q >= x; --q)
+    if(!multiple(r, TOP(q)))
+      UNCOMMIT(q, TOP(q));
+  for(xcc_link q = end - 1; q >= x; --q) {
+    xcc_link u = ULINK(q), d = DLINK(q);
+    DLINK(u) = q;
+    ULINK(d) = q;
+    LEN(TOP(q)) = LEN(TOP(q)) + 1;
+    r->member[TOP(q)] = false;
+  }
+  return failed;
+}
+
+static void
+remove_blocked(reducer* r) {
+  xcc_problem* p = r->p;
+  xcc_link first = p->N + 2;
+  for(xcc_link x = first; x <= p->Z && !r->stats.unsatisfiable; ++x) {
+    if(TOP(x) > 0)
+      continue;
+    if(r->deadline && clock() >= r->deadline) {
+      r->stats.timed_out = true;
+      return;
+    }
+    if(!r->gone[-TOP(x)]) {
+      ++r->stats.probes;
+      if(fails(r, first)) {
+        remove_option(r, first);
+        ++r->stats.blocked_options;
+      }
+    }
+    first = x + 1;
+  }
+}
+
+// Constructs the problem without the removed items and options and moves it
+// into p. Spacers keep the original option indices.
+static const char*
+rebuild(xcc_algorithm* a, xcc_problem* p, reducer* r) {
+  const char* e;
+  xcc_link* renamed = r->count;
+  xcc_problem* q = xcc_problem_allocate();
+  if((e = xcc_default_init_problem(a, q)))
+    goto ERROR;
+
+  for(xcc_link j = 1; j <= p->N; ++j) {
+    if(r->removed[j])
+      continue;
+    renamed[j] = xcc_insert_ident_as_name(q, NAME(j));
+    if(j <= p->N_1 && BOUND(j) != 0)
+      e = a->define_primary_item_with_range(
+        a, q, renamed[j], BOUND(j) - SLACK(j), BOUND(j));
+    else if(j <= p->N_1)
+      e = a->define_primary_item(a, q, renamed[j]);
+    else
+      e = a->define_secondary_item(a, q, renamed[j]);
+    if(e)
+      goto ERROR;
+  }
+  for(size_t c = 1; c < p->color_name_size; ++c)
+    xcc_color_from_ident_or_insert(q, p->color_name[c]);
+
+  if((e = a->prepare_options(a, q)))
+    goto ERROR;
+
+  xcc_link first = p->N + 2;
+  for(xcc_link x = first; x <= p->Z; ++x) {
+    if(TOP(x) > 0)
+      continue;
+    if(!r->gone[-TOP(x)]) {
+      for(xcc_link y = first; y < x; ++y) {
+        if(r->removed[TOP(y)])
+          continue;
+        if((e = a->add_item_with_color(a, q, renamed[TOP(y)], COLOR(y))))
+          goto ERROR;
+      }
+      if((e = a->end_option(a, q)))
+        goto ERROR;
+      q->node[q->p].top = TOP(x);
+    }
+    first = x + 1;
+  }
+  q->M = p->M;
+  q->option_count = p->option_count;
+  // Priorities and costs stay valid, as they are indexed by option index.
+  q->priority = p->priority;
+  q->priority_size = p->priority_size;
+  q->cost = p->cost;
+  q->cost_size = p->cost_size;
+  p->priority = NULL;
+  p->cost = NULL;
+  if((e = a->end_options(a, q)))
+    goto ERROR;
+
+  q->cfg = p->cfg;
+  xcc_problem_free_inner(p, a);
+  memcpy(p, q, sizeof(xcc_problem));
+  free(q);
+  return NULL;
+
+ERROR:
+  xcc_problem_free(q, a);
+  return e;
+}
+
+static void
+init(reducer* r, xcc_problem* p, bool m) {
+  memset(r, 0, sizeof(reducer));
+  r->p = p;
+  r->m = m;
+  r->removed = calloc(p->N + 1, sizeof(bool));
+  r->colored = calloc(p->N + 1, sizeof(bool));
+  r->count = calloc(p->N + 1, sizeof(xcc_link));
+  r->member = calloc(p->N + 1, sizeof(bool));
+  r->gone = calloc(p->M + 1, sizeof(bool));
+
+  for(xcc_link x = p->N + 2; x < p->Z; ++x)
+    if(TOP(x) > 0 && COLOR(x) != 0)
+      r->colored[TOP(x)] = true;
+
+  for(xcc_link i = RLINK(0); i != 0; i = RLINK(i))
+    if(LEN(i) < need(r, i))
+      r->stats.unsatisfiable = true;
+}
+
+static const char*
+finish(xcc_algorithm* a,
+       xcc_problem* p,
+       reducer* r,
+       xcc_preprocess_stats* stats) {
+  const char* e = rebuild(a, p, r);
+
+  free(r->removed);
+  free(r->colored);
+  free(r->count);
+  free(r->member);
+  free(r->gone);
+  if(stats)
+    *stats = r->stats;
+  return e;
+}
+
+const char*
+xcc_preprocess(xcc_algorithm* a,
+               xcc_problem* p,
+               int algorithm,
+               xcc_preprocess_stats* stats) {
+  assert(a);
+  assert(p);
+
+  // Algorithm M covers even plain items any number of times.
+  if(algorithm & XCC_ALGORITHM_M)
+    return "Preprocessing does not support multiplicities!";
+  for(xcc_link i = 1; i <= p->N_1; ++i) {
+    if(BOUND(i) != 0)
+      return "Preprocessing does not support multiplicities!";
+  }
+
+  reducer r;
+  init(&r, p, false);
+  remove_secondary_options(&r);
+
+  // Once some primary item has no options, everything else is blocked.
+  size_t removed;
+  do {
+    removed = options_removed(&r);
+    ++r.stats.rounds;
+    for(xcc_link i = RLINK(0); i != 0 && !r.stats.unsatisfiable; i = RLINK(i))
+      if(!r.removed[i])
+        remove_implied(&r, i);
+    remove_blocked(&r);
+  } while(options_removed(&r) != removed && !r.stats.unsatisfiable);
+
+  for(xcc_link j = p->N_1 + 1; j <= p->N; ++j) {
+    if(LEN(j) == 0 && !r.removed[j]) {
+      r.removed[j] = true;
+      ++r.stats.removed_items;
+    }
+  }
+
+  return finish(a, p, &r, stats);
+}
+
+const char*
+xcc_probe(xcc_algorithm* a,
+          xcc_problem* p,
+          int algorithm,
+          double seconds,
+          xcc_preprocess_stats* stats) {
+  assert(a);
+  assert(p);
+
+  reducer r;
+  init(&r, p, algorithm & XCC_ALGORITHM_M);
+  if(seconds > 0)
+    r.deadline = clock() + (clock_t)(seconds * CLOCKS_PER_SEC);
+
+  size_t removed;
+  do {
+    removed = r.stats.blocked_options;
+    ++r.stats.rounds;
+    remove_blocked(&r);
+  } while(r.stats.blocked_options != removed && !r.stats.unsatisfiable &&
+          !r.stats.timed_out);
+
+  return finish(a, p, &r, stats);
+}
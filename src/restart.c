@@ -0,0 +1,126 @@
+/*
+    XCCSolve - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <xcc/algorithm.h>
+#include <xcc/ops.h>
+#include <xcc/order.h>
+#include <xcc/restart.h>
+#include <xcc/signature.h>
+
+size_t
+xcc_luby(size_t k) {
+  assert(k >= 1);
+  // If k = 2^n - 1, the value is 2^(n - 1). Otherwise, the sequence repeats
+  // from the start after the last such k.
+  while(true) {
+    size_t n = 1;
+    while((((size_t)1 << n) - 1) < k)
+      ++n;
+    if(k == ((size_t)1 << n) - 1)
+      return (size_t)1 << (n - 1);
+    k -= ((size_t)1 << (n - 1)) - 1;
+  }
+}
+
+static void
+shuffle(xcc_link* a, xcc_link n, uint64_t* state) {
+  for(xcc_link k = n - 1; k > 0; --k) {
+    xcc_link r = xcc_xorshift64(state) % (uint64_t)(k + 1);
+    xcc_link t = a[k];
+    a[k] = a[r];
+    a[r] = t;
+  }
+}
+
+void
+xcc_shuffle(xcc_problem* p, uint64_t* state) {
+  assert(*state != 0);
+  xcc_link* buf = malloc((MAX(p->N, p->option_count) + 1) * sizeof(xcc_link));
+
+  xcc_link n = 0;
+  for(xcc_link i = RLINK(0); i != 0; i = RLINK(i))
+    buf[n++] = i;
+  if(n > 1) {
+    shuffle(buf, n, state);
+    xcc_link prev = 0;
+    for(xcc_link k = 0; k < n; ++k) {
+      RLINK(prev) = buf[k];
+      LLINK(buf[k]) = prev;
+      prev = buf[k];
+    }
+    RLINK(prev) = 0;
+    LLINK(0) = prev;
+  }
+
+  for(xcc_link j = 1; j <= p->N; ++j) {
+    n = 0;
+    for(xcc_link x = DLINK(j); x != j; x = DLINK(x))
+      buf[n++] = x;
+    if(n < 2)
+      continue;
+    shuffle(buf, n, state);
+    xcc_relink_column(p, j, buf, n);
+  }
+
+  free(buf);
+}
+
+bool
+xcc_search_with_restarts(xcc_algorithm* a,
+                         xcc_problem* p,
+                         size_t unit,
+                         double growth,
+                         uint64_t seed,
+                         size_t* restarts) {
+  assert(unit > 0);
+  uint64_t state = seed ^ 0x9e3779b97f4a7c15ull;
+  if(state == 0)
+    state = 1;
+
+  *restarts = 0;
+  p->restart = true;
+  p->tail_items = 0;
+  double budget = unit;
+
+  bool found;
+  for(size_t k = 1;; ++k) {
+    size_t limit = unit * xcc_luby(k);
+    if(growth > 1) {
+      limit = budget < (double)(SIZE_MAX / 2) ? (size_t)budget : SIZE_MAX / 2;
+      budget *= growth;
+    }
+    p->node_limit = p->nodes + limit;
+
+    found = a->compute_next_result(a, p);
+    if(found || !p->interrupted)
+      break;
+
+    // The search is back at the root, start over in another order.
+    ++*restarts;
+    p->state = 0;
+    p->fixed = 0;
+    xcc_shuffle(p, &state);
+  }
+
+  p->restart = false;
+  p->node_limit = 0;
+  return found;
+}
@@ -40,6 +40,7 @@ struct xccs*
 xccs_init_x() {
   struct xccs* h = alloc_handle();
   xcc_algorithm_x_set(&h->a);
+  xcc_algorithm_x_specialize(&h->a);
   xcc_default_init_problem(&h->a, &h->p);
   return h;
 }
@@ -48,6 +49,7 @@ struct xccs*
 xccs_init_c() {
   struct xccs* h = alloc_handle();
   xcc_algorithm_c_set(&h->a);
+  xcc_algorithm_c_specialize(&h->a);
   xcc_default_init_problem(&h->a, &h->p);
   return h;
 }
@@ -56,6 +58,7 @@ struct xccs*
 xccs_init_m() {
   struct xccs* h = alloc_handle();
   xcc_algorithm_m_set(&h->a);
+  xcc_algorithm_m_specialize(&h->a);
   xcc_default_init_problem(&h->a, &h->p);
   return h;
 }
@@ -0,0 +1,592 @@
+/*
+    XCCSolve - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <xcc/algorithm.h>
+#include <xcc/ops.h>
+#include <xcc/symmetry.h>
+
+// The bipartite graph of items and live options. Item j is vertex j - 1 and
+// the r-th class of options is vertex N + r. Options with the same items and
+// colors are in the same class, so that swapping them does not multiply the
+// size of the group. Edges are labelled with the color of their node.
+typedef struct graph {
+  uint32_t V;
+  uint32_t N;
+  uint32_t* start;
+  uint32_t* adj;
+  uint32_t* label;
+
+  // The options of class r are option[first[r]] to option[first[r + 1] - 1].
+  uint32_t* first;
+  xcc_link* option;
+} graph;
+
+typedef struct key {
+  uint32_t color;
+  uint32_t v;
+  uint64_t hash;
+} key;
+
+typedef struct searcher {
+  xcc_problem* p;
+  xcc_symmetry* s;
+  graph g;
+
+  uint64_t* pairs;
+  key* keys;
+  uint32_t* mark;
+  uint32_t* mark_label;
+  uint32_t stamp;
+
+  // The path of the first leaf: the cell that is split at every level, the
+  // invariant and number of cells after refining it, and the vertex of every
+  // color at the leaf.
+  uint32_t depth;
+  uint32_t* target;
+  uint64_t* trace;
+  uint32_t* cells;
+  uint32_t* left;
+
+  // Colorings of the current path, one per level.
+  uint32_t* colors;
+  uint32_t* perm;
+  size_t capacity;
+} searcher;
+
+static inline uint64_t
+mix(uint64_t x) {
+  x += 0x9E3779B97F4A7C15ull;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+  return x ^ (x >> 31);
+}
+
+static int
+compare_u64(const void* a, const void* b) {
+  uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+  return (x > y) - (x < y);
+}
+
+static int
+compare_keys(const void* a, const void* b) {
+  const key* x = a;
+  const key* y = b;
+  if(x->color != y->color)
+    return (x->color > y->color) - (x->color < y->color);
+  return (x->hash > y->hash) - (x->hash < y->hash);
+}
+
+static int
+compare_links(const void* a, const void* b) {
+  xcc_link x = *(const xcc_link*)a, y = *(const xcc_link*)b;
+  return (x > y) - (x < y);
+}
+
+typedef struct row {
+  uint64_t hash;
+  uint32_t begin;
+  uint32_t end;
+  xcc_link option;
+} row;
+
+static int
+compare_rows(const void* a, const void* b) {
+  const row* x = a;
+  const row* y = b;
+  if(x->hash != y->hash)
+    return (x->hash > y->hash) - (x->hash < y->hash);
+  return (x->option > y->option) - (x->option < y->option);
+}
+
+static bool
+same_row(const uint64_t* pairs, const row* x, const row* y) {
+  return x->end - x->begin == y->end - y->begin &&
+         memcmp(pairs + x->begin,
+                pairs + y->begin,
+                (x->end - x->begin) * sizeof(uint64_t)) == 0;
+}
+
+static void
+build_graph(searcher* r) {
+  xcc_problem* p = r->p;
+  graph* g = &r->g;
+  g->N = p->N;
+
+  // Collect the live options with their sorted items and colors. A live
+  // option is still linked into the column of its first node.
+  uint32_t rows = 0, nodes = 0;
+  for(xcc_link x = p->N + 2; x < p->Z; ++x) {
+    if(TOP(x) > 0 && TOP(x - 1) <= 0 && DLINK(ULINK(x)) == x) {
+      ++rows;
+      for(xcc_link y = x; TOP(y) > 0; ++y)
+        ++nodes;
+    }
+  }
+  row* row_of = malloc((rows + 1) * sizeof(row));
+  uint64_t* pairs = malloc((nodes + 1) * sizeof(uint64_t));
+  uint32_t n = 0, k = 0;
+  for(xcc_link x = p->N + 2; x < p->Z; ++x) {
+    if(TOP(x) > 0 && TOP(x - 1) <= 0 && DLINK(ULINK(x)) == x) {
+      row* o = &row_of[k++];
+      o->begin = n;
+      xcc_link y = x;
+      for(; TOP(y) > 0; ++y)
+        pairs[n++] = (uint64_t)TOP(y) << 32 | (uint32_t)COLOR(y);
+      o->end = n;
+      o->option = -TOP(y);
+      qsort(pairs + o->begin, n - o->begin, sizeof(uint64_t), &compare_u64);
+      o->hash = mix(n - o->begin);
+      for(uint32_t e = o->begin; e < n; ++e)
+        o->hash = mix(o->hash ^ pairs[e]);
+    }
+  }
+
+  // Sorting by hash brings equal options together, sorted by their index.
+  // Options with colliding hashes are told apart by comparing them.
+  qsort(row_of, rows, sizeof(row), &compare_rows);
+  g->option = malloc((rows + 1) * sizeof(xcc_link));
+  g->first = malloc((rows + 1) * sizeof(uint32_t));
+  bool* done = calloc(rows + 1, sizeof(bool));
+  row** class_of = malloc((rows + 1) * sizeof(row*));
+  uint32_t classes = 0, options = 0;
+  for(uint32_t a = 0; a < rows; ++a) {
+    if(done[a])
+      continue;
+    class_of[classes] = &row_of[a];
+    g->first[classes++] = options;
+    for(uint32_t b = a; b < rows && row_of[b].hash == row_of[a].hash; ++b) {
+      if(!done[b] && same_row(pairs, &row_of[a], &row_of[b])) {
+        done[b] = true;
+        g->option[options++] = row_of[b].option;
+      }
+    }
+  }
+  g->first[classes] = options;
+
+  g->V = g->N + classes;
+  g->start = calloc(g->V + 1, sizeof(uint32_t));
+  uint32_t edges = 0;
+  for(uint32_t c = 0; c < classes; ++c)
+    edges += 2 * (class_of[c]->end - class_of[c]->begin);
+  g->adj = malloc((edges + 1) * sizeof(uint32_t));
+  g->label = malloc((edges + 1) * sizeof(uint32_t));
+
+  // Count the degrees, then fill the lists from the back.
+  for(uint32_t c = 0; c < classes; ++c) {
+    for(uint32_t e = class_of[c]->begin; e < class_of[c]->end; ++e) {
+      ++g->start[(pairs[e] >> 32) - 1];
+      ++g->start[g->N + c];
+    }
+  }
+  for(uint32_t v = 0; v < g->V; ++v)
+    g->start[v + 1] += g->start[v];
+  for(uint32_t c = 0; c < classes; ++c) {
+    uint32_t o = g->N + c;
+    for(uint32_t e = class_of[c]->begin; e < class_of[c]->end; ++e) {
+      uint32_t i = (pairs[e] >> 32) - 1, color = (uint32_t)pairs[e], d;
+      d = --g->start[i];
+      g->adj[d] = o;
+      g->label[d] = color;
+      d = --g->start[o];
+      g->adj[d] = i;
+      g->label[d] = color;
+    }
+  }
+
+  free(row_of);
+  free(pairs);
+  free(done);
+  free(class_of);
+}
+
+// Splits the cells of the coloring by the colors of the neighbors of their
+// vertices until this changes nothing. Colors are numbered by the sorted
+// signatures of the cells, so the result does not depend on the numbering of
+// the vertices. The returned invariant is equal for colorings that an
+// automorphism maps onto each other.
+static uint64_t
+refine(searcher* r, uint32_t* color, uint32_t* cells) {
+  graph* g = &r->g;
+  uint64_t trace = *cells;
+  while(true) {
+    for(uint32_t v = 0; v < g->V; ++v) {
+      uint32_t d = 0;
+      for(uint32_t e = g->start[v]; e < g->start[v + 1]; ++e)
+        r->pairs[d++] = (uint64_t)color[g->adj[e]] << 32 | g->label[e];
+      qsort(r->pairs, d, sizeof(uint64_t), &compare_u64);
+      uint64_t h = mix(d);
+      for(uint32_t k = 0; k < d; ++k)
+        h = mix(h ^ r->pairs[k]);
+      r->keys[v] = (key){ color[v], v, h };
+    }
+    qsort(r->keys, g->V, sizeof(key), &compare_keys);
+
+    uint32_t n = 0;
+    for(uint32_t k = 0; k < g->V; ++k) {
+      if(k > 0 && compare_keys(&r->keys[k - 1], &r->keys[k]) != 0)
+        ++n;
+      color[r->keys[k].v] = n;
+      trace = mix(trace ^ r->keys[k].hash ^ n);
+    }
+    ++n;
+    if(n == *cells)
+      return trace;
+    *cells = n;
+  }
+}
+
+static uint32_t
+initial_coloring(searcher* r, uint32_t* color) {
+  xcc_problem* p = r->p;
+  graph* g = &r->g;
+  for(uint32_t v = 0; v < g->V; ++v) {
+    uint64_t h;
+    if(v < g->N) {
+      xcc_link i = v + 1;
+      h = i <= p->N_1 ? mix(mix(SLACK(i)) ^ BOUND(i)) : mix(0);
+      color[v] = i <= p->N_1 ? 0 : 1;
+    } else {
+      uint32_t c = v - g->N;
+      h = mix(mix(g->start[v + 1] - g->start[v]) ^
+              (g->first[c + 1] - g->first[c]));
+      color[v] = 2;
+    }
+    r->keys[v] = (key){ color[v], v, h };
+  }
+  qsort(r->keys, g->V, sizeof(key), &compare_keys);
+  uint32_t n = 0;
+  for(uint32_t k = 0; k < g->V; ++k) {
+    if(k > 0 && compare_keys(&r->keys[k - 1], &r->keys[k]) != 0)
+      ++n;
+    color[r->keys[k].v] = n;
+  }
+  return n + 1;
+}
+
+// The smallest cell with more than one vertex, the first of them on ties.
+static uint32_t
+target_cell(searcher* r, const uint32_t* color, uint32_t cells) {
+  graph* g = &r->g;
+  uint32_t* size = r->perm;
+  memset(size, 0, cells * sizeof(uint32_t));
+  for(uint32_t v = 0; v < g->V; ++v)
+    ++size[color[v]];
+  uint32_t best = cells;
+  for(uint32_t c = 0; c < cells; ++c)
+    if(size[c] > 1 && (best == cells || size[c] < size[best]))
+      best = c;
+  return best;
+}
+
+static bool
+is_automorphism(searcher* r, const uint32_t* perm) {
+  graph* g = &r->g;
+  for(uint32_t o = g->N; o < g->V; ++o) {
+    uint32_t img = perm[o];
+    ++r->stamp;
+    for(uint32_t e = g->start[img]; e < g->start[img + 1]; ++e) {
+      r->mark[g->adj[e]] = r->stamp;
+      r->mark_label[g->adj[e]] = g->label[e];
+    }
+    for(uint32_t e = g->start[o]; e < g->start[o + 1]; ++e) {
+      uint32_t i = perm[g->adj[e]];
+      if(r->mark[i] != r->stamp || r->mark_label[i] != g->label[e])
+        return false;
+    }
+  }
+  return true;
+}
+
+static void
+add_automorphism(searcher* r, const uint32_t* perm) {
+  xcc_symmetry* s = r->s;
+  graph* g = &r->g;
+  if(s->order == r->capacity) {
+    r->capacity *= 2;
+    s->image = realloc(s->image, r->capacity * (s->M + 1) * sizeof(xcc_link));
+    s->item_image =
+      realloc(s->item_image, r->capacity * (s->N + 1) * sizeof(xcc_link));
+  }
+  xcc_link* image = s->image + s->order * (s->M + 1);
+  xcc_link* item_image = s->item_image + s->order * (s->N + 1);
+  for(xcc_link o = 0; o <= s->M; ++o)
+    image[o] = o;
+  for(uint32_t v = g->N; v < g->V; ++v) {
+    uint32_t from = g->first[v - g->N], to = g->first[perm[v] - g->N];
+    for(uint32_t k = from; k < g->first[v - g->N + 1]; ++k)
+      image[g->option[k]] = g->option[to + k - from];
+  }
+  item_image[0] = 0;
+  for(uint32_t v = 0; v < g->N; ++v)
+    item_image[v + 1] = perm[v] + 1;
+  ++s->order;
+}
+
+// Tries every vertex of the target cell of each level. A path with the same
+// invariants as the first one ends in a discrete coloring, which maps the
+// first leaf onto this one.
+static void
+search(searcher* r, uint32_t level, uint32_t cells) {
+  xcc_symmetry* s = r->s;
+  graph* g = &r->g;
+  uint32_t* color = r->colors + (size_t)level * g->V;
+
+  if(level == r->depth) {
+    for(uint32_t v = 0; v < g->V; ++v)
+      r->perm[r->left[color[v]]] = v;
+    if(!is_automorphism(r, r->perm))
+      return;
+    if(s->order == XCC_SYMMETRY_MAX_ORDER) {
+      s->gave_up = true;
+      return;
+    }
+    add_automorphism(r, r->perm);
+    return;
+  }
+
+  uint32_t* next = color + g->V;
+  for(uint32_t w = 0; w < g->V && !s->gave_up; ++w) {
+    if(color[w] != r->target[level])
+      continue;
+    if(++s->nodes > XCC_SYMMETRY_MAX_NODES) {
+      s->gave_up = true;
+      return;
+    }
+    memcpy(next, color, g->V * sizeof(uint32_t));
+    next[w] = cells;
+    uint32_t n = cells + 1;
+    if(refine(r, next, &n) == r->trace[level + 1] && n == r->cells[level + 1])
+      search(r, level + 1, n);
+  }
+}
+
+const char*
+xcc_symmetry_detect(xcc_problem* p, xcc_symmetry* s) {
+  assert(p);
+  assert(s);
+  memset(s, 0, sizeof(xcc_symmetry));
+  s->M = p->M;
+  s->N = p->N;
+
+  searcher r;
+  memset(&r, 0, sizeof(r));
+  r.p = p;
+  r.s = s;
+  build_graph(&r);
+  graph* g = &r.g;
+
+  uint32_t degree = 0;
+  for(uint32_t v = 0; v < g->V; ++v)
+    if(g->start[v + 1] - g->start[v] > degree)
+      degree = g->start[v + 1] - g->start[v];
+  r.pairs = malloc((degree + 1) * sizeof(uint64_t));
+  r.keys = malloc((g->V + 1) * sizeof(key));
+  r.mark = calloc(g->V + 1, sizeof(uint32_t));
+  r.mark_label = calloc(g->V + 1, sizeof(uint32_t));
+  r.perm = malloc((g->V + 1) * sizeof(uint32_t));
+  r.left = malloc((g->V + 1) * sizeof(uint32_t));
+
+  // Every level splits off one vertex, so there are at most V of them.
+  r.target = malloc((g->V + 1) * sizeof(uint32_t));
+  r.trace = malloc((g->V + 1) * sizeof(uint64_t));
+  r.cells = malloc((g->V + 1) * sizeof(uint32_t));
+
+  // Follow the first vertex of the target cells down to the first leaf.
+  uint32_t* color = malloc((g->V + 1) * sizeof(uint32_t));
+  uint32_t cells = initial_coloring(&r, color);
+  r.trace[0] = refine(&r, color, &cells);
+  r.cells[0] = cells;
+  r.colors = malloc((g->V + 1) * sizeof(uint32_t));
+  memcpy(r.colors, color, g->V * sizeof(uint32_t));
+  while(cells < g->V) {
+    uint32_t c = target_cell(&r, color, cells);
+    uint32_t v = 0;
+    while(color[v] != c)
+      ++v;
+    r.target[r.depth++] = c;
+    color[v] = cells++;
+    r.trace[r.depth] = refine(&r, color, &cells);
+    r.cells[r.depth] = cells;
+  }
+  for(uint32_t v = 0; v < g->V; ++v)
+    r.left[color[v]] = v;
+  free(color);
+
+  r.colors = realloc(r.colors, (size_t)(r.depth + 1) * g->V * sizeof(uint32_t));
+  r.capacity = 16;
+  s->image = malloc(r.capacity * (s->M + 1) * sizeof(xcc_link));
+  s->item_image = malloc(r.capacity * (s->N + 1) * sizeof(xcc_link));
+  search(&r, 0, r.cells[0]);
+
+  // The first leaf maps onto itself, so the identity comes first.
+  if(s->gave_up || s->order == 0) {
+    uint32_t* identity = r.perm;
+    for(uint32_t v = 0; v < g->V; ++v)
+      identity[v] = v;
+    s->order = 0;
+    add_automorphism(&r, identity);
+  }
+
+  s->sorted = malloc((s->M + 1) * sizeof(xcc_link));
+  s->mapped = malloc((s->M + 1) * sizeof(xcc_link));
+
+  free(g->option);
+  free(g->first);
+  free(g->start);
+  free(g->adj);
+  free(g->label);
+  free(r.pairs);
+  free(r.keys);
+  free(r.mark);
+  free(r.mark_label);
+  free(r.perm);
+  free(r.left);
+  free(r.target);
+  free(r.trace);
+  free(r.cells);
+  free(r.colors);
+  return NULL;
+}
+
+static inline xcc_link
+option_of(xcc_problem* p, xcc_link x) {
+  while(TOP(x) > 0)
+    ++x;
+  return -TOP(x);
+}
+
+static bool
+fixed(xcc_symmetry* s, xcc_link i) {
+  for(size_t k = 0; k < s->order; ++k)
+    if(s->item_image[k * (s->N + 1) + i] != i)
+      return false;
+  return true;
+}
+
+static bool
+colored(xcc_problem* p, xcc_link i) {
+  for(xcc_link x = DLINK(i); x != i; x = DLINK(x))
+    if(COLOR(x) != 0)
+      return true;
+  return false;
+}
+
+// Whether o has the smallest index in its orbit.
+static inline bool
+representative(xcc_symmetry* s, xcc_link o) {
+  for(size_t k = 0; k < s->order; ++k)
+    if(s->image[k * (s->M + 1) + o] < o)
+      return false;
+  return true;
+}
+
+void
+xcc_symmetry_break(xcc_problem* p, xcc_symmetry* s) {
+  s->covers = calloc(s->M + 1, sizeof(bool));
+  if(s->order == 1)
+    return;
+
+  // Restrict the item that loses the most options. A solution has at most one
+  // option of it, and then so have all solutions of its orbit, as the item is
+  // fixed. This holds for uncolored secondary items too, which are not
+  // necessarily covered: these solutions are left alone. Primary items are
+  // preferred, as the search chooses them.
+  size_t best = 0;
+  for(xcc_link i = 1; i <= p->N; ++i) {
+    if(i == p->N_1 + 1 && s->item)
+      break;
+    if(!fixed(s, i) || (i <= p->N_1 ? BOUND(i) != 0 : colored(p, i)))
+      continue;
+    size_t removable = 0;
+    for(xcc_link x = DLINK(i); x != i; x = DLINK(x))
+      removable += !representative(s, option_of(p, x));
+    if(removable > best) {
+      best = removable;
+      s->item = i;
+    }
+  }
+  if(!s->item)
+    return;
+
+  xcc_link i = s->item;
+  for(xcc_link x = DLINK(i), next; x != i; x = next) {
+    next = DLINK(x);
+    xcc_link o = option_of(p, x);
+    if(representative(s, o)) {
+      s->covers[o] = true;
+      continue;
+    }
+    xcc_link y = x;
+    while(TOP(y - 1) > 0)
+      --y;
+    for(; TOP(y) > 0; ++y) {
+      xcc_link u = ULINK(y), d = DLINK(y);
+      DLINK(u) = d;
+      ULINK(d) = u;
+      LEN(TOP(y)) = LEN(TOP(y)) - 1;
+    }
+    ++s->removed_options;
+  }
+}
+
+size_t
+xcc_symmetry_orbit_size(xcc_symmetry* s,
+                        const xcc_link* solution,
+                        xcc_link size) {
+  memcpy(s->sorted, solution, size * sizeof(xcc_link));
+  qsort(s->sorted, size, sizeof(xcc_link), &compare_links);
+
+  // Other solutions of the orbit with the same option of the restricted item
+  // are images under automorphisms that fix this option.
+  xcc_link r = 0;
+  for(xcc_link k = 0; k < size; ++k)
+    if(s->covers && s->covers[s->sorted[k]])
+      r = s->sorted[k];
+
+  size_t stabilizer = 0;
+  for(size_t g = 0; g < s->order; ++g) {
+    const xcc_link* image = s->image + g * (s->M + 1);
+    if(r && image[r] != r)
+      continue;
+    for(xcc_link k = 0; k < size; ++k)
+      s->mapped[k] = image[s->sorted[k]];
+    qsort(s->mapped, size, sizeof(xcc_link), &compare_links);
+    int c = 0;
+    for(xcc_link k = 0; k < size && c == 0; ++k)
+      c = (s->mapped[k] > s->sorted[k]) - (s->mapped[k] < s->sorted[k]);
+    if(c < 0)
+      return 0;
+    if(c == 0)
+      ++stabilizer;
+  }
+  return s->order / stabilizer;
+}
+
+void
+xcc_symmetry_free(xcc_symmetry* s) {
+  free(s->image);
+  free(s->item_image);
+  free(s->covers);
+  free(s->sorted);
+  free(s->mapped);
+  memset(s, 0, sizeof(xcc_symmetry));
+}
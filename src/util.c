@@ -7,6 +7,55 @@
 #include <xcc/util.h>
 #include <xcc/xcc.h>
 
+bool
+xcc_print_solution(struct xcc_problem* p, struct xcc_config* cfg) {
+  if(cfg->print_options) {
+    for(xcc_link o = 0; o < p->l; ++o) {
+      xcc_link o_ = p->x[o];
+
+      // Go back to beginning of option
+      while(TOP(o_ - 1) > 0)
+        --o_;
+
+      // This makes printing prettier. With algorithm M, options may be
+      // empty, as branches are taken to resolve multiplicities. These are
+      // expressed in the solution array, but don't directly correspond to
+      // selected options.
+      if(o_ > p->N && o_ <= p->Z) {
+        while(TOP(o_) > 0) {
+          printf("%s", NAME(TOP(o_)));
+          if(COLOR(TOP(o_)) > 0) {
+            printf(":%s", p->color_name[COLOR(TOP(o_))]);
+          }
+          ++o_;
+
+          if(TOP(o_) > 0)
+            printf(" ");
+        }
+        printf(";\n");
+      }
+    }
+    return true;
+  } else if(cfg->print_x) {
+    for(size_t i = 0; i < p->l; ++i) {
+      printf("%" XCC_PRI_LINK " ", p->x[i]);
+    }
+    printf("\n");
+    return true;
+  } else {
+    xcc_link solution[p->l];
+    xcc_link l = xcc_extract_solution_option_indices(p, solution);
+    if(l > 0) {
+      for(size_t i = 0; i < l; ++i) {
+        printf("%" XCC_PRI_LINK " ", solution[i]);
+      }
+      printf("\n");
+      return true;
+    }
+  }
+  return false;
+}
+
 int
 xcc_solve_problem_and_print_solutions(struct xcc_algorithm* a,
                                       struct xcc_problem* p,
@@ -18,7 +67,7 @@ xcc_solve_problem_and_print_solutions(struct xcc_algorithm* a,
   }
 
   int solution = 0;
-  int nr_of_solutions = 0;
+  size_t nr_of_solutions = 0;
 
   do {
     bool has_solution = a->compute_next_result(a, p);
@@ -33,50 +82,8 @@ xcc_solve_problem_and_print_solutions(struct xcc_algorithm* a,
       ++solution;
       return_code = 10;
 
-      if(cfg->print_options) {
-        ++nr_of_solutions;
-        for(xcc_link o = 0; o < p->l; ++o) {
-          xcc_link o_ = p->x[o];
-
-          // Go back to beginning of option
-          while(TOP(o_ - 1) > 0)
-            --o_;
-
-          // This makes printing prettier. With algorithm M, options may be
-          // empty, as branches are taken to resolve multiplicities. These are
-          // expressed in the solution array, but don't directly correspond to
-          // selected options.
-          if(o_ > p->N && o_ <= p->Z) {
-            while(TOP(o_) > 0) {
-              printf("%s", NAME(TOP(o_)));
-              if(TOP(o_) < p->color_size && COLOR(TOP(o_)) > 0) {
-                printf(":%s", p->color_name[COLOR(TOP(o_))]);
-              }
-              ++o_;
-
-              if(TOP(o_) > 0)
-                printf(" ");
-            }
-            printf(";\n");
-          }
-        }
-      } else if(cfg->print_x) {
+      if(xcc_print_solution(p, cfg))
         ++nr_of_solutions;
-        for(size_t i = 0; i < p->l; ++i) {
-          printf("%d ", p->x[i]);
-        }
-        printf("\n");
-      } else {
-        xcc_link solution[p->l];
-        xcc_link l = xcc_extract_solution_option_indices(p, solution);
-        if(l > 0) {
-          for(size_t i = 0; i < l; ++i) {
-            printf("%d ", solution[i]);
-          }
-          printf("\n");
-          ++nr_of_solutions;
-        }
-      }
     }
     if(cfg->enumerate)
       printf("\n");
@@ -88,8 +95,10 @@ xcc_solve_problem_and_print_solutions(struct xcc_algorithm* a,
   } while(cfg->enumerate);
 
   if(cfg->enumerate) {
-    printf("Found %d solutions!\n", nr_of_solutions);
+    printf("Found %zu solutions!\n", nr_of_solutions);
   }
+  if(cfg->verbose)
+    printf("Branches: %zu, forced moves: %zu\n", p->nodes, p->forced);
 
   return return_code;
 }
@@ -132,7 +141,7 @@ xcc_iterate_solution_options_str(struct xcc_problem* p,
     if(o_ > p->N && o_ <= p->Z) {
       while(TOP(o_) > 0) {
         names[i] = NAME(TOP(o_));
-        if(TOP(o_) < p->color_size && COLOR(TOP(o_)) > 0) {
+        if(COLOR(TOP(o_)) > 0) {
           colors[i] = p->color_name[COLOR(TOP(o_))];
         }
         ++o_;
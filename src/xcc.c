@@ -21,7 +21,9 @@
 #include <string.h>
 
 #include <xcc/algorithm.h>
+#include <xcc/cost.h>
 #include <xcc/log.h>
+#include <xcc/nogood.h>
 #include <xcc/ops.h>
 #include <xcc/xcc.h>
 
@@ -60,14 +62,8 @@ xcc_problem_free_inner(xcc_problem* p, xcc_algorithm* a) {
     free(p->llink);
   if(p->rlink)
     free(p->rlink);
-  if(p->ulink)
-    free(p->ulink);
-  if(p->dlink)
-    free(p->dlink);
-  if(p->top)
-    free(p->top);
-  if(p->color)
-    free(p->color);
+  if(p->node)
+    free(p->node);
   if(p->color_name) {
     for(size_t i = 0; i < p->color_name_size; ++i)
       if(p->color_name[i])
@@ -88,6 +84,18 @@ xcc_problem_free_inner(xcc_problem* p, xcc_algorithm* a) {
     free(p->slack);
   if(p->bound)
     free(p->bound);
+  if(p->bucket)
+    free(p->bucket);
+  if(p->weight)
+    free(p->weight);
+  if(p->priority)
+    free(p->priority);
+  if(p->cost)
+    free(p->cost);
+  if(p->option_node)
+    free(p->option_node);
+  xcc_nogoods_free(p->nogoods);
+  xcc_costs_free(p->costs);
 
   memset(p, 0, sizeof(xcc_problem));
 }
@@ -98,11 +106,104 @@ xcc_problem_free(xcc_problem* p, xcc_algorithm* a) {
   free(p);
 }
 
+#define COPY_ARR(ARR)                                              \
+  if(p->ARR) {                                                     \
+    c->ARR = malloc(p->ARR##_capacity * sizeof(p->ARR[0]));        \
+    memcpy(c->ARR, p->ARR, p->ARR##_capacity * sizeof(p->ARR[0])); \
+  }
+
+#define COPY_NAMES(ARR)                                    \
+  if(p->ARR) {                                             \
+    c->ARR = malloc(p->ARR##_capacity * sizeof(xcc_name)); \
+    for(size_t i = 0; i < p->ARR##_size; ++i)              \
+      c->ARR[i] = p->ARR[i] ? strdup(p->ARR[i]) : NULL;    \
+  }
+
+xcc_problem*
+xcc_problem_copy(const xcc_problem* p) {
+  xcc_problem* c = xcc_problem_allocate();
+  memcpy(c, p, sizeof(xcc_problem));
+
+  COPY_ARR(llink)
+  COPY_ARR(rlink)
+  COPY_ARR(node)
+  COPY_ARR(x)
+  COPY_ARR(ft)
+  COPY_ARR(slack)
+  COPY_ARR(bound)
+  COPY_NAMES(name)
+  COPY_NAMES(color_name)
+
+  c->algorithm_userdata = NULL;
+  c->buckets = false;
+  c->bucket = NULL;
+  c->weight = NULL;
+  c->nogoods = NULL;
+  if(p->priority) {
+    c->priority = malloc(p->priority_size * sizeof(int));
+    memcpy(c->priority, p->priority, p->priority_size * sizeof(int));
+  }
+  c->costs = NULL;
+  c->option_node = NULL;
+  if(p->cost) {
+    c->cost = malloc(p->cost_size * sizeof(int64_t));
+    memcpy(c->cost, p->cost, p->cost_size * sizeof(int64_t));
+  }
+  c->prefix = NULL;
+  c->prefix_size = 0;
+  return c;
+}
+
+#undef COPY_ARR
+#undef COPY_NAMES
+
 xcc_link
 xcc_item_from_ident(xcc_problem* p, const char* ident) {
   return xcc_search_for_name(ident, p->name, p->name_size);
 }
 
+void
+xcc_set_option_priority(xcc_problem* p, xcc_link option, int priority) {
+  if((size_t)option >= p->priority_size) {
+    size_t size = p->priority_size * 2;
+    if(size <= (size_t)option)
+      size = (size_t)option + 1;
+    p->priority = realloc(p->priority, size * sizeof(int));
+    memset(p->priority + p->priority_size,
+           0,
+           (size - p->priority_size) * sizeof(int));
+    p->priority_size = size;
+  }
+  p->priority[option] = priority;
+}
+
+int
+xcc_option_priority(const xcc_problem* p, xcc_link option) {
+  if((size_t)option >= p->priority_size)
+    return 0;
+  return p->priority[option];
+}
+
+void
+xcc_set_option_cost(xcc_problem* p, xcc_link option, int64_t cost) {
+  if((size_t)option >= p->cost_size) {
+    size_t size = p->cost_size * 2;
+    if(size <= (size_t)option)
+      size = (size_t)option + 1;
+    p->cost = realloc(p->cost, size * sizeof(int64_t));
+    memset(p->cost + p->cost_size, 0, (size - p->cost_size) * sizeof(int64_t));
+    p->cost_size = size;
+  }
+  p->cost[option] = cost;
+}
+
+int64_t
+xcc_option_cost(const xcc_problem* p, xcc_link option) {
+  if((size_t)option >= p->cost_size)
+    return 0;
+  return p->cost[option];
+}
+
 xcc_link
 xcc_insert_ident_as_name(xcc_problem* p, const char* ident) {
   xcc_link l = p->name_size;
@@ -132,7 +233,8 @@ xcc_print_problem_matrix(xcc_problem* p) {
   // Print Header first
   for(size_t i = 0; i < p->name_size; ++i) {
     if(i > 0 && i <= p->primary_item_count) {
-      printf("i:%zu\tNAME:%s\tLLINK:%d\tRLINK:%d\tSLACK:%d\tBOUND:%d\n",
+      printf("i:%zu\tNAME:%s\tLLINK:%" XCC_PRI_LINK "\tRLINK:%" XCC_PRI_LINK
+             "\tSLACK:%" XCC_PRI_LINK "\tBOUND:%" XCC_PRI_LINK "\n",
              i,
              p->name[i],
              p->llink[i],
@@ -140,7 +242,8 @@ xcc_print_problem_matrix(xcc_problem* p) {
              p->slack[i],
              p->bound[i]);
     } else {
-      printf("i:%zu\tNAME:%s\tLLINK:%d\tRLINK:%d\n",
+      printf("i:%zu\tNAME:%s\tLLINK:%" XCC_PRI_LINK "\tRLINK:%" XCC_PRI_LINK
+             "\n",
              i,
              p->name[i],
              p->llink[i],
@@ -148,24 +251,26 @@ xcc_print_problem_matrix(xcc_problem* p) {
     }
   }
   printf("\n");
-  for(size_t x = 0; x < p->ulink_size; ++x) {
-    printf("x:%zu\tTOP/LEN:%d\tULINK:%d\tDLINK:%d\n",
+  for(size_t x = 0; x < p->node_size; ++x) {
+    printf("x:%zu\tTOP/LEN:%" XCC_PRI_LINK "\tULINK:%" XCC_PRI_LINK
+           "\tDLINK:%" XCC_PRI_LINK "\n",
            x,
-           p->top[x],
-           p->ulink[x],
-           p->dlink[x]);
+           p->node[x].top,
+           p->node[x].ulink,
+           p->node[x].dlink);
   }
 }
 
 const char*
 xcc_print_problem_matrix_in_libexact_format(xcc_problem* p) {
-  if(p->color_size)
+  // The first color name is the reserved NULL of uncolored nodes.
+  if(p->color_name_size > 1)
     return "Colors not supported in libexact format!";
   if(p->secondary_item_count)
     return "Secondary items not supported in libexact format!";
 
   for(xcc_link i = 1; i <= p->primary_item_count; ++i) {
-    printf("# %s %d\n", NAME(i), i);
+    printf("# %s %" XCC_PRI_LINK "\n", NAME(i), i);
   }
 
   for(size_t i = 1; i <= p->primary_item_count; ++i) {
@@ -176,12 +281,12 @@ xcc_print_problem_matrix_in_libexact_format(xcc_problem* p) {
   }
 
   for(xcc_link i = p->N_1 + 1, option = 0;
-      option < p->option_count && i < p->ulink_size;
+      option < p->option_count && i < p->node_size;
       ++i) {
     if(TOP(i) <= 0)
       ++option;
     else {
-      printf("e %d %d\n", TOP(i), option);
+      printf("e %" XCC_PRI_LINK " %" XCC_PRI_LINK "\n", TOP(i), option);
     }
   }
 
@@ -192,7 +297,7 @@ void
 xcc_print_problem_solution(xcc_problem* p) {
   printf("Solution:\n");
   for(size_t i = 0; i < p->x_size; ++i) {
-    printf("%d ", p->x[i]);
+    printf("%" XCC_PRI_LINK " ", p->x[i]);
   }
   printf("\n");
 }
@@ -0,0 +1,528 @@
+/*
+    XCCSolve - Toolset to solve exact cover problems and extensions
+    Copyright (C) 2021-2023  Maximilian Heisinger
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <xcc/algorithm.h>
+#include <xcc/ops.h>
+#include <xcc/signature.h>
+#include <xcc/zdd.h>
+
+static const char zdd_magic[8] = { 'X', 'C', 'C', 'Z', 'D', 'D', '0', '1' };
+
+#define EMPTY UINT32_MAX
+
+typedef struct memo_entry {
+  uint64_t hash;
+  size_t key;
+  uint32_t node;
+} memo_entry;
+
+typedef struct builder {
+  xcc_problem* p;
+  xcc_zdd* z;
+
+  xcc_signature sig;
+
+  // Sub-problems that were already solved, keyed by their active items.
+  memo_entry* memo;
+  size_t memo_size;
+  size_t memo_capacity;
+  uint64_t* keys;
+  size_t keys_size;
+  size_t keys_capacity;
+
+  // Unique table of the nodes, so that equal nodes are shared.
+  uint32_t* unique;
+  size_t unique_size;
+  size_t unique_capacity;
+
+  const char* error;
+} builder;
+
+static inline uint64_t
+hash_node(uint32_t option, uint32_t lo, uint32_t hi) {
+  uint64_t h = option;
+  h = h * 0x9E3779B97F4A7C15ull + lo;
+  h = h * 0x9E3779B97F4A7C15ull + hi;
+  return h ^ (h >> 29);
+}
+
+static void
+zdd_reserve(xcc_zdd* z, size_t size) {
+  if(size > z->capacity) {
+    z->capacity = size > 2 * z->capacity ? size : 2 * z->capacity;
+    z->nodes = realloc(z->nodes, z->capacity * sizeof(xcc_zdd_node));
+  }
+}
+
+static xcc_zdd*
+zdd_allocate(uint32_t option_count) {
+  xcc_zdd* z = calloc(1, sizeof(xcc_zdd));
+  zdd_reserve(z, 1024);
+  memset(z->nodes, 0, 2 * sizeof(xcc_zdd_node));
+  z->size = 2;
+  z->root = XCC_ZDD_BOTTOM;
+  z->option_count = option_count;
+  return z;
+}
+
+static void
+unique_grow(builder* b) {
+  size_t capacity = b->unique_capacity ? b->unique_capacity * 2 : 1024;
+  uint32_t* unique = calloc(capacity, sizeof(uint32_t));
+  for(size_t i = 0; i < b->unique_capacity; ++i) {
+    uint32_t n = b->unique[i];
+    if(!n)
+      continue;
+    xcc_zdd_node* v = &b->z->nodes[n];
+    size_t s = hash_node(v->option, v->lo, v->hi) & (capacity - 1);
+    while(unique[s])
+      s = (s + 1) & (capacity - 1);
+    unique[s] = n;
+  }
+  free(b->unique);
+  b->unique = unique;
+  b->unique_capacity = capacity;
+}
+
+// Returns the node for lo + {option} x hi, creating it if it does not exist.
+static uint32_t
+make_node(builder* b, uint32_t option, uint32_t lo, uint32_t hi) {
+  if(hi == XCC_ZDD_BOTTOM)
+    return lo;
+
+  if(2 * (b->unique_size + 1) > b->unique_capacity)
+    unique_grow(b);
+
+  xcc_zdd* z = b->z;
+  size_t mask = b->unique_capacity - 1;
+  size_t s = hash_node(option, lo, hi) & mask;
+  for(; b->unique[s]; s = (s + 1) & mask) {
+    xcc_zdd_node* v = &z->nodes[b->unique[s]];
+    if(v->option == option && v->lo == lo && v->hi == hi)
+      return b->unique[s];
+  }
+
+  if(z->size >= EMPTY) {
+    b->error = "ZDD has too many nodes!";
+    return XCC_ZDD_BOTTOM;
+  }
+
+  zdd_reserve(z, z->size + 1);
+  uint32_t n = z->size++;
+  z->nodes[n].option = option;
+  z->nodes[n].lo = lo;
+  z->nodes[n].hi = hi;
+  b->unique[s] = n;
+  ++b->unique_size;
+  return n;
+}
+
+static inline bool
+memo_matches(builder* b, memo_entry* e) {
+  return e->hash == b->sig.hash &&
+         xcc_signature_equals(&b->sig, b->keys + e->key);
+}
+
+static uint32_t
+memo_find(builder* b) {
+  if(!b->memo_capacity)
+    return EMPTY;
+  size_t mask = b->memo_capacity - 1;
+  for(size_t s = b->sig.hash & mask; b->memo[s].node != EMPTY;
+      s = (s + 1) & mask) {
+    if(memo_matches(b, &b->memo[s]))
+      return b->memo[s].node;
+  }
+  return EMPTY;
+}
+
+static void
+memo_grow(builder* b) {
+  size_t capacity = b->memo_capacity ? b->memo_capacity * 2 : 1024;
+  memo_entry* memo = malloc(capacity * sizeof(memo_entry));
+  for(size_t i = 0; i < capacity; ++i)
+    memo[i].node = EMPTY;
+  for(size_t i = 0; i < b->memo_capacity; ++i) {
+    memo_entry* e = &b->memo[i];
+    if(e->node == EMPTY)
+      continue;
+    size_t s = e->hash & (capacity - 1);
+    while(memo[s].node != EMPTY)
+      s = (s + 1) & (capacity - 1);
+    memo[s] = *e;
+  }
+  free(b->memo);
+  b->memo = memo;
+  b->memo_capacity = capacity;
+}
+
+static void
+memo_insert(builder* b, uint32_t node) {
+  if(2 * (b->memo_size + 1) > b->memo_capacity)
+    memo_grow(b);
+
+  size_t words = b->sig.words;
+  if(b->keys_size + words > b->keys_capacity) {
+    b->keys_capacity = b->keys_capacity ? b->keys_capacity * 2 : 1024;
+    while(b->keys_size + words > b->keys_capacity)
+      b->keys_capacity *= 2;
+    b->keys = realloc(b->keys, b->keys_capacity * sizeof(uint64_t));
+  }
+
+  size_t mask = b->memo_capacity - 1;
+  size_t s = b->sig.hash & mask;
+  while(b->memo[s].node != EMPTY)
+    s = (s + 1) & mask;
+
+  memcpy(b->keys + b->keys_size, b->sig.active, words * sizeof(uint64_t));
+  b->memo[s].hash = b->sig.hash;
+  b->memo[s].key = b->keys_size;
+  b->memo[s].node = node;
+  b->keys_size += words;
+  ++b->memo_size;
+}
+
+static inline void
+cover(builder* b, xcc_link i) {
+  xcc_problem* p = b->p;
+  COVER(i);
+  xcc_signature_toggle(&b->sig, i);
+}
+
+static inline void
+uncover(builder* b, xcc_link i) {
+  xcc_problem* p = b->p;
+  UNCOVER(i);
+  xcc_signature_toggle(&b->sig, i);
+}
+
+static uint32_t
+option_of_node(xcc_problem* p, xcc_link x) {
+  while(TOP(x) > 0)
+    ++x;
+  return -TOP(x);
+}
+
+// Returns the ZDD of all solutions of the current sub-problem. Options of the
+// chosen item are tried from the last to the first, so that the lo chain lists
+// them in input order.
+static uint32_t
+build(builder* b) {
+  xcc_problem* p = b->p;
+  if(RLINK(0) == 0)
+    return XCC_ZDD_TOP;
+
+  uint32_t r = memo_find(b);
+  if(r != EMPTY)
+    return r;
+
+  xcc_link i = xcc_choose_mrv(p);
+  r = XCC_ZDD_BOTTOM;
+  if(LEN(i) == 0)
+    return r;
+
+  cover(b, i);
+  for(xcc_link x = ULINK(i); x != i && !b->error; x = ULINK(x)) {
+    for(xcc_link q = x + 1; q != x;) {
+      xcc_link j = TOP(q);
+      if(j <= 0) {
+        q = ULINK(q);
+      } else {
+        cover(b, j);
+        ++q;
+      }
+    }
+
+    uint32_t hi = build(b);
+
+    for(xcc_link q = x - 1; q != x;) {
+      xcc_link j = TOP(q);
+      if(j <= 0) {
+        q = DLINK(q);
+      } else {
+        uncover(b, j);
+        --q;
+      }
+    }
+
+    r = make_node(b, option_of_node(p, x), r, hi);
+  }
+  uncover(b, i);
+
+  memo_insert(b, r);
+  return r;
+}
+
+const char*
+xcc_zdd_build(xcc_problem* p, xcc_zdd** out) {
+  assert(p);
+  assert(out);
+  *out = NULL;
+
+  const char* error = xcc_signature_check(p);
+  if(error)
+    return error;
+
+  builder b;
+  memset(&b, 0, sizeof(b));
+  b.p = p;
+  b.z = zdd_allocate(p->option_count);
+  xcc_signature_init(&b.sig, p->N);
+
+  b.z->root = build(&b);
+
+  xcc_signature_free(&b.sig);
+  free(b.memo);
+  free(b.keys);
+  free(b.unique);
+
+  if(b.error) {
+    xcc_zdd_free(b.z);
+    return b.error;
+  }
+  *out = b.z;
+  return NULL;
+}
+
+void
+xcc_zdd_free(xcc_zdd* z) {
+  if(!z)
+    return;
+  if(z->counts) {
+    for(size_t n = 0; n < z->size; ++n)
+      xcc_bignum_free(&z->counts[n]);
+    free(z->counts);
+  }
+  free(z->jump);
+  free(z->nodes);
+  free(z);
+}
+
+const xcc_bignum*
+xcc_zdd_count(xcc_zdd* z) {
+  if(!z->counts) {
+    z->counts = malloc(z->size * sizeof(xcc_bignum));
+    for(size_t n = 0; n < z->size; ++n)
+      xcc_bignum_init(&z->counts[n]);
+    xcc_bignum_set_u64(&z->counts[XCC_ZDD_TOP], 1);
+    for(size_t n = 2; n < z->size; ++n) {
+      xcc_bignum_set(&z->counts[n], &z->counts[z->nodes[n].lo]);
+      xcc_bignum_add(&z->counts[n], &z->counts[z->nodes[n].hi]);
+    }
+  }
+  return &z->counts[z->root];
+}
+
+void
+xcc_zdd_count_containing(xcc_zdd* z, uint32_t option, xcc_bignum* out) {
+  xcc_zdd_count(z);
+  xcc_bignum_set_u64(out, 0);
+
+  // Number of paths from the root to every node, parents before children.
+  xcc_bignum* paths = malloc((z->root + 1) * sizeof(xcc_bignum));
+  for(size_t n = 0; n <= z->root; ++n)
+    xcc_bignum_init(&paths[n]);
+  xcc_bignum_set_u64(&paths[z->root], 1);
+
+  xcc_bignum product;
+  xcc_bignum_init(&product);
+  for(size_t n = z->root; n >= 2; --n) {
+    if(xcc_bignum_is_zero(&paths[n]))
+      continue;
+    xcc_zdd_node* v = &z->nodes[n];
+    if(v->option == option) {
+      xcc_bignum_mul(&product, &paths[n], &z->counts[v->hi]);
+      xcc_bignum_add(out, &product);
+    }
+    xcc_bignum_add(&paths[v->lo], &paths[n]);
+    xcc_bignum_add(&paths[v->hi], &paths[n]);
+  }
+
+  xcc_bignum_free(&product);
+  for(size_t n = 0; n <= z->root; ++n)
+    xcc_bignum_free(&paths[n]);
+  free(paths);
+}
+
+// Jump pointers along the lo links, which form a forest with the terminals as
+// roots. They are the skew-binary pointers of Myers' random-access lists:
+// every path down the lo links reaches any node on it in a logarithmic
+// number of jumps and steps.
+static void
+compute_jumps(xcc_zdd* z) {
+  uint32_t* depth = malloc(z->size * sizeof(uint32_t));
+  z->jump = malloc(z->size * sizeof(uint32_t));
+  for(uint32_t n = 0; n < z->size; ++n) {
+    if(n <= XCC_ZDD_TOP) {
+      depth[n] = 0;
+      z->jump[n] = n;
+      continue;
+    }
+    uint32_t lo = z->nodes[n].lo;
+    uint32_t j = z->jump[lo];
+    depth[n] = depth[lo] + 1;
+    if(depth[lo] - depth[j] == depth[j] - depth[z->jump[j]])
+      z->jump[n] = z->jump[j];
+    else
+      z->jump[n] = lo;
+  }
+  free(depth);
+}
+
+// Whether the r-th solution below n (lo first) is below its lo child.
+static inline bool
+in_lo(const xcc_zdd* z, const xcc_bignum* r, uint32_t n) {
+  return n > XCC_ZDD_TOP && xcc_bignum_cmp(r, &z->counts[z->nodes[n].lo]) < 0;
+}
+
+size_t
+xcc_zdd_random_solution(xcc_zdd* z, uint64_t* state, uint32_t* options) {
+  assert(*state != 0);
+  const xcc_bignum* count = xcc_zdd_count(z);
+  if(xcc_bignum_is_zero(count))
+    return 0;
+  if(!z->jump)
+    compute_jumps(z);
+
+  // Draw r uniformly from [0, count) by rejection sampling.
+  uint32_t top = count->limbs[count->size - 1];
+  uint32_t mask = UINT32_MAX;
+  while((mask >> 1) >= top)
+    mask >>= 1;
+  xcc_bignum r;
+  xcc_bignum_init(&r);
+  do {
+    xcc_bignum_set(&r, count);
+    for(size_t i = 0; i < r.size; ++i)
+      r.limbs[i] = (uint32_t)xcc_xorshift64(state);
+    r.limbs[r.size - 1] &= mask;
+    while(r.size > 0 && r.limbs[r.size - 1] == 0)
+      --r.size;
+  } while(xcc_bignum_cmp(&r, count) >= 0);
+
+  // Solutions below a node are ordered with the ones of lo first. r stays the
+  // same down the lo links and their counts shrink, so the first node that
+  // takes its hi child is found with the jump pointers. A draw takes time in
+  // the number of options of the solution, times the logarithm of the number
+  // of alternatives at every branch.
+  size_t size = 0;
+  for(uint32_t n = z->root; n > XCC_ZDD_TOP;) {
+    while(in_lo(z, &r, n))
+      n = in_lo(z, &r, z->jump[n]) ? z->jump[n] : z->nodes[n].lo;
+    if(n <= XCC_ZDD_TOP)
+      break;
+    xcc_zdd_node* v = &z->nodes[n];
+    xcc_bignum_sub(&r, &z->counts[v->lo]);
+    options[size++] = v->option;
+    n = v->hi;
+  }
+
+  xcc_bignum_free(&r);
+  return size;
+}
+
+static void
+put32(uint8_t* buf, uint32_t v) {
+  buf[0] = v;
+  buf[1] = v >> 8;
+  buf[2] = v >> 16;
+  buf[3] = v >> 24;
+}
+
+static uint32_t
+get32(const uint8_t* buf) {
+  return (uint32_t)buf[0] | (uint32_t)buf[1] << 8 | (uint32_t)buf[2] << 16 |
+         (uint32_t)buf[3] << 24;
+}
+
+const char*
+xcc_zdd_write(const xcc_zdd* z, const char* path) {
+  FILE* f = fopen(path, "wb");
+  if(!f)
+    return "Could not open ZDD file for writing!";
+
+  uint8_t buf[12];
+  bool ok = fwrite(zdd_magic, sizeof(zdd_magic), 1, f) == 1;
+  put32(buf, z->option_count);
+  put32(buf + 4, z->size);
+  put32(buf + 8, z->root);
+  ok = ok && fwrite(buf, sizeof(buf), 1, f) == 1;
+  for(size_t n = 2; ok && n < z->size; ++n) {
+    put32(buf, z->nodes[n].option);
+    put32(buf + 4, z->nodes[n].lo);
+    put32(buf + 8, z->nodes[n].hi);
+    ok = fwrite(buf, sizeof(buf), 1, f) == 1;
+  }
+
+  if(fclose(f) != 0 || !ok)
+    return "Could not write ZDD file!";
+  return NULL;
+}
+
+const char*
+xcc_zdd_read(const char* path, xcc_zdd** out) {
+  *out = NULL;
+  FILE* f = fopen(path, "rb");
+  if(!f)
+    return "Could not open ZDD file for reading!";
+
+  char magic[sizeof(zdd_magic)];
+  uint8_t buf[12];
+  if(fread(magic, sizeof(magic), 1, f) != 1 ||
+     memcmp(magic, zdd_magic, sizeof(magic)) != 0 ||
+     fread(buf, sizeof(buf), 1, f) != 1) {
+    fclose(f);
+    return "Not a ZDD file!";
+  }
+
+  uint32_t size = get32(buf + 4);
+  uint32_t root = get32(buf + 8);
+  if(size < 2 || root >= size) {
+    fclose(f);
+    return "Invalid ZDD header!";
+  }
+
+  xcc_zdd* z = zdd_allocate(get32(buf));
+  zdd_reserve(z, size);
+  z->root = root;
+  for(; z->size < size; ++z->size) {
+    if(fread(buf, sizeof(buf), 1, f) != 1) {
+      fclose(f);
+      xcc_zdd_free(z);
+      return "ZDD file is truncated!";
+    }
+    xcc_zdd_node* v = &z->nodes[z->size];
+    v->option = get32(buf);
+    v->lo = get32(buf + 4);
+    v->hi = get32(buf + 8);
+    if(v->option == 0 || v->option > z->option_count || v->lo >= z->size ||
+       v->hi >= z->size || v->hi == XCC_ZDD_BOTTOM) {
+      fclose(f);
+      xcc_zdd_free(z);
+      return "Invalid ZDD node!";
+    }
+  }
+
+  fclose(f);
+  *out = z;
+  return NULL;
+}
@@ -175,3 +175,51 @@ TEST_CASE("parse standard colored XCC example") {
   //   xcc_problem_free(p);
   // }
 }
+
+TEST_CASE("parse option priorities") {
+  const char* str = "<a b> a = 3; b = -1; a b;";
+
+  xcc_algorithm algorithm;
+  xcc_algorithm_x_set(&algorithm);
+
+  xcc_problem_ptr p(xcc_parse_problem(&algorithm, str));
+  REQUIRE(p);
+  REQUIRE(p->option_count == 3);
+  REQUIRE(xcc_option_priority(p.get(), 1) == 3);
+  REQUIRE(xcc_option_priority(p.get(), 2) == -1);
+  REQUIRE(xcc_option_priority(p.get(), 3) == 0);
+
+  REQUIRE(!xcc_parse_problem(&algorithm, "<a b> a = b;"));
+  REQUIRE(!xcc_parse_problem(&algorithm, "<a b> a = 1 b;"));
+
+  xcc_problem_ptr bounds(xcc_parse_problem(
+    &algorithm, "<a b> a = 2147483647; b = -2147483648; a b = 0007;"));
+  REQUIRE(bounds);
+  REQUIRE(xcc_option_priority(bounds.get(), 1) == INT32_MAX);
+  REQUIRE(xcc_option_priority(bounds.get(), 2) == INT32_MIN);
+  REQUIRE(xcc_option_priority(bounds.get(), 3) == 7);
+  REQUIRE(!xcc_parse_problem(&algorithm, "<a b> a = 2147483648;"));
+  REQUIRE(!xcc_parse_problem(&algorithm, "<a b> a = -2147483649;"));
+  REQUIRE(!xcc_parse_problem(&algorithm, "<a b> a = 99999999999;"));
+}
+
+TEST_CASE("parse option costs") {
+  const char* str = "<a b> a $ 3; b = 1 $ 7; a b $ 0 = 2; b;";
+
+  xcc_algorithm algorithm;
+  xcc_algorithm_x_set(&algorithm);
+
+  xcc_problem_ptr p(xcc_parse_problem(&algorithm, str));
+  REQUIRE(p);
+  REQUIRE(p->option_count == 4);
+  REQUIRE(xcc_option_cost(p.get(), 1) == 3);
+  REQUIRE(xcc_option_cost(p.get(), 2) == 7);
+  REQUIRE(xcc_option_priority(p.get(), 2) == 1);
+  REQUIRE(xcc_option_cost(p.get(), 3) == 0);
+  REQUIRE(xcc_option_priority(p.get(), 3) == 2);
+  REQUIRE(xcc_option_cost(p.get(), 4) == 0);
+
+  REQUIRE(!xcc_parse_problem(&algorithm, "<a b> a $ -1;"));
+  REQUIRE(!xcc_parse_problem(&algorithm, "<a b> a $ 2147483648;"));
+  REQUIRE(!xcc_parse_problem(&algorithm, "<a b> a $ 1 b;"));
+}
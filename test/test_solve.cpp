@@ -1,12 +1,30 @@
 #include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <string>
 #include <vector>
 
 #include <catch2/catch_test_macros.hpp>
 
 #include <xcc/algorithm.h>
+#include <xcc/algorithm_bitset.h>
+#include <xcc/algorithm_c.h>
+#include <xcc/algorithm_dc.h>
 #include <xcc/algorithm_m.h>
 #include <xcc/algorithm_x.h>
+#include <xcc/assume.h>
+#include <xcc/backbone.h>
+#include <xcc/cost.h>
+#include <xcc/count.h>
+#include <xcc/estimate.h>
+#include <xcc/nogood.h>
+#include <xcc/ops.h>
+#include <xcc/order.h>
+#include <xcc/parallel.h>
 #include <xcc/parse.h>
+#include <xcc/preprocess.h>
+#include <xcc/restart.h>
+#include <xcc/symmetry.h>
 #include <xcc/xcc.h>
 
 TEST_CASE("solve standard XCC example") {
@@ -31,6 +49,1039 @@ TEST_CASE("solve standard XCC example") {
   REQUIRE(solution[2] == 5);
 }
 
+TEST_CASE("solve colored XCC example with dancing cells") {
+  const char* str =
+    "< p q r > [ x y ] p q x y:1; p r x:1 y; p x:2; q x:1; r y:2;";
+
+  xcc_algorithm algorithm;
+  xcc_algorithm_dc_set(&algorithm);
+
+  xcc_problem_ptr p(xcc_parse_problem(&algorithm, str));
+  REQUIRE(p);
+
+  bool has_result = algorithm.compute_next_result(&algorithm, p.get());
+  REQUIRE(has_result);
+
+  std::vector<xcc_link> solution(p->l);
+  xcc_extract_solution_option_indices(p.get(), solution.data());
+  std::sort(solution.begin(), solution.end());
+
+  REQUIRE(solution.size() == 2);
+  REQUIRE(solution[0] == 2);
+  REQUIRE(solution[1] == 4);
+
+  REQUIRE_FALSE(algorithm.compute_next_result(&algorithm, p.get()));
+  algorithm.free_userdata(&algorithm, p.get());
+}
+
+TEST_CASE("solve colored XCC example with bitsets") {
+  const char* str =
+    "< p q r > [ x y ] p q x y:1; p r x:1 y; p x:2; q x:1; r y:2;";
+
+  xcc_algorithm algorithm;
+  xcc_algorithm_bitset_set(&algorithm);
+
+  xcc_problem_ptr p(xcc_parse_problem(&algorithm, str));
+  REQUIRE(p);
+  REQUIRE(xcc_algorithm_bitset_supports(p.get(), true));
+  REQUIRE_FALSE(xcc_algorithm_bitset_supports(p.get(), false));
+
+  bool has_result = algorithm.compute_next_result(&algorithm, p.get());
+  REQUIRE(has_result);
+
+  std::vector<xcc_link> solution(p->l);
+  xcc_extract_solution_option_indices(p.get(), solution.data());
+  std::sort(solution.begin(), solution.end());
+
+  REQUIRE(solution.size() == 2);
+  REQUIRE(solution[0] == 2);
+  REQUIRE(solution[1] == 4);
+
+  REQUIRE_FALSE(algorithm.compute_next_result(&algorithm, p.get()));
+  algorithm.free_userdata(&algorithm, p.get());
+}
+
+static std::vector<std::vector<xcc_link>>
+enumerate_solutions(xcc_algorithm* a, xcc_problem* p, bool step_nodes) {
+  std::vector<std::vector<xcc_link>> solutions;
+  while(true) {
+    if(step_nodes)
+      p->node_limit = p->nodes + 1;
+    if(a->compute_next_result(a, p)) {
+      std::vector<xcc_link> solution(p->l);
+      xcc_extract_solution_option_indices(p, solution.data());
+      solutions.push_back(solution);
+    } else if(!p->interrupted) {
+      break;
+    }
+  }
+  return solutions;
+}
+
+TEST_CASE("finish the search of Algorithms X and C with bitsets") {
+  const char* str = "<a b c d> a b; c d; a c; b d; a; b; c; d; a d; b c;";
+
+  xcc_algorithm algorithm;
+  xcc_algorithm_x_set(&algorithm);
+
+  xcc_problem_ptr p(xcc_parse_problem(&algorithm, str));
+  REQUIRE(p);
+  auto expected = enumerate_solutions(&algorithm, p.get(), false);
+  REQUIRE(expected.size() == 10);
+
+  xcc_problem_ptr q(xcc_parse_problem(&algorithm, str));
+  REQUIRE(q);
+  q->tail_items = 2;
+  REQUIRE(enumerate_solutions(&algorithm, q.get(), true) == expected);
+  algorithm.free_userdata(&algorithm, q.get());
+
+  const char* colored =
+    "< p q r > [ x y ] p q x y:1; p r x:1 y; p x:2; q x:1; r y:2;";
+  xcc_algorithm_c_set(&algorithm);
+  xcc_problem_ptr c(xcc_parse_problem(&algorithm, colored));
+  REQUIRE(c);
+  c->tail_items = 3;
+  auto solutions = enumerate_solutions(&algorithm, c.get(), false);
+  REQUIRE(solutions.size() == 1);
+  std::sort(solutions[0].begin(), solutions[0].end());
+  REQUIRE(solutions[0] == std::vector<xcc_link>{ 2, 4 });
+  algorithm.free_userdata(&algorithm, c.get());
+}
+
+TEST_CASE("X and C only switch to bitsets when asked to") {
+  const char* str = "<a b c d> a b; c d; a c; b d; a; b; c; d; a d; b c;";
+  const int select = XCC_ALGORITHM_X | XCC_ALGORITHM_MRV;
+
+  xcc_algorithm bitset;
+  xcc_algorithm_bitset_set(&bitset);
+
+  xcc_algorithm algorithm;
+  REQUIRE(xcc_algorithm_from_select(select, &algorithm));
+  xcc_problem_ptr p(xcc_parse_problem(&algorithm, str));
+  REQUIRE(p);
+  REQUIRE(algorithm.compute_next_result != bitset.compute_next_result);
+  REQUIRE(p->tail_items == 0);
+  auto expected = enumerate_solutions(&algorithm, p.get(), false);
+
+  xcc_problem_ptr q(xcc_parse_problem(&algorithm, str));
+  REQUIRE(q);
+  xcc_algorithm_use_bitsets(
+    select | XCC_ALGORITHM_NO_BITSET, &algorithm, q.get());
+  REQUIRE(algorithm.compute_next_result != bitset.compute_next_result);
+  xcc_algorithm_use_bitsets(select, &algorithm, q.get());
+  REQUIRE(algorithm.compute_next_result == bitset.compute_next_result);
+  REQUIRE(enumerate_solutions(&algorithm, q.get(), false) == expected);
+  algorithm.free_userdata(&algorithm, q.get());
+}
+
+TEST_CASE("specialized kernels of X and C match the generic ones") {
+  const char* str = "<a b c d> a b; c d; a c; b d; a; b; c; d; a d; b c;";
+  xcc_choose_i heuristics[] = { &xcc_choose_i_naively,
+                                &xcc_choose_i_mrv,
+                                &xcc_choose_i_mrv_slacker };
+
+  for(xcc_choose_i choose_i : heuristics) {
+    for(int engine = 0; engine < 2; ++engine) {
+      xcc_algorithm generic;
+      if(engine == 0)
+        xcc_algorithm_x_set(&generic);
+      else
+        xcc_algorithm_c_set(&generic);
+      generic.choose_i = choose_i;
+
+      xcc_algorithm specialized = generic;
+      if(engine == 0)
+        xcc_algorithm_x_specialize(&specialized);
+      else
+        xcc_algorithm_c_specialize(&specialized);
+      REQUIRE(specialized.compute_next_result != generic.compute_next_result);
+
+      xcc_problem_ptr p(xcc_parse_problem(&generic, str));
+      REQUIRE(p);
+      auto expected = enumerate_solutions(&generic, p.get(), false);
+      REQUIRE(expected.size() == 10);
+
+      // Stepping node by node checks that the kernel can be resumed anywhere.
+      xcc_problem_ptr q(xcc_parse_problem(&specialized, str));
+      REQUIRE(q);
+      REQUIRE(enumerate_solutions(&specialized, q.get(), true) == expected);
+    }
+  }
+}
+
+TEST_CASE("forced options are applied without a node of their own") {
+  // The only options of a and c are forced, only e has to be branched on.
+  const char* strs[] = { "<a b c d e> a b; b c; c d; d; e; e;",
+                         "<a:1 b:1 c:1 d:1 e:1> a b; b c; c d; d; e; e;" };
+
+  for(int engine = 0; engine < 3; ++engine) {
+    xcc_algorithm algorithm;
+    if(engine == 0)
+      xcc_algorithm_x_set(&algorithm);
+    else if(engine == 1)
+      xcc_algorithm_c_set(&algorithm);
+    else
+      xcc_algorithm_m_set(&algorithm);
+
+    xcc_problem_ptr p(xcc_parse_problem(&algorithm, strs[engine == 2]));
+    REQUIRE(p);
+    auto solutions = enumerate_solutions(&algorithm, p.get(), true);
+    for(auto& s : solutions)
+      std::sort(s.begin(), s.end());
+    REQUIRE(solutions == std::vector<std::vector<xcc_link>>{ { 1, 3, 5 },
+                                                             { 1, 3, 6 } });
+    REQUIRE(p->nodes == 1);
+    REQUIRE(p->forced == 2);
+  }
+}
+
+TEST_CASE("weighted MRV finds the same solutions and bumps dead ends") {
+  const char* strs[] = { "<a b c d> a b; c d; a c; b d; a; b; c; d; a d; b c;",
+                         "<a:1 b:1 c:1 d:1> a b; c d; a c; b d; a; b; c; d; "
+                         "a d; b c;" };
+
+  for(int engine = 0; engine < 2; ++engine) {
+    xcc_algorithm mrv;
+    if(engine == 0)
+      xcc_algorithm_c_set(&mrv);
+    else
+      xcc_algorithm_m_set(&mrv);
+    xcc_algorithm weighted = mrv;
+    weighted.choose_i = &xcc_choose_i_weighted;
+
+    xcc_problem_ptr p(xcc_parse_problem(&mrv, strs[engine]));
+    REQUIRE(p);
+    auto expected = enumerate_solutions(&mrv, p.get(), false);
+    REQUIRE(expected.size() == 10);
+    REQUIRE_FALSE(p->weight);
+
+    xcc_problem_ptr q(xcc_parse_problem(&weighted, strs[engine]));
+    REQUIRE(q);
+    auto solutions = enumerate_solutions(&weighted, q.get(), true);
+    for(auto& s : expected)
+      std::sort(s.begin(), s.end());
+    for(auto& s : solutions)
+      std::sort(s.begin(), s.end());
+    std::sort(expected.begin(), expected.end());
+    std::sort(solutions.begin(), solutions.end());
+    REQUIRE(solutions == expected);
+  }
+
+  // Covering a with a b leaves c without options, so c is bumped.
+  xcc_algorithm algorithm;
+  xcc_algorithm_c_set(&algorithm);
+  algorithm.choose_i = &xcc_choose_i_weighted;
+  xcc_problem_ptr p(xcc_parse_problem(&algorithm, "<a b c> a b; b c; a c;"));
+  REQUIRE(p);
+  REQUIRE_FALSE(algorithm.compute_next_result(&algorithm, p.get()));
+  REQUIRE(p->weight);
+  REQUIRE(p->weight[1] == 1);
+  REQUIRE(p->weight[3] > 1);
+}
+
+TEST_CASE("restarts find a first solution and then all others") {
+  const size_t luby[] = { 1, 1, 2, 1, 1, 2, 4, 1, 1, 2, 1, 1, 2, 4, 8, 1 };
+  for(size_t k = 1; k <= 16; ++k)
+    REQUIRE(xcc_luby(k) == luby[k - 1]);
+
+  const char* strs[] = { "<a b c d> a b; c d; a c; b d; a; b; c; d; a d; b c;",
+                         "<a:1 b:1 c:1 d:1> a b; c d; a c; b d; a; b; c; d; "
+                         "a d; b c;" };
+
+  for(int engine = 0; engine < 3; ++engine) {
+    xcc_algorithm algorithm;
+    if(engine == 0)
+      xcc_algorithm_x_set(&algorithm);
+    else if(engine == 1)
+      xcc_algorithm_c_set(&algorithm);
+    else
+      xcc_algorithm_m_set(&algorithm);
+
+    xcc_problem_ptr p(xcc_parse_problem(&algorithm, strs[engine == 2]));
+    REQUIRE(p);
+    auto expected = enumerate_solutions(&algorithm, p.get(), false);
+    REQUIRE(expected.size() == 10);
+
+    // Every run is interrupted after its first branch, until one of them
+    // finds a solution right away.
+    xcc_problem_ptr q(xcc_parse_problem(&algorithm, strs[engine == 2]));
+    REQUIRE(q);
+    size_t restarts;
+    REQUIRE(xcc_search_with_restarts(&algorithm, q.get(), 1, 0, 7, &restarts));
+    REQUIRE(restarts > 0);
+    std::vector<std::vector<xcc_link>> solutions;
+    do {
+      std::vector<xcc_link> solution(q->l);
+      xcc_extract_solution_option_indices(q.get(), solution.data());
+      solutions.push_back(solution);
+    } while(algorithm.compute_next_result(&algorithm, q.get()));
+
+    for(auto& s : expected)
+      std::sort(s.begin(), s.end());
+    for(auto& s : solutions)
+      std::sort(s.begin(), s.end());
+    std::sort(expected.begin(), expected.end());
+    std::sort(solutions.begin(), solutions.end());
+    REQUIRE(solutions == expected);
+  }
+
+  xcc_algorithm algorithm;
+  xcc_algorithm_x_set(&algorithm);
+  xcc_problem_ptr p(xcc_parse_problem(&algorithm, "<a b c> a b; b c; a c;"));
+  REQUIRE(p);
+  size_t restarts;
+  REQUIRE_FALSE(
+    xcc_search_with_restarts(&algorithm, p.get(), 1, 2, 7, &restarts));
+  REQUIRE(restarts > 0);
+}
+
+TEST_CASE("limited discrepancy search finds every solution once") {
+  const char* strs[] = { "<a b c d> a b; c d; a c; b d; a; b; c; d; a d; b c;",
+                         "<a:1 b:1 c:1 d:1> a b; c d; a c; b d; a; b; c; d; "
+                         "a d; b c;",
+                         "<a:1;2 b c:0;1 d> a b; c d; a c; b d; a; b; c; d; "
+                         "a d; b c;" };
+
+  for(int engine = 0; engine < 4; ++engine) {
+    xcc_algorithm algorithm;
+    if(engine == 0)
+      xcc_algorithm_x_set(&algorithm);
+    else if(engine == 1)
+      xcc_algorithm_c_set(&algorithm);
+    else
+      xcc_algorithm_m_set(&algorithm);
+    const char* str = strs[engine < 2 ? 0 : engine - 1];
+
+    xcc_problem_ptr p(xcc_parse_problem(&algorithm, str));
+    REQUIRE(p);
+    auto expected = enumerate_solutions(&algorithm, p.get(), false);
+    REQUIRE(expected.size() >= 10);
+
+    xcc_problem_ptr q(xcc_parse_problem(&algorithm, str));
+    REQUIRE(q);
+    q->lds = true;
+    auto solutions = enumerate_solutions(&algorithm, q.get(), true);
+    REQUIRE(q->discrepancy_limit > 0);
+    REQUIRE(q->discrepancies == 0);
+
+    // The first solution takes the first branch everywhere.
+    REQUIRE(solutions.size() == expected.size());
+    REQUIRE(solutions[0] == expected[0]);
+
+    for(auto& s : expected)
+      std::sort(s.begin(), s.end());
+    for(auto& s : solutions)
+      std::sort(s.begin(), s.end());
+    std::sort(expected.begin(), expected.end());
+    std::sort(solutions.begin(), solutions.end());
+    REQUIRE(solutions == expected);
+  }
+}
+
+// Indices of the options in the list of item j, from top to bottom.
+static std::vector<xcc_link>
+column_options(xcc_problem* p, xcc_link j) {
+  std::vector<xcc_link> options;
+  for(xcc_link x = DLINK(j); x != j; x = DLINK(x)) {
+    xcc_link r = x;
+    while(TOP(r) > 0)
+      ++r;
+    options.push_back(-TOP(r));
+  }
+  return options;
+}
+
+TEST_CASE("option orders sort the lists of the items") {
+  // The options have 3, 2, 4, 3, 2 and 4 conflicts.
+  const char* strs[] = { "<a b c> [ s ] a b; a s:x = 5; b c = -2; c s:x; "
+                         "b = 7; c s:y;",
+                         "<a:1 b:1 c:1> [ s ] a b; a s:x = 5; b c = -2; "
+                         "c s:x; b = 7; c s:y;" };
+  const std::vector<std::vector<xcc_link>> columns[] = {
+    { { 2, 1 }, { 5, 1, 3 }, { 4, 3, 6 }, { 2, 4, 6 } },
+    { { 1, 2 }, { 3, 1, 5 }, { 3, 6, 4 }, { 6, 4, 2 } },
+    { { 2, 1 }, { 5, 1, 3 }, { 4, 6, 3 }, { 2, 4, 6 } }
+  };
+  const xcc_option_order orders[] = { XCC_ORDER_LEAST_CONSTRAINING,
+                                      XCC_ORDER_MOST_CONSTRAINING,
+                                      XCC_ORDER_PRIORITY };
+
+  for(int k = 0; k < 3; ++k) {
+    for(int engine = 0; engine < 2; ++engine) {
+      xcc_algorithm algorithm;
+      if(engine == 0)
+        xcc_algorithm_c_set(&algorithm);
+      else
+        xcc_algorithm_m_set(&algorithm);
+
+      xcc_problem_ptr p(xcc_parse_problem(&algorithm, strs[engine]));
+      REQUIRE(p);
+      auto expected = enumerate_solutions(&algorithm, p.get(), false);
+      REQUIRE(expected.size() == 4);
+
+      xcc_problem_ptr q(xcc_parse_problem(&algorithm, strs[engine]));
+      REQUIRE(q);
+      xcc_order_options(q.get(), orders[k]);
+      for(xcc_link j = 1; j <= 4; ++j)
+        REQUIRE(column_options(q.get(), j) == columns[k][j - 1]);
+
+      auto solutions = enumerate_solutions(&algorithm, q.get(), false);
+      if(orders[k] == XCC_ORDER_PRIORITY)
+        REQUIRE(std::count(solutions[0].begin(), solutions[0].end(), 2));
+
+      for(auto& s : expected)
+        std::sort(s.begin(), s.end());
+      for(auto& s : solutions)
+        std::sort(s.begin(), s.end());
+      std::sort(expected.begin(), expected.end());
+      std::sort(solutions.begin(), solutions.end());
+      REQUIRE(solutions == expected);
+    }
+  }
+}
+
+TEST_CASE("the nogood cache skips sub-problems that failed before") {
+  // Both ways to cover x and y leave q1, q2 and q3, which pairs cannot cover.
+  // With colors, the option that covers all of them needs s:2, so only the
+  // second way has a solution.
+  const char* strs[] = { "<x y q1 q2 q3> x; y; x y; q1 q2; q2 q3; q1 q3;",
+                         "<x y q1 q2 q3> [ s ] x s:1; y; x y s:2; q1 q2; "
+                         "q2 q3; q1 q3; q1 q2 q3 s:2;" };
+
+  for(int engine = 0; engine < 3; ++engine) {
+    for(bool step_nodes : { false, true }) {
+      xcc_algorithm algorithm;
+      if(engine == 0)
+        xcc_algorithm_x_set(&algorithm);
+      else
+        xcc_algorithm_c_set(&algorithm);
+      const char* str = strs[engine < 2 ? 0 : 1];
+
+      xcc_problem_ptr p(xcc_parse_problem(&algorithm, str));
+      REQUIRE(p);
+      auto expected = enumerate_solutions(&algorithm, p.get(), false);
+
+      xcc_problem_ptr q(xcc_parse_problem(&algorithm, str));
+      REQUIRE(q);
+      q->nogoods = xcc_nogoods_create(q.get(), 1 << 20);
+      auto solutions = enumerate_solutions(&algorithm, q.get(), step_nodes);
+      REQUIRE(solutions == expected);
+      if(engine < 2) {
+        REQUIRE(solutions.empty());
+        REQUIRE(q->nogoods->stats.hits == 1);
+        REQUIRE(q->nodes < p->nodes);
+      } else {
+        REQUIRE(solutions.size() == 1);
+        REQUIRE(q->nogoods->stats.hits == 0);
+      }
+    }
+  }
+}
+
+// Sum of the costs of the options of the current solution of p.
+static int64_t
+solution_cost(xcc_problem* p) {
+  std::vector<xcc_link> solution(p->l);
+  xcc_link l = xcc_extract_solution_option_indices(p, solution.data());
+  int64_t cost = 0;
+  for(xcc_link n = 0; n < l; ++n)
+    cost += xcc_option_cost(p, solution[n]);
+  return cost;
+}
+
+TEST_CASE("minimum-cost search finds the cheapest solutions") {
+  // The first problem has solutions of cost 6, 6, 6, 6, 7, 9 and 10, the
+  // second one, with colors, of cost 6, 7 and 9.
+  const char* strs[] = { "<a b c d> a b $ 5; c d $ 5; a $ 1; b $ 1; c $ 2; "
+                         "d $ 2; a c $ 3; b d $ 3;",
+                         "<a b> [ s ] a s:1 $ 1; a s:2 $ 4; b s:2 $ 2; "
+                         "b s:1 $ 6; a b $ 9;" };
+  const std::vector<int64_t> costs[] = { { 6, 6, 6, 6, 7, 9, 10 },
+                                         { 6, 7, 9 } };
+
+  for(int engine = 0; engine < 3; ++engine) {
+    for(bool specialize : { false, true }) {
+      for(size_t k : { 1, 2, 3, 10 }) {
+        xcc_algorithm algorithm;
+        if(engine == 0)
+          xcc_algorithm_x_set(&algorithm);
+        else
+          xcc_algorithm_c_set(&algorithm);
+        if(specialize && engine == 0)
+          xcc_algorithm_x_specialize(&algorithm);
+        else if(specialize)
+          xcc_algorithm_c_specialize(&algorithm);
+        const std::vector<int64_t>& all = costs[engine < 2 ? 0 : 1];
+
+        xcc_problem_ptr p(
+          xcc_parse_problem(&algorithm, strs[engine < 2 ? 0 : 1]));
+        REQUIRE(p);
+        p->costs = xcc_costs_create(p.get(), k);
+        REQUIRE(xcc_search_cheapest(&algorithm, p.get()));
+
+        size_t expected = std::min(k, all.size());
+        REQUIRE(p->costs->best_count == expected);
+        for(size_t n = 0; n < expected; ++n) {
+          REQUIRE(p->costs->best[n].cost == all[n]);
+          xcc_costs_restore(p.get(), n);
+          REQUIRE(solution_cost(p.get()) == all[n]);
+        }
+        if(k == 1)
+          REQUIRE(p->costs->pruned > 0);
+      }
+    }
+  }
+}
+
+TEST_CASE("Monte Carlo estimates match the search tree") {
+  const char* strs[] = { "<a b c d> a b; c d; a c; b d; a; b; c; d; a d; b c;",
+                         "< p q r > [ x y ] p q x y:1; p r x:1 y; p x:2; "
+                         "q x:1; r y:2; p; q; r x:1;",
+                         "<a:1;3 b:0;2 c:1 d:2> a b; a c; b d; a d; c d; a; "
+                         "b; d;" };
+  // Every node of the second kind of problem has two branches, so every
+  // probe sees the whole tree of 7 branches and 8 solutions.
+  const char* uniform[] = { "<a b c> a; a; b; b; c; c;",
+                            "<a b c> a; a; b; b; c; c;",
+                            "<a:1 b:1 c:1> a; a; b; b; c; c;" };
+  const int algorithms[] = { XCC_ALGORITHM_X, XCC_ALGORITHM_C, XCC_ALGORITHM_M };
+
+  for(int engine = 0; engine < 3; ++engine) {
+    xcc_algorithm algorithm;
+    if(engine == 0)
+      xcc_algorithm_x_set(&algorithm);
+    else if(engine == 1)
+      xcc_algorithm_c_set(&algorithm);
+    else
+      xcc_algorithm_m_set(&algorithm);
+
+    xcc_problem_ptr u(xcc_parse_problem(&algorithm, uniform[engine]));
+    REQUIRE(u);
+    xcc_estimate e;
+    xcc_estimate_search(&algorithm, u.get(), algorithms[engine], 10, 1, &e);
+    REQUIRE(e.nodes.mean == 7);
+    REQUIRE(e.nodes.error == 0);
+    REQUIRE(e.solutions.mean == 8);
+    REQUIRE(e.solutions.error == 0);
+    REQUIRE(e.mems.mean > 0);
+
+    xcc_problem_ptr p(xcc_parse_problem(&algorithm, strs[engine]));
+    REQUIRE(p);
+    auto expected = enumerate_solutions(&algorithm, p.get(), false);
+    double nodes = p->nodes;
+
+    // The probes leave the problem as it was.
+    xcc_problem_ptr q(xcc_parse_problem(&algorithm, strs[engine]));
+    REQUIRE(q);
+    xcc_estimate_search(&algorithm, q.get(), algorithms[engine], 20000, 7, &e);
+    REQUIRE(e.probes == 20000);
+    REQUIRE(e.nodes.error > 0);
+    REQUIRE(std::abs(e.nodes.mean - nodes) <= 2 * e.nodes.error);
+    REQUIRE(std::abs(e.solutions.mean - expected.size()) <=
+            2 * e.solutions.error);
+    REQUIRE(enumerate_solutions(&algorithm, q.get(), false) == expected);
+  }
+}
+
+struct assumption_solutions {
+  const xcc_assumptions* as;
+  std::vector<std::vector<xcc_link>> solutions;
+};
+
+static bool
+collect_with_forced(xcc_problem* p, void* userdata) {
+  auto* c = static_cast<assumption_solutions*>(userdata);
+  std::vector<xcc_link> solution(p->l);
+  solution.resize(xcc_extract_solution_option_indices(p, solution.data()));
+  solution.insert(
+    solution.end(), c->as->forced, c->as->forced + c->as->forced_count);
+  std::sort(solution.begin(), solution.end());
+  c->solutions.push_back(solution);
+  return true;
+}
+
+TEST_CASE("solving under assumptions restores the problem") {
+  const char* strs[] = { "<a b c d> a b; c d; a c; b d; a; b; c; d; a d; b c;",
+                         "< p q r > [ x y ] p q x y:1; p r x:1 y; p x:2; "
+                         "q x:1; r y:2; p; q; r x:1;",
+                         "<a:1;3 b:0;2 c:1 d:2> a b; a c; b d; a d; c d; a; "
+                         "b; d;",
+                         // M covers the plain items a and c any number of
+                         // times.
+                         "<a b:1;2 c> [ x ] a b; a c x:1; b c; a; c x:2; "
+                         "b x:1;" };
+  const int algorithms[] = {
+    XCC_ALGORITHM_X, XCC_ALGORITHM_C, XCC_ALGORITHM_M, XCC_ALGORITHM_M
+  };
+
+  for(int engine = 0; engine < 4; ++engine) {
+    xcc_algorithm algorithm;
+    if(engine == 0)
+      xcc_algorithm_x_set(&algorithm);
+    else if(engine == 1)
+      xcc_algorithm_c_set(&algorithm);
+    else
+      xcc_algorithm_m_set(&algorithm);
+
+    xcc_problem_ptr p(xcc_parse_problem(&algorithm, strs[engine]));
+    REQUIRE(p);
+    // Levels of M that cover an item no more select no option (0).
+    auto all = enumerate_solutions(&algorithm, p.get(), false);
+    for(auto& s : all) {
+      s.erase(std::remove(s.begin(), s.end(), 0), s.end());
+      std::sort(s.begin(), s.end());
+    }
+    std::sort(all.begin(), all.end());
+    REQUIRE(all.size() > 1);
+
+    xcc_problem_ptr q(xcc_parse_problem(&algorithm, strs[engine]));
+    REQUIRE(q);
+    for(xcc_link o = 1; o <= q->option_count; ++o) {
+      for(bool force : { true, false }) {
+        xcc_assumptions as = {};
+        if(force) {
+          as.forced = &o;
+          as.forced_count = 1;
+        } else {
+          as.excluded = &o;
+          as.excluded_count = 1;
+        }
+        std::vector<std::vector<xcc_link>> expected;
+        for(auto& s : all)
+          if((std::find(s.begin(), s.end(), o) != s.end()) == force)
+            expected.push_back(s);
+
+        assumption_solutions c = { &as, {} };
+        size_t found;
+        REQUIRE_FALSE(xcc_solve_with_assumptions(&algorithm,
+                                                 q.get(),
+                                                 algorithms[engine],
+                                                 &as,
+                                                 0,
+                                                 &collect_with_forced,
+                                                 &c,
+                                                 &found));
+        REQUIRE(found == expected.size());
+        std::sort(c.solutions.begin(), c.solutions.end());
+        REQUIRE(c.solutions == expected);
+
+        // Uniqueness checks stop at the second solution.
+        REQUIRE_FALSE(xcc_solve_with_assumptions(&algorithm,
+                                                 q.get(),
+                                                 algorithms[engine],
+                                                 &as,
+                                                 2,
+                                                 NULL,
+                                                 NULL,
+                                                 &found));
+        REQUIRE(found == std::min<size_t>(expected.size(), 2));
+      }
+    }
+
+    // Pairs of forced options that share an item, or a secondary item with
+    // another color, contradict each other.
+    for(xcc_link o = 1; o <= q->option_count; ++o) {
+      for(xcc_link r = o + 1; r <= q->option_count; ++r) {
+        const xcc_link forced[] = { o, r };
+        xcc_assumptions as = {};
+        as.forced = forced;
+        as.forced_count = 2;
+        size_t expected = 0, found;
+        for(auto& s : all)
+          expected += std::find(s.begin(), s.end(), o) != s.end() &&
+                      std::find(s.begin(), s.end(), r) != s.end();
+        REQUIRE_FALSE(xcc_solve_with_assumptions(
+          &algorithm, q.get(), algorithms[engine], &as, 0, NULL, NULL, &found));
+        REQUIRE(found == expected);
+      }
+    }
+
+    // Forcing an option twice is the same as forcing it once.
+    for(xcc_link o = 1; o <= q->option_count; ++o) {
+      const xcc_link twice[] = { o, o };
+      xcc_assumptions as = {};
+      as.forced = twice;
+      as.forced_count = 2;
+      size_t expected = 0, found;
+      for(auto& s : all)
+        expected += std::find(s.begin(), s.end(), o) != s.end();
+      REQUIRE_FALSE(xcc_solve_with_assumptions(
+        &algorithm, q.get(), algorithms[engine], &as, 0, NULL, NULL, &found));
+      REQUIRE(found == expected);
+    }
+
+    // Forcing and excluding an option contradicts.
+    const xcc_link first = 1;
+    xcc_assumptions as = {};
+    as.forced = &first;
+    as.forced_count = 1;
+    as.excluded = &first;
+    as.excluded_count = 1;
+    size_t found;
+    REQUIRE_FALSE(xcc_solve_with_assumptions(
+      &algorithm, q.get(), algorithms[engine], &as, 0, NULL, NULL, &found));
+    REQUIRE(found == 0);
+
+    const xcc_link out_of_range = q->option_count + 1;
+    as.excluded = &out_of_range;
+    REQUIRE(xcc_solve_with_assumptions(
+      &algorithm, q.get(), algorithms[engine], &as, 0, NULL, NULL, &found));
+
+    auto solutions = enumerate_solutions(&algorithm, q.get(), false);
+    for(auto& s : solutions) {
+      s.erase(std::remove(s.begin(), s.end(), 0), s.end());
+      std::sort(s.begin(), s.end());
+    }
+    std::sort(solutions.begin(), solutions.end());
+    REQUIRE(solutions == all);
+  }
+
+  // Excluding item a excludes the options a b, a c, a and a d, which leaves
+  // only c d; b; c; d; b c to cover b, c and d, so a has no option left.
+  xcc_algorithm algorithm;
+  xcc_algorithm_x_set(&algorithm);
+  xcc_problem_ptr p(xcc_parse_problem(&algorithm, strs[0]));
+  REQUIRE(p);
+  const xcc_link a = 1;
+  xcc_assumptions as = {};
+  as.excluded_items = &a;
+  as.excluded_item_count = 1;
+  size_t found;
+  REQUIRE_FALSE(xcc_solve_with_assumptions(
+    &algorithm, p.get(), XCC_ALGORITHM_X, &as, 0, NULL, NULL, &found));
+  REQUIRE(found == 0);
+  REQUIRE(enumerate_solutions(&algorithm, p.get(), false).size() == 10);
+}
+
+TEST_CASE("backbones classify every option by the solutions it is in") {
+  // Every solution of the first problem contains e x, and none a x or b c x.
+  // The second has no solution with p q x y:1, and the last none at all.
+  const char* strs[] = { "<a b c d e> [x] a b; c d; a c; b d; a; b; c; d; "
+                         "e x; a x; b c x;",
+                         "< p q r > [ x y ] p q x y:1; p r x:1 y; p x:2; "
+                         "q x:1; r y:2; q; r x:2;",
+                         "<a:1;3 b:0;2 c:1 d:2> a b; a c; b d; a d; c d; a; "
+                         "b; d;",
+                         "<a b c> a b; b c; a c;",
+                         // c is a plain item, which M covers any number of
+                         // times. Option 5 is only found by forcing it.
+                         "< a:1 b:1 c d:1 > d b; c d; b; b a; c d a; a c; c;" };
+  const int algorithms[] = { XCC_ALGORITHM_X,
+                             XCC_ALGORITHM_C,
+                             XCC_ALGORITHM_M,
+                             XCC_ALGORITHM_X,
+                             XCC_ALGORITHM_M };
+
+  for(int n = 0; n < 5; ++n) {
+    xcc_algorithm algorithm;
+    if(algorithms[n] == XCC_ALGORITHM_X)
+      xcc_algorithm_x_set(&algorithm);
+    else if(algorithms[n] == XCC_ALGORITHM_C)
+      xcc_algorithm_c_set(&algorithm);
+    else
+      xcc_algorithm_m_set(&algorithm);
+
+    xcc_problem_ptr p(xcc_parse_problem(&algorithm, strs[n]));
+    REQUIRE(p);
+    auto all = enumerate_solutions(&algorithm, p.get(), false);
+    REQUIRE((all.size() > 1) == (n != 3));
+
+    std::vector<uint8_t> expected(p->option_count + 1, XCC_BACKBONE_NONE);
+    for(xcc_link o = 1; o <= p->option_count; ++o) {
+      size_t in = 0;
+      for(auto& s : all)
+        in += std::find(s.begin(), s.end(), o) != s.end();
+      if(in)
+        expected[o] = in == all.size() ? XCC_BACKBONE_ALL : XCC_BACKBONE_SOME;
+    }
+    if(n == 0)
+      REQUIRE(expected[9] == XCC_BACKBONE_ALL);
+    if(n < 2)
+      REQUIRE(std::count(expected.begin(), expected.end(), XCC_BACKBONE_NONE) >
+              1);
+    if(n == 4)
+      REQUIRE(expected[5] == XCC_BACKBONE_SOME);
+
+    for(int threads : { 1, 3 }) {
+      xcc_problem_ptr q(xcc_parse_problem(&algorithm, strs[n]));
+      REQUIRE(q);
+      std::vector<uint8_t> classes(q->option_count + 1);
+      xcc_backbone_stats stats;
+      REQUIRE_FALSE(xcc_backbone(&algorithm,
+                                 q.get(),
+                                 algorithms[n],
+                                 threads,
+                                 classes.data(),
+                                 &stats));
+      REQUIRE(classes == expected);
+      REQUIRE(stats.queries + stats.reused ==
+              (n == 3 ? 1 : 1 + (size_t)q->option_count));
+
+      // The problem can be searched again afterwards.
+      REQUIRE(enumerate_solutions(&algorithm, q.get(), false).size() ==
+              all.size());
+    }
+  }
+}
+
+TEST_CASE("MRV buckets find the same solutions as scanning the items") {
+  // Pairs of items that are covered by one option, or, for the first three
+  // pairs, by two. Any other pair may instead use the one option with the
+  // secondary item s. Choosing it makes the rest of the search forced, so
+  // the buckets are dropped and rebuilt as the search goes up and down.
+  const int pairs = XCC_MRV_BUCKET_ITEMS / 2 + 8;
+  std::string str = "<";
+  for(int i = 0; i < 2 * pairs; ++i)
+    str += " i" + std::to_string(i);
+  str += " > [ s ]";
+  for(int k = 0; k < pairs; ++k) {
+    std::string a = "i" + std::to_string(2 * k);
+    std::string b = "i" + std::to_string(2 * k + 1);
+    str += " " + a + " " + b + ";";
+    if(k < 3)
+      str += " " + a + "; " + b + ";";
+    else
+      str += " " + a + " " + b + " s;";
+  }
+
+  for(int engine = 0; engine < 2; ++engine) {
+    xcc_algorithm scan;
+    if(engine == 0)
+      xcc_algorithm_x_set(&scan);
+    else
+      xcc_algorithm_c_set(&scan);
+
+    xcc_algorithm buckets = scan;
+    if(engine == 0)
+      xcc_algorithm_x_specialize(&buckets);
+    else
+      xcc_algorithm_c_specialize(&buckets);
+
+    xcc_problem_ptr p(xcc_parse_problem(&scan, str.c_str()));
+    REQUIRE(p);
+    auto expected = enumerate_solutions(&scan, p.get(), false);
+    REQUIRE(expected.size() == 8 * (pairs - 2));
+    REQUIRE_FALSE(p->bucket);
+
+    xcc_problem_ptr q(xcc_parse_problem(&buckets, str.c_str()));
+    REQUIRE(q);
+    auto solutions = enumerate_solutions(&buckets, q.get(), true);
+    REQUIRE(q->bucket);
+
+    for(auto& s : expected)
+      std::sort(s.begin(), s.end());
+    for(auto& s : solutions)
+      std::sort(s.begin(), s.end());
+    std::sort(expected.begin(), expected.end());
+    std::sort(solutions.begin(), solutions.end());
+    REQUIRE(solutions == expected);
+  }
+}
+
+TEST_CASE("preprocessing keeps the solutions and their option indices") {
+  // Option 3 is dominated, as every option of x contains y. Option 7 has no
+  // primary item. Option 8 conflicts with both options of w.
+  const char* str =
+    "< x y z w v > [ s ] x y; x y z; y w; z w; w v; v; s; z v s;";
+
+  for(int engine = 0; engine < 3; ++engine) {
+    xcc_algorithm algorithm;
+    if(engine == 0)
+      xcc_algorithm_x_set(&algorithm);
+    else if(engine == 1)
+      xcc_algorithm_c_set(&algorithm);
+    else
+      xcc_algorithm_dc_set(&algorithm);
+
+    xcc_problem_ptr p(xcc_parse_problem(&algorithm, str));
+    REQUIRE(p);
+
+    int select = engine == 0   ? XCC_ALGORITHM_X
+                 : engine == 1 ? XCC_ALGORITHM_C
+                               : XCC_ALGORITHM_DC;
+    xcc_preprocess_stats stats;
+    REQUIRE(xcc_preprocess(&algorithm, p.get(), select, &stats) == nullptr);
+    REQUIRE(stats.secondary_options == 1);
+    REQUIRE(stats.dominated_options == 1);
+    REQUIRE(stats.blocked_options == 1);
+    REQUIRE(stats.removed_items == 2);
+    REQUIRE_FALSE(stats.unsatisfiable);
+    REQUIRE(p->N == 4);
+
+    auto solutions = enumerate_solutions(&algorithm, p.get(), false);
+    for(auto& s : solutions)
+      std::sort(s.begin(), s.end());
+    std::sort(solutions.begin(), solutions.end());
+    REQUIRE(solutions == std::vector<std::vector<xcc_link>>{ { 1, 4, 6 },
+                                                            { 2, 5 } });
+    if(algorithm.free_userdata)
+      algorithm.free_userdata(&algorithm, p.get());
+  }
+
+  xcc_algorithm algorithm;
+  xcc_algorithm_m_set(&algorithm);
+  const char* ranges = "<a : 2 b : 1;2> a; a b; b;";
+  xcc_problem_ptr m(xcc_parse_problem(&algorithm, ranges));
+  REQUIRE(m);
+  REQUIRE(xcc_preprocess(&algorithm, m.get(), XCC_ALGORITHM_M, nullptr) !=
+          nullptr);
+
+  // Plain items of Algorithm M may be covered any number of times, too.
+  xcc_problem_ptr plain(xcc_parse_problem(&algorithm, "<a b> a; a b; b;"));
+  REQUIRE(plain);
+  REQUIRE(xcc_preprocess(&algorithm, plain.get(), XCC_ALGORITHM_M, nullptr) !=
+          nullptr);
+  auto solutions = enumerate_solutions(&algorithm, plain.get(), false);
+  // Levels that leave a plain item out select option 0.
+  REQUIRE(std::count_if(solutions.begin(), solutions.end(), [](const auto& s) {
+            return std::count(s.begin(), s.end(), 0) != (long)s.size();
+          }) == 7);
+}
+
+TEST_CASE("probing removes options that leave an item without options") {
+  // Options 2 and 3 take the last options of b and a away.
+  const char* str = "<a b c> a b; a c; b c; c;";
+  for(int engine = 0; engine < 3; ++engine) {
+    xcc_algorithm algorithm;
+    if(engine == 0)
+      xcc_algorithm_x_set(&algorithm);
+    else if(engine == 1)
+      xcc_algorithm_c_set(&algorithm);
+    else
+      xcc_algorithm_dc_set(&algorithm);
+
+    xcc_problem_ptr p(xcc_parse_problem(&algorithm, str));
+    REQUIRE(p);
+    xcc_preprocess_stats stats;
+    int select = engine == 0   ? XCC_ALGORITHM_X
+                 : engine == 1 ? XCC_ALGORITHM_C
+                               : XCC_ALGORITHM_DC;
+    REQUIRE(xcc_probe(&algorithm, p.get(), select, 0, &stats) == nullptr);
+    REQUIRE(stats.blocked_options == 2);
+    REQUIRE(stats.rounds == 2);
+    REQUIRE_FALSE(stats.timed_out);
+    REQUIRE_FALSE(stats.unsatisfiable);
+
+    auto solutions = enumerate_solutions(&algorithm, p.get(), false);
+    REQUIRE(solutions.size() == 1);
+    std::sort(solutions[0].begin(), solutions[0].end());
+    REQUIRE(solutions[0] == std::vector<xcc_link>{ 1, 4 });
+    if(algorithm.free_userdata)
+      algorithm.free_userdata(&algorithm, p.get());
+  }
+
+  // a is covered twice. Option 3 leaves it active, but option 4 takes away
+  // all of its options except option 3.
+  xcc_algorithm algorithm;
+  xcc_algorithm_m_set(&algorithm);
+  const char* ranges = "<a : 2 b : 1 c : 1> a b; a c; a; b c;";
+  xcc_problem_ptr m(xcc_parse_problem(&algorithm, ranges));
+  REQUIRE(m);
+  xcc_preprocess_stats stats;
+  REQUIRE(xcc_probe(&algorithm, m.get(), XCC_ALGORITHM_M, 1, &stats) ==
+          nullptr);
+  REQUIRE(stats.blocked_options == 1);
+  REQUIRE(m->N == 3);
+
+  auto solutions = enumerate_solutions(&algorithm, m.get(), false);
+  REQUIRE(solutions.size() == 1);
+  std::sort(solutions[0].begin(), solutions[0].end());
+  REQUIRE(solutions[0] == std::vector<xcc_link>{ 1, 2 });
+
+  // Algorithm M covers plain items any number of times, including never, so
+  // selecting an option does not take the options of its plain items away.
+  const char* plain = "< p0 p1 p2:2;3 p3:2;4 p4:1 > [ s0 s1 s2 ] p2 p0; "
+                      "p3 s1:B s2:B; p1 p0 s0:A s2; p2 p3 s0 s2:B; p2 p4 p1; "
+                      "p1 p4; p4 s0:A s2; p4 p1 p0 s2:B;";
+  xcc_problem_ptr before(xcc_parse_problem(&algorithm, plain));
+  REQUIRE(before);
+  auto expected = enumerate_solutions(&algorithm, before.get(), false);
+  REQUIRE(expected.size() == 4);
+
+  xcc_problem_ptr probed(xcc_parse_problem(&algorithm, plain));
+  REQUIRE(probed);
+  REQUIRE(xcc_probe(&algorithm, probed.get(), XCC_ALGORITHM_M, 0, &stats) ==
+          nullptr);
+  auto found = enumerate_solutions(&algorithm, probed.get(), false);
+  for(auto* s : { &expected, &found }) {
+    for(auto& solution : *s)
+      std::sort(solution.begin(), solution.end());
+    std::sort(s->begin(), s->end());
+  }
+  REQUIRE(found == expected);
+}
+
+TEST_CASE("symmetry breaking finds every orbit of solutions once") {
+  // A wheel: z is joined to the four cells of the cycle a b c d, which are
+  // covered alone or by dominoes. The dihedral group of the square fixes z.
+  const char* wheel =
+    "< z a b c d > z a; z b; z c; z d; a b; b c; c d; d a; a; b; c; d;";
+  // With the options of z last, a solution with a removed option is no longer
+  // mapped to a smaller one, so removed options must stay removed.
+  const char* late =
+    "< z a b c d > a b; b c; c d; d a; a; b; c; d; z a; z b; z c; z d;";
+  // A second domino a b leaves only the symmetries that keep the edge a b.
+  const char* doubled =
+    "< z a b c d > z a; z b; z c; z d; a b; b c; c d; d a; a; b; c; d; a b;";
+
+  // The bitset engine builds its rows at the root, after the options were
+  // removed.
+  for(int engine = 0; engine < 4; ++engine) {
+    for(const char* str : { wheel, late, doubled }) {
+      xcc_algorithm algorithm;
+      if(engine == 0)
+        xcc_algorithm_x_set(&algorithm);
+      else if(engine == 1)
+        xcc_algorithm_c_set(&algorithm);
+      else if(engine == 2)
+        xcc_algorithm_dc_set(&algorithm);
+      else
+        xcc_algorithm_bitset_set(&algorithm);
+
+      xcc_problem_ptr p(xcc_parse_problem(&algorithm, str));
+      REQUIRE(p);
+      size_t all = enumerate_solutions(&algorithm, p.get(), false).size();
+      if(algorithm.free_userdata)
+        algorithm.free_userdata(&algorithm, p.get());
+
+      xcc_problem_ptr q(xcc_parse_problem(&algorithm, str));
+      REQUIRE(q);
+      xcc_symmetry s;
+      REQUIRE(xcc_symmetry_detect(q.get(), &s) == nullptr);
+      REQUIRE_FALSE(s.gave_up);
+      xcc_symmetry_break(q.get(), &s);
+      REQUIRE(s.item == 1);
+
+      std::vector<size_t> orbits;
+      for(auto& solution : enumerate_solutions(&algorithm, q.get(), false)) {
+        size_t orbit = xcc_symmetry_orbit_size(
+          &s, solution.data(), (xcc_link)solution.size());
+        if(orbit)
+          orbits.push_back(orbit);
+      }
+      std::sort(orbits.begin(), orbits.end());
+
+      size_t total = 0;
+      for(size_t orbit : orbits)
+        total += orbit;
+      REQUIRE(total == all);
+      if(str != doubled) {
+        REQUIRE(all == 12);
+        REQUIRE(s.order == 8);
+        REQUIRE(s.removed_options == 3);
+        REQUIRE(orbits == std::vector<size_t>{ 4, 8 });
+      } else {
+        REQUIRE(all == 14);
+        REQUIRE(s.order == 2);
+      }
+
+      xcc_symmetry_free(&s);
+      if(algorithm.free_userdata)
+        algorithm.free_userdata(&algorithm, q.get());
+    }
+  }
+}
+
 TEST_CASE("solve small MCC example") {
   const char* str = "<a : 2 b : 1;2> a; a b; b;";
   xcc_algorithm algorithm;
@@ -56,3 +1107,175 @@ TEST_CASE("solve small MCC example") {
   CAPTURE(solution_unsorted);
   REQUIRE_FALSE(has_duplicates);
 }
+
+#ifdef XCC_PARALLEL_AVAILABLE
+TEST_CASE("count solutions of an XCC example in parallel") {
+  const char* str = "<a b c d> a b; c d; a c; b d; a; b; c; d; a d; b c;";
+
+  xcc_algorithm algorithm;
+  xcc_algorithm_x_set(&algorithm);
+
+  xcc_problem_ptr p(xcc_parse_problem(&algorithm, str));
+  REQUIRE(p);
+
+  size_t sequential = 0;
+  while(algorithm.compute_next_result(&algorithm, p.get()))
+    ++sequential;
+
+  xcc_problem_ptr q(xcc_parse_problem(&algorithm, str));
+  REQUIRE(q);
+
+  REQUIRE(sequential == 10);
+  REQUIRE(xcc_count_solutions_parallel(&algorithm, q.get(), 1) == sequential);
+  REQUIRE(xcc_count_solutions_parallel(&algorithm, q.get(), 4) == sequential);
+}
+
+static bool
+collect_parallel_solution(xcc_problem* p, void* userdata) {
+  auto solutions = static_cast<std::vector<std::vector<xcc_link>>*>(userdata);
+  std::vector<xcc_link> solution(p->l);
+  solution.resize(xcc_extract_solution_option_indices(p, solution.data()));
+  std::sort(solution.begin(), solution.end());
+  solutions->push_back(solution);
+  return true;
+}
+
+TEST_CASE("parallel search splits the tree between workers") {
+  // Partitions of 10 elements into blocks of at most three elements, and
+  // covers of 6 items, each once or twice, by pairs and single items.
+  std::string exact = "<a b c d e f g h i j>", multiple = "<";
+  for(char x = 'a'; x <= 'j'; ++x) {
+    exact += std::string(" ") + x + ";";
+    for(char y = x + 1; y <= 'j'; ++y) {
+      exact += std::string(" ") + x + " " + y + ";";
+      for(char z = y + 1; z <= 'j'; ++z)
+        exact += std::string(" ") + x + " " + y + " " + z + ";";
+    }
+  }
+  for(char x = 'a'; x <= 'f'; ++x)
+    multiple += std::string(" ") + x + ":1;2";
+  multiple += ">";
+  for(char x = 'a'; x <= 'f'; ++x) {
+    multiple += std::string(" ") + x + ";";
+    for(char y = x + 1; y <= 'f'; ++y)
+      multiple += std::string(" ") + x + " " + y + ";";
+  }
+
+  for(bool m : { false, true }) {
+    xcc_algorithm algorithm;
+    if(m)
+      xcc_algorithm_m_set(&algorithm);
+    else
+      xcc_algorithm_x_set(&algorithm);
+    const std::string& str = m ? multiple : exact;
+
+    xcc_problem_ptr p(xcc_parse_problem(&algorithm, str.c_str()));
+    REQUIRE(p);
+    // Levels of M that cover an item no more select no option (0).
+    auto expected = enumerate_solutions(&algorithm, p.get(), false);
+    for(auto& s : expected) {
+      s.erase(std::remove(s.begin(), s.end(), 0), s.end());
+      std::sort(s.begin(), s.end());
+    }
+    std::sort(expected.begin(), expected.end());
+    REQUIRE(expected.size() > 1000);
+    REQUIRE(p->nodes > 10 * XCC_PARALLEL_YIELD_NODES);
+
+    // Checking for idle workers after every node donates work as often as
+    // possible, every donated prefix is replayed by the worker stealing it.
+    for(size_t yield_nodes : { (size_t)1, (size_t)0 }) {
+      xcc_problem_ptr q(xcc_parse_problem(&algorithm, str.c_str()));
+      REQUIRE(q);
+      std::vector<std::vector<xcc_link>> solutions;
+      size_t found = xcc_visit_solutions_parallel(&algorithm,
+                                                  q.get(),
+                                                  4,
+                                                  yield_nodes,
+                                                  &collect_parallel_solution,
+                                                  &solutions);
+      REQUIRE(found == expected.size());
+      std::sort(solutions.begin(), solutions.end());
+      REQUIRE(solutions == expected);
+      REQUIRE(xcc_count_solutions_parallel(&algorithm, q.get(), 4) ==
+              expected.size());
+    }
+  }
+}
+#endif
+
+TEST_CASE("count solutions with a bounded cache of sub-problems") {
+  // Partitions of 8 elements into blocks of at most two elements.
+  std::string str = "<a b c d e f g h>";
+  for(char x = 'a'; x <= 'h'; ++x) {
+    str += std::string(" ") + x + ";";
+    for(char y = x + 1; y <= 'h'; ++y)
+      str += std::string(" ") + x + " " + y + ";";
+  }
+
+  xcc_algorithm algorithm;
+  xcc_algorithm_x_set(&algorithm);
+
+  xcc_problem_ptr p(xcc_parse_problem(&algorithm, str.c_str()));
+  REQUIRE(p);
+
+  // The tiny cache has a single bucket, so entries are evicted all the time.
+  for(size_t cache_bytes : { (size_t)1, (size_t)1 << 20 }) {
+    xcc_bignum count;
+    xcc_bignum_init(&count);
+    xcc_count_stats stats;
+    REQUIRE(xcc_count_solutions_memoized(
+              p.get(), cache_bytes, 0, &count, &stats) == nullptr);
+
+    char* s = xcc_bignum_to_string(&count);
+    REQUIRE(std::string(s) == "764");
+    free(s);
+    xcc_bignum_free(&count);
+
+    REQUIRE(stats.hits > 0);
+    if(cache_bytes == 1)
+      REQUIRE(stats.evictions > 0);
+    else
+      REQUIRE(stats.evictions == 0);
+  }
+}
+
+TEST_CASE("count solutions of independent components separately") {
+  // Blocks of at most two elements in a b c d and in e f g h, joined by the
+  // option d e. Without it, there are 10 * 10 solutions, with it 4 * 4.
+  std::string str = "<a b c d e f g h> d e;";
+  for(const char* part : { "abcd", "efgh" }) {
+    for(const char* x = part; *x; ++x) {
+      str += std::string(" ") + *x + ";";
+      for(const char* y = x + 1; *y; ++y)
+        str += std::string(" ") + *x + " " + *y + ";";
+    }
+  }
+
+  xcc_algorithm algorithm;
+  xcc_algorithm_x_set(&algorithm);
+
+  xcc_problem_ptr p(xcc_parse_problem(&algorithm, str.c_str()));
+  REQUIRE(p);
+
+  for(size_t cache_bytes : { (size_t)1, (size_t)1 << 20 }) {
+    for(size_t depth : { 0, 100 }) {
+      xcc_bignum count;
+      xcc_bignum_init(&count);
+      xcc_count_stats stats;
+      REQUIRE(xcc_count_solutions_memoized(
+                p.get(), cache_bytes, depth, &count, &stats) == nullptr);
+
+      char* s = xcc_bignum_to_string(&count);
+      REQUIRE(std::string(s) == "116");
+      free(s);
+      xcc_bignum_free(&count);
+
+      if(depth == 0) {
+        REQUIRE(stats.splits == 0);
+      } else {
+        REQUIRE(stats.splits > 0);
+        REQUIRE(stats.components >= 2 * stats.splits);
+      }
+    }
+  }
+}
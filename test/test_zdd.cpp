@@ -0,0 +1,177 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <xcc/algorithm.h>
+#include <xcc/algorithm_x.h>
+#include <xcc/bignum.h>
+#include <xcc/parse.h>
+#include <xcc/xcc.h>
+#include <xcc/zdd.h>
+
+static std::string
+to_string(const xcc_bignum* n) {
+  char* s = xcc_bignum_to_string(n);
+  std::string str(s);
+  free(s);
+  return str;
+}
+
+TEST_CASE("print and multiply big numbers") {
+  xcc_bignum a, b, r;
+  xcc_bignum_init(&a);
+  xcc_bignum_init(&b);
+  xcc_bignum_init(&r);
+
+  REQUIRE(to_string(&a) == "0");
+
+  xcc_bignum_set_u64(&a, UINT64_MAX);
+  xcc_bignum_set_u64(&b, UINT64_MAX);
+  xcc_bignum_mul(&r, &a, &b);
+  REQUIRE(to_string(&r) == "340282366920938463426481119284349108225");
+
+  xcc_bignum_add(&r, &a);
+  xcc_bignum_add(&r, &b);
+  xcc_bignum_set_u64(&a, 1);
+  xcc_bignum_add(&r, &a);
+  REQUIRE(to_string(&r) == "340282366920938463463374607431768211456");
+
+  xcc_bignum_sub(&r, &a);
+  REQUIRE(to_string(&r) == "340282366920938463463374607431768211455");
+  REQUIRE(xcc_bignum_cmp(&r, &b) > 0);
+
+  xcc_bignum_free(&a);
+  xcc_bignum_free(&b);
+  xcc_bignum_free(&r);
+}
+
+TEST_CASE("build and query the ZDD of all exact covers") {
+  // All partitions of {a, b, c, d} into blocks of at most two elements.
+  const char* str = "<a b c d> a b; c d; a c; b d; a; b; c; d; a d; b c;";
+
+  xcc_algorithm algorithm;
+  xcc_algorithm_x_set(&algorithm);
+
+  xcc_problem_ptr p(xcc_parse_problem(&algorithm, str));
+  REQUIRE(p);
+
+  xcc_zdd* z;
+  REQUIRE(xcc_zdd_build(p.get(), &z) == nullptr);
+  REQUIRE(to_string(xcc_zdd_count(z)) == "10");
+
+  xcc_bignum n;
+  xcc_bignum_init(&n);
+  xcc_zdd_count_containing(z, 1, &n);
+  REQUIRE(to_string(&n) == "2");
+  xcc_zdd_count_containing(z, 5, &n);
+  REQUIRE(to_string(&n) == "4");
+  xcc_bignum_free(&n);
+
+  // Every sample is an exact cover and every solution is drawn eventually.
+  const char* items[] = { "ab", "cd", "ac", "bd", "a",
+                          "b",  "c",  "d",  "ad", "bc" };
+  std::set<std::vector<uint32_t>> seen;
+  std::vector<uint32_t> options(z->option_count);
+  uint64_t state = 42;
+  for(int i = 0; i < 1000; ++i) {
+    size_t size = xcc_zdd_random_solution(z, &state, options.data());
+    std::string covered;
+    for(size_t j = 0; j < size; ++j)
+      covered += items[options[j] - 1];
+    std::multiset<char> cells(covered.begin(), covered.end());
+    REQUIRE(cells == std::multiset<char>{ 'a', 'b', 'c', 'd' });
+    seen.insert(std::vector<uint32_t>(options.begin(), options.begin() + size));
+  }
+  REQUIRE(seen.size() == 10);
+
+  const char* path = "test_zdd.bin";
+  REQUIRE(xcc_zdd_write(z, path) == nullptr);
+  xcc_zdd* read;
+  REQUIRE(xcc_zdd_read(path, &read) == nullptr);
+  std::remove(path);
+
+  REQUIRE(read->size == z->size);
+  REQUIRE(read->root == z->root);
+  REQUIRE(to_string(xcc_zdd_count(read)) == "10");
+
+  xcc_zdd_free(read);
+  xcc_zdd_free(z);
+}
+
+TEST_CASE("random solutions are drawn uniformly along long lo chains") {
+  // 20 options for a, 20 for b and one for both, so 401 solutions, and the
+  // lo chains of a and b are 20 nodes long.
+  std::string str = "<a b>";
+  for(int i = 0; i < 20; ++i)
+    str += " a; b;";
+  str += " a b;";
+
+  xcc_algorithm algorithm;
+  xcc_algorithm_x_set(&algorithm);
+
+  xcc_problem_ptr p(xcc_parse_problem(&algorithm, str.c_str()));
+  REQUIRE(p);
+
+  xcc_zdd* z;
+  REQUIRE(xcc_zdd_build(p.get(), &z) == nullptr);
+  REQUIRE(to_string(xcc_zdd_count(z)) == "401");
+
+  std::map<std::vector<uint32_t>, int> seen;
+  std::vector<uint32_t> options(z->option_count);
+  uint64_t state = 7;
+  for(int i = 0; i < 40100; ++i) {
+    size_t size = xcc_zdd_random_solution(z, &state, options.data());
+    std::vector<uint32_t> solution(options.begin(), options.begin() + size);
+    std::sort(solution.begin(), solution.end());
+    if(size == 1) {
+      REQUIRE(solution[0] == 41);
+    } else {
+      // An option of a (odd) and one of b (even).
+      REQUIRE(size == 2);
+      REQUIRE((solution[0] + solution[1]) % 2 == 1);
+    }
+    ++seen[solution];
+  }
+  REQUIRE(seen.size() == 401);
+  for(const auto& s : seen) {
+    REQUIRE(s.second > 50);
+    REQUIRE(s.second < 150);
+  }
+  xcc_zdd_free(z);
+}
+
+TEST_CASE("ZDD of a problem without solutions") {
+  const char* str = "<a b c> [d] a b d; b c; c d;";
+
+  xcc_algorithm algorithm;
+  xcc_algorithm_x_set(&algorithm);
+
+  xcc_problem_ptr p(xcc_parse_problem(&algorithm, str));
+  REQUIRE(p);
+
+  xcc_zdd* z;
+  REQUIRE(xcc_zdd_build(p.get(), &z) == nullptr);
+  REQUIRE(z->root == XCC_ZDD_BOTTOM);
+  REQUIRE(xcc_bignum_is_zero(xcc_zdd_count(z)));
+  xcc_zdd_free(z);
+}
+
+TEST_CASE("ZDD construction rejects colors") {
+  const char* str = "<p q> [x] p x:1; q x:2;";
+
+  xcc_algorithm algorithm;
+  xcc_algorithm_x_set(&algorithm);
+
+  xcc_problem_ptr p(xcc_parse_problem(&algorithm, str));
+  REQUIRE(p);
+
+  xcc_zdd* z;
+  REQUIRE(xcc_zdd_build(p.get(), &z) != nullptr);
+  REQUIRE(z == nullptr);
+}